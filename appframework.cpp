@@ -25,13 +25,12 @@
 #include <string.h>
 #include <sstream>
 #include <signal.h>
+#include <poll.h>
 
 #include "dispatchxmscmd.h"
 #include "appframework.h"
 #include "logger.h"
-#include "conference720p.h"
-#include "calls.h"
-#include "confvideoplays.h"
+#include "eventworkers.h"
 
 #include <curl/curl.h>
 #include "XmlDomDocument.h"
@@ -39,6 +38,11 @@
 #include "xmseventparser.h"
 #include "xmsreplyparser.h"
 #include "replycontentcallback.h"
+#include "curlhandlepool.h"
+#include "restdispatcher.h"
+#include "xmsnodepool.h"
+#include "layoutgeometry.h"
+#include "latencystats.h"
 
 /*----------------------------------------------------------------------------*/
 
@@ -46,37 +50,36 @@
 //    std::string
 //    default_appmanager_tcp_port = "15001";
 
-// Global pointers for a single instance of the active call list and video
-// conference play list
-Calls *
-    Calls::pInstance_ = NULL;
-ConfVideoPlays *
-    ConfVideoPlays::pInstance_ = NULL;
-
-// REST service address/port
-extern
-    std::string
-    xmsAddr;
-
 // Flags for process termination, log reset
 extern int
     term;
+extern int
+    term_signal;
 extern int
     log_restart;
+extern int
+    stats_dump;
 
 extern void
 sig_terminate (int signo);
 
-static
-    std::string
-    eventHandlerId;
+__thread uint64_t
+    AppFramework::chunkReceivedUs_ = 0;
+
+// The replay thread, after its last event. Shuts down as SIGTERM would,
+// which lets the workers and the REST dispatcher drain first
+static void
+replayFinished ()
+{
+    sig_terminate (SIGTERM);
+}
 
 /*
  * ctor
  */
 AppFramework::AppFramework ()
 {
-    ;
+    eventHandlerThreads_ = 0;
 }
 
 
@@ -91,7 +94,32 @@ AppFramework::~AppFramework ()
 void *
 AppFramework::eventHandlerThread (void *voidPtr)
 {
-    // A seprate thread that will handle all REST events from XMS
+    // One of these per XMS node. If the node's event handler cannot be
+    // created, or its long poll drops, the node is out of rotation until
+    // a retry gets it back.
+    XmsNode *node = (XmsNode *) voidPtr;
+    XmsNodePool::setCurrentNode (node->index);
+    while (!term)
+    {
+        runEventHandler (node);
+        XmsNodePool::Instance ()->setEventsUp (node->index, false);
+        for (int i = 0; i < EVENT_HANDLER_RETRY_SECS && !term; i++)
+            sleep (1);
+    }
+    return NULL;
+}
+
+int
+AppFramework::abortOnTerm (void *clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
+{
+    // Called about once a second even while the long poll is idle
+    return term ? 1 : 0;
+}
+
+void
+AppFramework::runEventHandler (XmsNode * node)
+{
+    // A seprate thread that will handle all REST events from one XMS
     //
     // What happens here:
     // Initialize cURL subsystem.
@@ -99,32 +127,24 @@ AppFramework::eventHandlerThread (void *voidPtr)
     // With the event handler ID, do a long poll GET on the URL
     // formed with the event handler ID. This GET will remain open
     // for the duration of demo, and incoming events will appear
-    // in the cURL getEventReplyContent callback function. There they
-    // are stuffed in a queue, wehre they are read/processed by the
-    // main thread.
+    // in the cURL longPollReplyContentCallback function. There they
+    // are routed to the event worker that owns their conference.
 
     CURL *curl;
     CURLcode res;
     struct MemoryStruct createEvhandlerReplyContent;
-    struct MemoryStruct getEventReplyContent;
 
 
     // will be grown as needed by realloc above 
     createEvhandlerReplyContent.memory = (char *) malloc (1);
     createEvhandlerReplyContent.size = 0;
 
-    // All incoming events will arrive in this memory buffer
-    getEventReplyContent.memory = (char *) malloc (1);
-    getEventReplyContent.size = 0;
-
-    LOGDEBUG ("Initializing cURL");
-    curl_global_init (CURL_GLOBAL_ALL);
-
+    // cURL global init is done in run(), before this thread starts
     // Set up curl for POST to create event handler
     curl = curl_easy_init ();
     if (curl)
     {
-        std::string evHandlerUrl = "http://" + xmsAddr + "/default/eventhandlers?appid=app";
+        std::string evHandlerUrl = "http://" + node->addr + "/default/eventhandlers?appid=app";
         curl_easy_setopt (curl, CURLOPT_URL, evHandlerUrl.c_str ());
         // Set callback for request
         //curl_easy_setopt (curl, CURLOPT_WRITEFUNCTION, createEvhandlerReplyContentCallback);
@@ -136,6 +156,8 @@ AppFramework::eventHandlerThread (void *voidPtr)
         // some servers don't like requests that are made without a user-agent
         // field, so we provide one 
         curl_easy_setopt (curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+        curl_easy_setopt (curl, CURLOPT_XFERINFOFUNCTION, abortOnTerm);
+        curl_easy_setopt (curl, CURLOPT_NOPROGRESS, 0L);
 
         // Get an event handler from XMS
         LOGDEBUG ("Eventhander POST content is " << createEvhandlerXml ().c_str ());
@@ -148,9 +170,11 @@ AppFramework::eventHandlerThread (void *voidPtr)
         res = curl_easy_perform (curl);
         if (res != CURLE_OK)
         {
-            LOGERROR ("Event handler create - curl_easy_perform() failed: " << curl_easy_strerror (res));
-            sig_terminate (SIGTERM);
-            return NULL;
+            LOGERROR ("Event handler create on " << node->addr << " - curl_easy_perform() failed: " <<
+                      curl_easy_strerror (res));
+            curl_easy_cleanup (curl);
+            free (createEvhandlerReplyContent.memory);
+            return;
         }
         else
         {
@@ -162,31 +186,38 @@ AppFramework::eventHandlerThread (void *voidPtr)
                 LOGDEBUG ("Response code to event handler POST is " << respCode);
                 if (respCode != 201)
                 {
-                    LOGCRIT ("Event handler not available.  Exiting application.");
+                    LOGCRIT ("Event handler not available on " << node->addr);
                     curl_easy_cleanup (curl);
-                    curl_global_cleanup ();
-                    sig_terminate (SIGTERM);
-                    return NULL;
+                    free (createEvhandlerReplyContent.memory);
+                    return;
                 }
             }
 
             // Now, our createEvhandlerReplyContent.memory points to a memory block that is 
             // createEvhandlerReplyContent.size bytes big and contains the reply
             LOGDEBUG ("Event handler create returns " << createEvhandlerReplyContent.memory);
-            std::string createEvhandlerReplyContentString = createEvhandlerReplyContent.memory;
-            xmsReplyParser *parser = new xmsReplyParser (createEvhandlerReplyContentString, createEventhandler);
+            xmsReplyParser *parser = new xmsReplyParser (createEvhandlerReplyContent.memory,
+                                                         createEvhandlerReplyContent.size, createEventhandler);
             //LOGDEBUG("Parsed eventhandler reply is " << eventhandlerHref);
-            std::string evHandlerUrl = "http://" + xmsAddr + parser->getEventhandlerHref () + "?appid=app";
-            eventHandlerId = parser->getEventhandlerId ();
+            std::string evHandlerUrl = "http://" + node->addr + parser->getEventhandlerHref () + "?appid=app";
+            node->eventHandlerId = parser->getEventhandlerId ();
+            XmsNodePool::Instance ()->bind (node->eventHandlerId, node->index, XMS_EVENTHANDLER);
             delete parser;
+            // Done with the create handle; the long poll gets its own
+            curl_easy_cleanup (curl);
 
             LOGDEBUG ("Initiate long-poll GET for eventhandler URL " << evHandlerUrl);
             curl = curl_easy_init ();
             curl_easy_setopt (curl, CURLOPT_URL, evHandlerUrl.c_str ());
+            // All incoming events pass through this framer's fixed buffer
+            EventFramer *framer = new EventFramer (enqueueEvent, (void *) node);
             curl_easy_setopt (curl, CURLOPT_WRITEFUNCTION, longPollReplyContentCallback);
-            curl_easy_setopt (curl, CURLOPT_WRITEDATA, (void *) &getEventReplyContent);
+            curl_easy_setopt (curl, CURLOPT_WRITEDATA, (void *) framer);
             curl_easy_setopt (curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+            curl_easy_setopt (curl, CURLOPT_XFERINFOFUNCTION, abortOnTerm);
+            curl_easy_setopt (curl, CURLOPT_NOPROGRESS, 0L);
             LOGDEBUG ("Entering curl_easy_perform for long poll GET");
+            XmsNodePool::Instance ()->setEventsUp (node->index, true);
             res = curl_easy_perform (curl);
 
             // How can curl be convinced to return from long poll?
@@ -197,52 +228,66 @@ AppFramework::eventHandlerThread (void *voidPtr)
             curl_easy_cleanup (curl);
             if (createEvhandlerReplyContent.memory)
                 free (createEvhandlerReplyContent.memory);
-            if (getEventReplyContent.memory)
-                free (getEventReplyContent.memory);
+            delete framer;
 
-            // we' re done with libcurl, so clean it up 
-            curl_global_cleanup ();
             LOGDEBUG ("Curl cleanup done, exiting");
-            return NULL;
+            return;
         }
     }                           // end if curl not initialized
     LOGCRIT ("Curl cannot be initialized.  Event handler thread.");
-    return NULL;
+    free (createEvhandlerReplyContent.memory);
 }
 
 bool AppFramework::initEventHandlerThread ()
 {
     // All REST client initialization takes place here.
     //
-    // First, a separate thread must be spawned, as an event handler
+    // First, a separate thread must be spawned per XMS, as an event handler
     // It remains open, collecting events.
-    int
-        nothing = 0;
-    if (pthread_create (&evHandlerThread, NULL, eventHandlerThread, (void *) &nothing))
+    XmsNodePool *pool = XmsNodePool::Instance ();
+    for (int index = 0; index < pool->size (); index++)
     {
-        LOGCRIT ("Cannot create event handler thread");
-        return false;
+        XmsNode *node = pool->getNode (index);
+        if (pthread_create (&node->evHandlerThread, NULL, eventHandlerThread, (void *) node))
+        {
+            LOGCRIT ("Cannot create event handler thread for " << node->addr);
+            return false;
+        }
+        eventHandlerThreads_++;
     }
 
-    LOGDEBUG ("Event Handler thread created");
+    LOGDEBUG ("Event Handler threads created");
     return true;
 }
 
+void
+AppFramework::joinEventHandlerThreads ()
+{
+    // Once term is set, each ends within about a second: its transfer is
+    // aborted by abortOnTerm and its retry wait checks term
+    XmsNodePool *pool = XmsNodePool::Instance ();
+    for (int index = 0; index < eventHandlerThreads_; index++)
+        pthread_join (pool->getNode (index)->evHandlerThread, NULL);
+    eventHandlerThreads_ = 0;
+    LOGDEBUG ("Event Handler threads joined");
+}
+
 
 
 // This is the application's top level function, in the main thread
 //
-bool AppFramework::run (const GetOptions & opts, int /*signal_fd */ )
+bool AppFramework::run (const GetOptions & opts, int signal_fd)
 {
-    Conference720p *
-        conf_test_720p;
-    xmsEventParser *
-        curEvent;
-    std::string eventXml;
-
-    // First, get IP address and port for XMS REST connection
+    // First, get IP addresses and port for XMS REST connections. Several
+    // servers may be given, comma separated, each optionally with its own
+    // port: 10.0.0.1,10.0.0.2:8080
     std::string ipAddr = opts.getValue ("ip-address");
     std::string restPort = opts.getValue ("port");
+    // A replay into the sink sends nothing; its node only keeps the books
+    std::string replayFile = opts.getValue ("replay-events");
+    bool sink = !replayFile.empty () && opts.isFound ("replay-sink");
+    if (ipAddr.empty () && sink)
+        ipAddr = "sink";
     if (ipAddr.empty ())
     {
         LOGCRIT ("XMS IP address must be entered");
@@ -250,87 +295,161 @@ bool AppFramework::run (const GetOptions & opts, int /*signal_fd */ )
     }
     if (restPort.empty ())
         restPort = "81";
-    xmsAddr = ipAddr + ":" + restPort;
-    LOGDEBUG ("XMS server's REST connection is at " << xmsAddr);
-    // Handler for REST events from XMS will be run in a 2nd thread
-    if (!initEventHandlerThread ())
+    std::stringstream addrList (ipAddr);
+    std::string addr;
+    while (std::getline (addrList, addr, ','))
+    {
+        if (addr.empty ())
+            continue;
+        if (addr.find (':') == std::string::npos)
+            addr += ":" + restPort;
+        XmsNodePool::Instance ()->addNode (addr);
+    }
+
+    // cURL global init is not thread safe. Do it once here, before the
+    // event handler thread or the REST handle pool make any cURL calls
+    LOGDEBUG ("Initializing cURL");
+    curl_global_init (CURL_GLOBAL_ALL);
+
+    // All REST commands to XMS go out through the dispatcher thread
+    RestDispatcher::Instance ()->setSink (sink);
+    if (!RestDispatcher::Instance ()->start ())
         return false;
 
     std::string dtmf_mode = opts.getValue ("dtmf-mode");
     if (dtmf_mode != "rfc2833" && dtmf_mode != "sipinfo")
         dtmf_mode = "sipinfo";
 
-    // Create the app object
-    conf_test_720p = new Conference720p (dtmf_mode);
+    // Layouts are shared read only by every conference, so they are all
+    // in place before the first worker starts
+    std::string layoutsFile = opts.getValue ("layouts");
+    if (!layoutsFile.empty ())
+    {
+        if (!LayoutTable::Instance ()->load (layoutsFile))
+            return false;
+    }
+    else
+    {
+        LayoutTable::Instance ();
+    }
+
+    // Tracing covers every event, so it starts before any can arrive
+    std::string traceFile = opts.getValue ("trace-file");
+    if (!traceFile.empty () && !EventTrace::Instance ()->open (traceFile))
+        return false;
+
+    std::string recordFile = opts.getValue ("record-events");
+    if (!recordFile.empty () && !replayFile.empty ())
+    {
+        LOGCRIT ("Events can be recorded or replayed, not both");
+        return false;
+    }
+    if (!recordFile.empty () && !EventCapture::Instance ()->openRecording (recordFile))
+        return false;
+    if (!replayFile.empty () && !EventCapture::Instance ()->loadReplay (replayFile))
+        return false;
+
+    // Events are handled on the worker threads, each running its own share
+    // of the conferences. They must be up before the first event arrives
+    int numWorkers = atoi (opts.getValue ("workers").c_str ());
+    if (numWorkers < 1)
+        numWorkers = sysconf (_SC_NPROCESSORS_ONLN);
+    if (!EventWorkers::Instance ()->start (numWorkers, dtmf_mode))
+        return false;
 
-    // Loop on events until a term isgnal is received
-    LOGDEBUG ("Entering event loop in main thread");
+    if (!replayFile.empty ())
+    {
+        // The recording stands in for every node's long poll
+        XmsNodePool *pool = XmsNodePool::Instance ();
+        for (int index = 0; index < pool->size (); index++)
+            pool->setEventsUp (index, true);
+        double speed = opts.isFound ("replay-speed") ? atof (opts.getValue ("replay-speed").c_str ()) : 1;
+        LOGNOTICE ("Replaying " << replayFile << (speed > 0 ? "" : " as fast as possible") <<
+                   (sink ? " into the REST sink" : ""));
+        if (!EventCapture::Instance ()->startReplay (speed, pool->size (), replayFinished))
+            return false;
+    }
+    // Handler for REST events from XMS will be run in a 2nd thread
+    else if (!initEventHandlerThread ())
+    {
+        term = true;
+        joinEventHandlerThreads ();
+        return false;
+    }
+
+    // Nothing left for this thread but signals
+    LOGDEBUG ("Entering signal loop in main thread");
     while (!term)
     {
-        // Block until something in the event handler
-        // Look here:
-        // http://www.dailyfreecode.com/code/solve-producer-consumer-problem-thread-2114.aspx
-
-        // Protected eventQueue access
-        //LOGDEBUG ("Entering protected dequeue section");
-        pthread_mutex_lock (&queueLock);
-        //LOGDEBUG("Event queue has " << eventQueue.size() << " events");
-        pthread_cond_wait (&queueNotEmpty, &queueLock);
-        // When ^C ing out of app after a hangup, wait above is released. If that's
-        // the case, do not further processing and break out of the event loop
-        // and do cleanup before shutting down.
-        if (term)
-            break;
-
-        if (!eventQueue.empty ())
+        struct pollfd signalFd;
+        signalFd.fd = signal_fd;
+        signalFd.events = POLLIN;
+        signalFd.revents = 0;
+        if (poll (&signalFd, 1, 1000) > 0)
         {
-            eventXml = eventQueue.front ();
-            LOGDEBUG ("Event from queue is " << eventXml);
-            eventQueue.pop ();
+            char sig;
+            while (read (signal_fd, &sig, 1) > 0)
+                ;
         }
-        pthread_mutex_unlock (&queueLock);
-        //LOGDEBUG("Out of protected dequeue section");
+
         if (log_restart)
         {
             LOGINFO ("Restarting log file");
             Logger::instance ().restart ();
             log_restart = false;
         }
-        curEvent = new xmsEventParser (eventXml);
-        // Incoming event gets special treatment
-        if (curEvent->getEventType () == "incoming")
-        {
-            std::string call_id = curEvent->findValByKey ("call_id");
-
-            // Create a new 720p conference call object
-            Call
-            conf_call_720p ("conf_demo", call_id, conf_test_720p);
-            Calls::Instance ()->addNewCall (conf_call_720p);
-            conf_test_720p->onEvent (curEvent);
-        }                       // end if offer
-        else if (curEvent->getEventType () == "keepalive")
-        {
-            // These can come anytime, and have no call ID
-            LOGDEBUG ("Keepalive received");
-        }
-        else
+
+        if (stats_dump)
         {
-            // OK, so not an offered of keepalive. Send event directly to the conferencing app
-            conf_test_720p->onEvent (curEvent);
+            stats_dump = false;
+            std::ostringstream stats;
+            LatencyStats::Instance ()->dump (stats);
+            LOGNOTICE (stats.str ());
         }
-        // Done with the event
-        delete
-            curEvent;
-    }                           // end event loop
+    }                           // end signal loop
+
+    if (term_signal)
+        LOGDEBUG ("Signal " << term_signal << " (" << strsignal (term_signal) << ") received.  Shutting down application");
 
     LOGDEBUG ("Leaving main processing thread");
+    // A worker blocked on a server that has stopped answering would hold up
+    // the rest of the shutdown; give everything still going to XMS a
+    // bounded time from here
+    RestDispatcher::Instance ()->abortAfter (RestDispatcher::STOP_GRACE_SECS);
     // Done; clean up
     //
-    // DELETE event handler. This includes sending a DELETE message to XMS
-    destroy_eventhandler (eventHandlerId);
-    // And conference object
-    delete
-        conf_test_720p;
+    // DELETE event handlers. This includes sending a DELETE message to each XMS
+    for (int index = 0; index < XmsNodePool::Instance ()->size (); index++)
+    {
+        XmsNode *node = XmsNodePool::Instance ()->getNode (index);
+        if (!node->eventHandlerId.empty ())
+            destroy_eventhandler (node->eventHandlerId);
+    }
+    // Nothing routes events to the workers, or logs, once these are back
+    joinEventHandlerThreads ();
+    EventCapture::Instance ()->stopReplay ();
+    // Workers finish what is queued, then close all conferences
+    EventWorkers::Instance ()->stop ();
+
+    // Let queued commands (conference DELETE etc.) go out before stopping
+    RestDispatcher::Instance ()->stop ();
+    std::ostringstream stats;
+    LatencyStats::Instance ()->dump (stats);
+    LOGNOTICE (stats.str ());
+    EventTrace::Instance ()->close ();
+    EventCapture::Instance ()->closeRecording ();
+    if (EventCapture::replaying ())
+    {
+        // From the first event in to the last REST command out
+        uint64_t elapsedUs = EventTrace::now () - EventCapture::Instance ()->replayStartUs ();
+        size_t events = EventCapture::Instance ()->replayEvents ();
+        LOGNOTICE ("Replayed " << events << " events in " << elapsedUs / 1000 << " ms, " <<
+                   (elapsedUs ? events * 1000000 / elapsedUs : 0) << " events/s");
+    }
+    // Pooled REST handles and their connections. curl_global_cleanup() is
+    // left to process exit; the long poll may still be winding down in the
+    // event handler thread.
+    CurlHandlePool::Instance ()->cleanup ();
     return true;
 }
 
@@ -26,20 +26,19 @@
 /*------------------------------ Dependencies --------------------------------*/
 
 #include <string>
-#include <queue>
+#include <unistd.h>
+#include <curl/curl.h>
 
 #include "getoption.h"
-#include "call.h"
+#include "logger.h"
+#include "eventframer.h"
+#include "eventworkers.h"
+#include "xmsnodepool.h"
+#include "eventtrace.h"
+#include "eventcapture.h"
 
 /*----------------------------------------------------------------------------*/
 
-// Externs for event handler thread
-extern std::queue<std::string> eventQueue;
-extern pthread_mutex_t queueLock;
-extern pthread_cond_t queueNotEmpty;
-extern pthread_t evHandlerThread;
-
-
 /*!
  * \class AppFramework
  * 
@@ -54,8 +53,21 @@ class AppFramework
     bool run (const GetOptions & opts, int signal_fd);
 
   private:
+    // Wait before trying again to open a lost XMS event handler
+    static const int EVENT_HANDLER_RETRY_SECS = 5;
+
     static void *eventHandlerThread (void *voidPtr);
+    static void runEventHandler (XmsNode * node);
     bool initEventHandlerThread ();
+    void joinEventHandlerThreads ();
+
+    // cURL progress callback for the event handler's transfers. Aborts
+    // them once the process is terminating, so the thread can be joined
+    // even if XMS never answers or never ends the long poll.
+    static int abortOnTerm (void *clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow);
+
+    // Event handler threads started, one per node
+    int eventHandlerThreads_;
 
     struct MemoryStruct
     {
@@ -88,46 +100,26 @@ class AppFramework
     static size_t longPollReplyContentCallback (void *contents, size_t size, size_t nmemb, void *userp)
     {
 	// A typical CURL reply content callback, BUT, this one is used for the logn poll
-	// GET that remains open.  Any content from the GET is an event from XMS, and here
-	// in the event handling thread, it is enqueued to be read in the main thread where
-	// all the action is.
-        size_t realsize = size * nmemb;
-        struct MemoryStruct *mem = (struct MemoryStruct *) userp;
-        mem->memory = (char *) realloc (mem->memory, mem->size + realsize + 1);
-
-        if (mem->memory == NULL)
-        {
-            // out of memory! 
-            LOGCRIT ("longPollReplyContentCallback - not enough memory (realloc returned NULL)");
-            return 0;
-        }
-	// Add event to the event queue
-        char * eventPtr = (char *) malloc((size * nmemb) + 1); 
-        memcpy(eventPtr, contents, size * nmemb);
-        //*(eventPtr + (size * nmemb) + 1) = 0;
-        *(eventPtr + size * nmemb) = 0;
-        //LOGDEBUG("Event length is " << strlen(eventPtr));
-        //LOGDEBUG("Event is " << eventPtr);
-
-        //for (int i=0; i< (int) strlen(eventPtr); i++)
-        //{
-	//   printf ("%x ", (int) *(eventPtr+i));
-        //}
-	std::string strToEnqueue = eventPtr + 4;
-
-	// Protected section of code here. Only allow adding to queue
-	// if event loop is not removing an entry.
-	// In addition, send a singal to the main thread so that it will 
-	// read an entry out of the queue
-	//LOGDEBUG("Entering protected enqueue section");
-	pthread_mutex_lock(&queueLock);
-	eventQueue.push(strToEnqueue);
-	pthread_mutex_unlock(&queueLock);
-	pthread_cond_signal(&queueNotEmpty);
-	//LOGDEBUG("Out of protected enqueue section");
+	// GET that remains open.  Any content from the GET is one or more events from XMS,
+	// possibly incomplete.  The framer splits them out and hands each complete event
+	// to enqueueEvent.
+        EventFramer *framer = (EventFramer *) userp;
+        if (EventTrace::enabled ())
+            chunkReceivedUs_ = EventTrace::now ();
+        return framer->append ((const char *) contents, size * nmemb);
+    }
 
-        return realsize;
+    static void enqueueEvent (const char *event, size_t length, void *userp)
+    {
+	// Here in the event handling thread, each event is enqueued to the
+	// worker thread that owns its conference, where all the action is.
+	if (EventCapture::recording ())
+	    EventCapture::Instance ()->recordEvent (event, length, ((XmsNode *) userp)->index);
+	EventWorkers::Instance ()->route (event, length, ((XmsNode *) userp)->index, chunkReceivedUs_);
     }
+
+    // When the chunk being framed came off the socket, if tracing
+    static __thread uint64_t chunkReceivedUs_;
 };
 
 
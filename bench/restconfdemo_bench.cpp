@@ -0,0 +1,483 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "logger.h"
+#include "xmseventparser.h"
+#include "xmsreplyparser.h"
+#include "XmlDomDocument.h"
+#include "xmscmds.h"
+#include "calls.h"
+#include "overlaytemplate.h"
+
+/*----------------------------------------------------------------------------*/
+
+// restconfdemo_bench - time the application's hot paths in isolation.
+//
+// Each benchmark is a function running its operation n times. It is run
+// with growing n until one pass takes a while, then once more sized to
+// the target time, and ns/op and heap allocations/op are reported for
+// that pass.  Allocations are counted by replacing global operator new.
+//
+//   restconfdemo_bench [filter] [ms per benchmark]
+//
+// runs the benchmarks whose name contains filter.
+
+/*------------------------------ Allocation count ----------------------------*/
+
+#if __cplusplus >= 201103L
+#define NOTHROW noexcept
+#else
+#define NOTHROW throw ()
+#endif
+
+static unsigned long allocations = 0;
+
+// All kept out of line. Once one is inlined into a caller, g++ sees malloc()
+// or free() paired with the other operator and reports a new/delete mismatch.
+
+__attribute__ ((noinline)) void *
+operator new (size_t size)
+{
+    __atomic_add_fetch (&allocations, 1, __ATOMIC_RELAXED);
+    void *p = malloc (size ? size : 1);
+    if (!p)
+        throw std::bad_alloc ();
+    return p;
+}
+
+__attribute__ ((noinline)) void *
+operator new[] (size_t size)
+{
+    return operator new (size);
+}
+
+__attribute__ ((noinline)) void
+operator delete (void *p) NOTHROW
+{
+    free (p);
+}
+
+__attribute__ ((noinline)) void
+operator delete[] (void *p) NOTHROW
+{
+    free (p);
+}
+
+// Sized forms, used by C++14 and later
+__attribute__ ((noinline)) void
+operator delete (void *p, size_t) NOTHROW
+{
+    free (p);
+}
+
+__attribute__ ((noinline)) void
+operator delete[] (void *p, size_t) NOTHROW
+{
+    free (p);
+}
+
+/*------------------------------ Harness -------------------------------------*/
+
+// Results are added here so the compiler cannot drop the work
+static volatile size_t sink;
+
+typedef void (*BenchFunction) (size_t iterations);
+
+struct Benchmark
+{
+    const char *name;
+    BenchFunction function;
+};
+
+static uint64_t
+nowNs ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void
+runBenchmark (const Benchmark & bench, uint64_t targetNs)
+{
+    // Grow n until a pass is long enough to scale from
+    size_t iterations = 1;
+    uint64_t elapsed;
+    while (true)
+    {
+        uint64_t start = nowNs ();
+        bench.function (iterations);
+        elapsed = nowNs () - start;
+        if (elapsed >= targetNs / 20 || iterations >= ((size_t) 1 << 30))
+            break;
+        iterations *= 2;
+    }
+    if (elapsed < targetNs)
+    {
+        double scale = (double) targetNs / (elapsed ? elapsed : 1);
+        iterations = (size_t) (iterations * scale) + 1;
+    }
+
+    unsigned long allocationsBefore = __atomic_load_n (&allocations, __ATOMIC_RELAXED);
+    uint64_t start = nowNs ();
+    bench.function (iterations);
+    elapsed = nowNs () - start;
+    unsigned long allocated = __atomic_load_n (&allocations, __ATOMIC_RELAXED) - allocationsBefore;
+
+    printf ("%-36s %12lu %12.1f %12.2f\n", bench.name, (unsigned long) iterations, (double) elapsed / iterations,
+            (double) allocated / iterations);
+    fflush (stdout);
+}
+
+/*------------------------------ Captured XMS traffic ------------------------*/
+
+static const char incomingEvent[] =
+    "<web_service version=\"1.0\"><event type=\"incoming\" resource_id=\"a1b2c3d4-0001\" resource_type=\"call\">"
+    "<event_data name=\"call_id\" value=\"a1b2c3d4-0001\"/>"
+    "<event_data name=\"caller_uri\" value=\"sip:alice@example.com\"/>"
+    "<event_data name=\"called_uri\" value=\"sip:room42@xms.example.com\"/>"
+    "<event_data name=\"uri\" value=\"sip:room42@xms.example.com\"/>"
+    "<event_data name=\"name\" value=\"Alice\"/>"
+    "<event_data name=\"display_name\" value=\"Alice\"/>"
+    "<event_data name=\"media\" value=\"audiovideo\"/>"
+    "<event_data name=\"signaling\" value=\"yes\"/>"
+    "<event_data name=\"dtmf_mode\" value=\"rfc2833\"/>"
+    "<event_data name=\"async_dtmf\" value=\"yes\"/>"
+    "<event_data name=\"async_tone\" value=\"yes\"/>"
+    "<event_data name=\"appid\" value=\"app\"/>"
+    "</event></web_service>";
+
+static const char dtmfEvent[] =
+    "<web_service version=\"1.0\"><event type=\"dtmf\" resource_id=\"a1b2c3d4-0001\" resource_type=\"call\">"
+    "<event_data name=\"call_id\" value=\"a1b2c3d4-0001\"/>"
+    "<event_data name=\"digits\" value=\"5\"/>"
+    "<event_data name=\"appid\" value=\"app\"/>"
+    "</event></web_service>";
+
+static const char endPlayEvent[] =
+    "<web_service version=\"1.0\"><event type=\"end_play\" resource_id=\"conf-77\" resource_type=\"conference\">"
+    "<event_data name=\"transaction_id\" value=\"play-1234\"/>"
+    "<event_data name=\"reason\" value=\"end of file reached\"/>"
+    "<event_data name=\"appid\" value=\"app\"/>"
+    "</event></web_service>";
+
+static const char eventhandlerReply[] =
+    "<web_service version=\"1.0\"><eventhandler_response href=\"/default/eventhandlers/eh-9f8e7d\""
+    " identifier=\"eh-9f8e7d\" appid=\"app\"/></web_service>";
+
+static const char conferenceReply[] =
+    "<web_service version=\"1.0\"><conference_response identifier=\"conf-77\" href=\"/default/conferences/conf-77\""
+    " appid=\"app\" type=\"audiovideo\" max_parties=\"25\" reserve=\"0\" layout=\"4\"/></web_service>";
+
+static const char playReply[] =
+    "<web_service version=\"1.0\"><conference_response identifier=\"conf-77\" appid=\"app\">"
+    "<play transaction_id=\"play-1234\" offset=\"0s\" repeat_count=\"0\"/></conference_response></web_service>";
+
+static const char recordReply[] =
+    "<web_service version=\"1.0\"><conference_response identifier=\"conf-77\" appid=\"app\">"
+    "<record transaction_id=\"rec-5678\" max_time=\"60s\"/></conference_response></web_service>";
+
+/*------------------------------ Benchmarks ----------------------------------*/
+
+static void
+benchParseEvent (const char *xml, size_t iterations)
+{
+    size_t length = strlen (xml);
+    for (size_t i = 0; i < iterations; i++)
+    {
+        xmsEventParser event (xml, length);
+        sink += event.getEventType ().size ();
+    }
+}
+
+static void
+benchParseIncoming (size_t iterations)
+{
+    benchParseEvent (incomingEvent, iterations);
+}
+
+static void
+benchParseDtmf (size_t iterations)
+{
+    benchParseEvent (dtmfEvent, iterations);
+}
+
+static void
+benchParseEndPlay (size_t iterations)
+{
+    benchParseEvent (endPlayEvent, iterations);
+}
+
+static void
+benchParseIncomingLookup (size_t iterations)
+{
+    // What the incoming handlers ask of the event
+    size_t length = strlen (incomingEvent);
+    for (size_t i = 0; i < iterations; i++)
+    {
+        xmsEventParser event (incomingEvent, length);
+        sink += event.findValByKey ("call_id").size ();
+        sink += event.findValByKey ("called_uri").size ();
+    }
+}
+
+static void
+benchDomQuery (size_t iterations)
+{
+    std::string xml (incomingEvent);
+    for (size_t i = 0; i < iterations; i++)
+    {
+        XmlDomDocument doc (xml);
+        sink += doc.getAttribute ("event", 0, "type").size ();
+        sink += doc.getChildAttribute ("event", 0, "event_data", 2, "value").size ();
+        sink += doc.getChildCount ("event", 0, "event_data");
+    }
+}
+
+static void
+benchReply (const char *xml, ReplyType type, size_t iterations)
+{
+    size_t length = strlen (xml);
+    for (size_t i = 0; i < iterations; i++)
+    {
+        xmsReplyParser reply (xml, length, type);
+        sink += reply.getConfId ().size () + reply.getMediaId ().size () + reply.getEventhandlerId ().size ();
+    }
+}
+
+static void
+benchReplyEventhandler (size_t iterations)
+{
+    benchReply (eventhandlerReply, createEventhandler, iterations);
+}
+
+static void
+benchReplyConference (size_t iterations)
+{
+    benchReply (conferenceReply, createConference, iterations);
+}
+
+static void
+benchReplyPlay (size_t iterations)
+{
+    benchReply (playReply, playIntoConference, iterations);
+}
+
+static void
+benchReplyRecord (size_t iterations)
+{
+    benchReply (recordReply, recordConference, iterations);
+}
+
+static void
+benchCalls (size_t numCalls, size_t iterations)
+{
+    // XMS call IDs are long and share a prefix, like these
+    Calls calls;
+    std::vector < std::string > ids;
+    for (size_t i = 0; i < numCalls; i++)
+    {
+        char id[64];
+        snprintf (id, sizeof (id), "0c8f5e3a-7d21-4b7e-9a55-%012lx", (unsigned long) i * 7919);
+        ids.push_back (id);
+        calls.addNewCall (id);
+        calls.setConfRegionById (id, (int) (i % 25) + 1);
+    }
+    for (size_t i = 0; i < iterations; i++)
+    {
+        const char *id = ids[i % numCalls].c_str ();
+        sink += calls.findCall (id);
+        sink += calls.getConfRegionByCallId (id);
+    }
+}
+
+static void
+benchCalls6 (size_t iterations)
+{
+    benchCalls (6, iterations);
+}
+
+static void
+benchCalls50 (size_t iterations)
+{
+    benchCalls (50, iterations);
+}
+
+static void
+benchCalls500 (size_t iterations)
+{
+    benchCalls (500, iterations);
+}
+
+static void
+benchAnswerXml (size_t iterations)
+{
+    for (size_t i = 0; i < iterations; i++)
+        sink += answer_call_xml ("rfc2833").size ();
+}
+
+static void
+benchAddPartyXml (size_t iterations)
+{
+    std::string confId ("conf-77");
+    for (size_t i = 0; i < iterations; i++)
+        sink += add_party_xml (confId, "3").size ();
+}
+
+static void
+benchUpdateConferenceXml (size_t iterations)
+{
+    for (size_t i = 0; i < iterations; i++)
+        sink += update_conference_xml (NULL, "6", NULL).size ();
+}
+
+static void
+benchRecordXml (size_t iterations)
+{
+    std::string confId ("conf-77");
+    for (size_t i = 0; i < iterations; i++)
+    {
+        sink += record_conf_xml (confId, "file://rec/a.wav", "audio/x-wav", "L16", "16000", "file://rec/v.vid",
+                                 "video/x-vid", "H264", "3.1", "720", "1280", "1000000", "30", "60s").size ();
+    }
+}
+
+static const OverlayTemplate callerIdOverlay ("region={region},overlay_id=caller_overlay,left=30%,top=90%,hsize=40%,"
+                                              "vsize=10%,priority=0.6,overlay_duration=lifeOfContent,"
+                                              "overlay_bgopacity=0%,textstyle_id=textStyle2,fontfamily=TimesNewRoman,"
+                                              "fontweight=bold,fontcolor=firebrick,textstyle_bgcolor=gray,"
+                                              "textalignment=center,content_id=r2-1,p_id=conferee_name,"
+                                              "p_style=textStyle2,text={text}");
+static const OverlayTemplate deleteOverlay ("region={region},overlay_id=video_overlay,priority=0");
+
+static void
+benchOverlayBatch (size_t iterations)
+{
+    // One '#' layout change: caller IDs re-sent for six regions
+    std::string batch;
+    for (size_t i = 0; i < iterations; i++)
+    {
+        batch.clear ();
+        for (int region = 1; region <= 6; region++)
+        {
+            if (!batch.empty ())
+                batch += ';';
+            callerIdOverlay.appendTo (batch, region, "sip:alice@example.com");
+        }
+        sink += batch.size ();
+    }
+}
+
+static void
+benchOverlayDelete (size_t iterations)
+{
+    std::string batch;
+    for (size_t i = 0; i < iterations; i++)
+    {
+        batch.clear ();
+        deleteOverlay.appendTo (batch, (int) (i % 25) + 1);
+        sink += batch.size ();
+    }
+}
+
+/*!
+ * Takes the formatted line and drops it, so only the logger is timed.
+ */
+class NullAppender:public Logger::Appender
+{
+  public:
+    virtual void write (Logger::LogLevel level, const std::string & msg)
+    {
+        sink += msg.size ();
+    }
+};
+
+static void
+benchLogWritten (size_t iterations)
+{
+    for (size_t i = 0; i < iterations; i++)
+        LOGNOTICE ("Adding party to conference " << "conf-77" << " in region " << (int) (i % 25));
+}
+
+static void
+benchLogFiltered (size_t iterations)
+{
+    // The common case: a LOGDEBUG with debug off
+    for (size_t i = 0; i < iterations; i++)
+        LOGDEBUG ("Adding party to conference " << "conf-77" << " in region " << (int) (i % 25));
+}
+
+static const Benchmark benchmarks[] = {
+    {"event/parse/incoming", benchParseIncoming},
+    {"event/parse/dtmf", benchParseDtmf},
+    {"event/parse/end_play", benchParseEndPlay},
+    {"event/parse+lookup/incoming", benchParseIncomingLookup},
+    {"dom/query/incoming", benchDomQuery},
+    {"reply/createEventhandler", benchReplyEventhandler},
+    {"reply/createConference", benchReplyConference},
+    {"reply/playIntoConference", benchReplyPlay},
+    {"reply/recordConference", benchReplyRecord},
+    {"calls/lookup/6", benchCalls6},
+    {"calls/lookup/50", benchCalls50},
+    {"calls/lookup/500", benchCalls500},
+    {"xmscmds/answer_call", benchAnswerXml},
+    {"xmscmds/add_party", benchAddPartyXml},
+    {"xmscmds/update_conference", benchUpdateConferenceXml},
+    {"xmscmds/record_conf", benchRecordXml},
+    {"overlay/caller_id_x6", benchOverlayBatch},
+    {"overlay/delete", benchOverlayDelete},
+    {"logger/written", benchLogWritten},
+    {"logger/filtered", benchLogFiltered},
+};
+
+int
+main (int argc, char *argv[])
+{
+    const char *filter = argc > 1 ? argv[1] : "";
+    uint64_t targetNs = (argc > 2 ? strtoull (argv[2], NULL, 10) : 200) * 1000000;
+
+    Logger::instance ().setLevel (Logger::LOGLEVEL_NOTICE);
+    Logger::instance ().attachAppender (new NullAppender);
+
+    printf ("%-36s %12s %12s %12s\n", "benchmark", "iterations", "ns/op", "allocs/op");
+    for (size_t i = 0; i < sizeof (benchmarks) / sizeof (benchmarks[0]); i++)
+    {
+        if (strstr (benchmarks[i].name, filter))
+            runBenchmark (benchmarks[i], targetNs);
+    }
+    return 0;
+}
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
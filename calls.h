@@ -20,326 +20,414 @@
  *
  */
 
+
 #ifndef _CALLS_H
 #define _CALLS_H
 
 /*------------------------------ Dependencies --------------------------------*/
 
-#include <string>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
 #include <vector>
-#include "call.h"
+#include <tr1/unordered_map>
+#include "logger.h"
+#include "cstrhash.h"
 /*----------------------------------------------------------------------------*/
 
 /*!
- * \class Calls - an STL vector of all calls active in the demo
- * 	The class is a singleton.
- * 
+ * Compact handle for an active call. The XMS call ID is interned once, on
+ * the incoming event; everything else about the call is found from the
+ * handle. Handles are small integers and are reused after delCall ().
+ */
+typedef int CallHandle;
+static const CallHandle NO_CALL = -1;
+
+/*!
+ * \class Calls - all calls active in one conference
+ * 	Each Conference720p owns one.
+ *
+ * 	Per call state is held structure-of-arrays style: one vector per field,
+ * 	indexed by CallHandle, so a check such as "is region N muted" reads the
+ * 	region table and one byte of the mute table rather than walking calls and
+ * 	comparing strings. A hash map takes a call ID to its handle.
+ *
+ * 	The call ID based methods are kept for event handling, where the call ID
+ * 	comes straight from XMS.
  */
 class Calls
 {
   public:
+    Calls ()
+    {
+    };
+
     /*!
      * dtor.
      */
-    ~Calls ();
-
-    static Calls *Instance ()
+    ~Calls ()
     {
-        if (!pInstance_)
-            pInstance_ = new Calls;
-
-        return pInstance_;
+        clearAllCalls ();
     }
 
     void clearAllCalls ()
     {
         LOGDEBUG ("Clearing all calls from call list");
-        verification_calls_.clear ();
+        callsById_.clear ();
+        for (size_t handle = 0; handle < callIds_.size (); handle++)
+            free (callIds_[handle]);
+        callIds_.clear ();
+        regions_.clear ();
+        audioMuted_.clear ();
+        videoHidden_.clear ();
+        freeHandles_.clear ();
+        activeCalls_.clear ();
+        regionCalls_.clear ();
     }
 
-    void addNewCall (Call newCall)
+    /*!
+     * Intern a new call ID. Returns its handle, or the existing handle if
+     * the call is already known.
+     */
+    CallHandle addNewCall (const char *call_id)
     {
-        verification_calls_.push_back (newCall);
+        if (call_id == NULL)
+        {
+            LOGWARN ("Bad call ID. Call not added");
+            return NO_CALL;
+        }
+        CallHandle handle = findCall (call_id);
+        if (handle != NO_CALL)
+        {
+            LOGWARN ("Call ID " << call_id << " already in active call list");
+            return handle;
+        }
+
+        if (!freeHandles_.empty ())
+        {
+            handle = freeHandles_.back ();
+            freeHandles_.pop_back ();
+        }
+        else
+        {
+            handle = (CallHandle) callIds_.size ();
+            callIds_.push_back (NULL);
+            regions_.push_back (0);
+            audioMuted_.push_back (false);
+            videoHidden_.push_back (false);
+        }
+        // Own copy, so the map key never moves when the vectors grow
+        callIds_[handle] = strdup (call_id);
+        regions_[handle] = 0;
+        audioMuted_[handle] = false;
+        videoHidden_[handle] = false;
+        callsById_[callIds_[handle]] = handle;
+        activeCalls_.push_back (handle);
+        LOGDEBUG ("Call ID " << call_id << " has handle " << handle);
+        return handle;
     }
 
-    Conference720p *getAppById (const char *call_id)
+    CallHandle findCall (const char *call_id) const
     {
-        std::vector < Call >::iterator call_iterator;
-
         if (call_id == NULL)
+            return NO_CALL;
+        CallIndex::const_iterator index_iterator = callsById_.find (call_id);
+        if (index_iterator == callsById_.end ())
+            return NO_CALL;
+        return index_iterator->second;
+    }
+
+    /*!
+     * Active calls, in the order they arrived.
+     */
+    const std::vector < CallHandle > &getCallList () const
+    {
+        return activeCalls_;
+    }
+
+    // By handle. The handle must be one of getCallList ()
+
+    const char *getCallId (CallHandle handle) const
+    {
+        return callIds_[handle];
+    }
+
+    int getConfRegion (CallHandle handle) const
+    {
+        return regions_[handle];
+    }
+
+    bool isAudioMuted (CallHandle handle) const
+    {
+        return audioMuted_[handle];
+    }
+
+    bool isVideoHidden (CallHandle handle) const
+    {
+        return videoHidden_[handle];
+    }
+
+    // By conference region
+
+    /*!
+     * Call shown in a region, or NO_CALL. While a rotation briefly puts two
+     * calls in one region, the one moved there last is returned.
+     */
+    CallHandle getCallByConfRegion (int region) const
+    {
+        if (region <= 0 || (size_t) region >= regionCalls_.size ())
+            return NO_CALL;
+        return regionCalls_[region];
+    }
+
+    const char *getCallIdByConfRegion (const int region)
+    {
+        CallHandle handle = getCallByConfRegion (region);
+        if (handle == NO_CALL)
             return NULL;
-        for (call_iterator = verification_calls_.begin (); call_iterator != verification_calls_.end (); call_iterator++)
-        {
-            if (strcmp (call_iterator->getCallId (), call_id) == 0)
-            {
-                LOGDEBUG ("Event match for call id " << call_id);
-                return call_iterator->getApp ();
-            }
-        }
-        return NULL;
+        LOGDEBUG ("Call ID for region " << region << " is " << callIds_[handle]);
+        return callIds_[handle];
     }
 
-    void setConfRegionById (const char *call_id, const int region)
+    bool isAudioMuteOnForRegion (int region) const
     {
-        std::vector < Call >::iterator call_iterator;
+        CallHandle handle = getCallByConfRegion (region);
+        return handle != NO_CALL && audioMuted_[handle];
+    }
 
+    bool isVideoHiddenForRegion (int region) const
+    {
+        CallHandle handle = getCallByConfRegion (region);
+        return handle != NO_CALL && videoHidden_[handle];
+    }
+
+    // By XMS call ID
+
+    void setConfRegionById (const char *call_id, const int region)
+    {
         if (call_id == NULL)
         {
             LOGWARN ("Bad call ID. Conf region not set");
             return;
         }
-        for (call_iterator = verification_calls_.begin (); call_iterator != verification_calls_.end (); call_iterator++)
+        CallHandle handle = findCall (call_id);
+        if (handle != NO_CALL)
         {
-            if (strcmp (call_iterator->getCallId (), call_id) == 0)
-            {
-                LOGDEBUG ("Setting conference region for call id " << call_id << " to " << region);
-                call_iterator->setConfRegion (region);
-            }
+            LOGDEBUG ("Setting conference region for call id " << call_id << " to " << region);
+            moveToRegion (handle, region);
         }
     }
 
     void clearConfRegionById (const char *call_id)
     {
-        std::vector < Call >::iterator call_iterator;
         if (call_id == NULL)
         {
             LOGWARN ("Bad call ID. Conf region not cleared");
             return;
         }
-        for (call_iterator = verification_calls_.begin (); call_iterator != verification_calls_.end (); call_iterator++)
+        CallHandle handle = findCall (call_id);
+        if (handle != NO_CALL)
         {
-            if (strcmp (call_iterator->getCallId (), call_id) == 0)
-            {
-                LOGDEBUG ("Clearing conference region for call id " << call_id);
-                call_iterator->clearConfRegion ();
-            }
+            LOGDEBUG ("Clearing conference region for call id " << call_id);
+            moveToRegion (handle, 0);
         }
     }
 
     int getConfRegionByCallId (const char *call_id)
     {
-        std::vector < Call >::iterator call_iterator;
         if (call_id == NULL)
         {
             LOGWARN ("Bad call ID. Conf region not returned");
-            return NULL;
+            return 0;
         }
-        for (call_iterator = verification_calls_.begin (); call_iterator != verification_calls_.end (); call_iterator++)
+        CallHandle handle = findCall (call_id);
+        if (handle != NO_CALL)
         {
-            if (strcmp (call_iterator->getCallId (), call_id) == 0)
-            {
-                LOGDEBUG ("Conference region for call id " << call_id << " is " << call_iterator->getConfRegion ());
-                return call_iterator->getConfRegion ();
-            }
+            LOGDEBUG ("Conference region for call id " << call_id << " is " << regions_[handle]);
+            return regions_[handle];
         }
         LOGWARN ("No match. Conf region not returned");
-        return NULL;
-    }
-
-    const char *getCallIdByConfRegion (const int region)
-    {
-        std::vector < Call >::iterator call_iterator;
-        for (call_iterator = verification_calls_.begin (); call_iterator != verification_calls_.end (); call_iterator++)
-        {
-            if (call_iterator->getConfRegion () == region)
-            {
-                LOGDEBUG ("Call ID for region " << region << " is " << call_iterator->getCallId ());
-                return call_iterator->getCallId ();
-            }
-        }
-        return NULL;
+        return 0;
     }
 
     void setCallRegionByCallId (const char *callId, int region)
     {
-        std::vector < Call >::iterator call_iterator;
-
         if (callId == NULL)
         {
             LOGWARN ("Bad call ID. Call region not set");
             return;
         }
-        for (call_iterator = verification_calls_.begin (); call_iterator != verification_calls_.end (); call_iterator++)
+        CallHandle handle = findCall (callId);
+        if (handle != NO_CALL)
         {
-            if (strcmp (call_iterator->getCallId (), callId) == 0)
-            {
-                LOGDEBUG ("Setting new region " << region << " for Call ID: " << call_iterator->getCallId ());
-                call_iterator->setConfRegion (region);
-            }
+            LOGDEBUG ("Setting new region " << region << " for Call ID: " << callId);
+            moveToRegion (handle, region);
         }
     }
 
     bool isAudioMuteOnForCallId (const char *callId)
     {
-        std::vector < Call >::iterator call_iterator;
-
         if (callId == NULL)
         {
             LOGWARN ("Bad call ID. Unreliable flag returned");
             return false;
         }
-        for (call_iterator = verification_calls_.begin (); call_iterator != verification_calls_.end (); call_iterator++)
-        {
-            if (strcmp (call_iterator->getCallId (), callId) == 0)
-            {
-                return call_iterator->isAudioMuted ();
-            }
-        }
+        CallHandle handle = findCall (callId);
+        if (handle != NO_CALL)
+            return audioMuted_[handle];
         LOGWARN ("No match. Unreliable flag returned");
         return false;
     }
 
     bool isVideoHiddenForCallId (const char *callId)
     {
-        std::vector < Call >::iterator call_iterator;
-
         if (callId == NULL)
         {
             LOGWARN ("Bad call ID. Unreliable flag returned");
             return false;
         }
-        for (call_iterator = verification_calls_.begin (); call_iterator != verification_calls_.end (); call_iterator++)
-        {
-            if (strcmp (call_iterator->getCallId (), callId) == 0)
-            {
-                return call_iterator->isVideoHidden ();
-            }
-        }
+        CallHandle handle = findCall (callId);
+        if (handle != NO_CALL)
+            return videoHidden_[handle];
         LOGWARN ("No match. Unreliable flag returned");
         return false;
     }
 
     void setAudioMutedByCallId (const char *callId)
     {
-        std::vector < Call >::iterator call_iterator;
-
         if (callId == NULL)
         {
             LOGWARN ("Bad call ID. Audio mute not set");
             return;
         }
-        for (call_iterator = verification_calls_.begin (); call_iterator != verification_calls_.end (); call_iterator++)
+        CallHandle handle = findCall (callId);
+        if (handle != NO_CALL)
         {
-            if (strcmp (call_iterator->getCallId (), callId) == 0)
-            {
-                call_iterator->setAudioMuteOn ();
-                LOGDEBUG ("Set audio mute on for " << call_iterator->getCallId ());
-				return;
-            }
+            audioMuted_[handle] = true;
+            LOGDEBUG ("Set audio mute on for " << callId);
+            return;
         }
         LOGWARN ("No match. Audio mute not set");
     }
 
     void setVideoHiddenByCallId (const char *callId)
     {
-        std::vector < Call >::iterator call_iterator;
-
         if (callId == NULL)
         {
             LOGWARN ("Bad call ID. Video hidden not set");
             return;
         }
-        for (call_iterator = verification_calls_.begin (); call_iterator != verification_calls_.end (); call_iterator++)
+        CallHandle handle = findCall (callId);
+        if (handle != NO_CALL)
         {
-            if (strcmp (call_iterator->getCallId (), callId) == 0)
-            {
-                call_iterator->setVideoHidden ();
-                LOGDEBUG ("Set video hidden for " << call_iterator->getCallId ());
-				return;
-            }
+            videoHidden_[handle] = true;
+            LOGDEBUG ("Set video hidden for " << callId);
+            return;
         }
         LOGWARN ("No match. Video hidden not set");
     }
 
     void setAudioUnmutedByCallId (const char *callId)
     {
-        std::vector < Call >::iterator call_iterator;
-
         if (callId == NULL)
         {
             LOGWARN ("Bad call ID. Audio unmute not set");
             return;
         }
-        for (call_iterator = verification_calls_.begin (); call_iterator != verification_calls_.end (); call_iterator++)
+        CallHandle handle = findCall (callId);
+        if (handle != NO_CALL)
         {
-            if (strcmp (call_iterator->getCallId (), callId) == 0)
-            {
-                call_iterator->setAudioMuteOff ();
-                LOGDEBUG ("Set audio mute off for " << call_iterator->getCallId ());
-				return;
-            }
+            audioMuted_[handle] = false;
+            LOGDEBUG ("Set audio mute off for " << callId);
+            return;
         }
         LOGWARN ("No match. Audio unmute not set");
     }
 
     void setVideoVisibleByCallId (const char *callId)
     {
-        std::vector < Call >::iterator call_iterator;
-
         if (callId == NULL)
         {
             LOGWARN ("Bad call ID. Video visble not set");
             return;
         }
-        for (call_iterator = verification_calls_.begin (); call_iterator != verification_calls_.end (); call_iterator++)
+        CallHandle handle = findCall (callId);
+        if (handle != NO_CALL)
         {
-            if (strcmp (call_iterator->getCallId (), callId) == 0)
-            {
-                call_iterator->setVideoVisible ();
-                LOGDEBUG ("Set video visible for " << call_iterator->getCallId ());
-				return;
-            }
+            videoHidden_[handle] = false;
+            LOGDEBUG ("Set video visible for " << callId);
+            return;
         }
         LOGWARN ("No match. Video visible not set");
     }
 
     void delCall (const char *call_id)
     {
-        std::vector < Call >::iterator call_iterator;
-
         if (call_id == NULL)
         {
             LOGWARN ("Bad call ID. Call cannot be deleted");
             return;
         }
-        for (call_iterator = verification_calls_.begin (); call_iterator != verification_calls_.end (); call_iterator++)
+        CallIndex::iterator index_iterator = callsById_.find (call_id);
+        if (index_iterator == callsById_.end ())
         {
-            if (strcmp (call_iterator->getCallId (), call_id) == 0)
-            {
-                LOGDEBUG ("Deleting call with call ID " << call_iterator->getCallId () << " from active call list");
-                verification_calls_.erase (call_iterator);
-                return;
-            }
+            LOGWARN ("No match. Call being deleted from active call list does not exist");
+            return;
         }
-        LOGWARN ("No match. Call being deleted from active call list does not exist");
-    }
-
-    std::vector < Call > getCallList ()
-    {
-        return verification_calls_;
+        CallHandle handle = index_iterator->second;
+        LOGDEBUG ("Deleting call with call ID " << call_id << " from active call list");
+        moveToRegion (handle, 0);
+        // Key is the interned ID; drop it before freeing
+        callsById_.erase (index_iterator);
+        free (callIds_[handle]);
+        callIds_[handle] = NULL;
+        activeCalls_.erase (std::find (activeCalls_.begin (), activeCalls_.end (), handle));
+        freeHandles_.push_back (handle);
     }
 
     void printCallList ()
     {
-        std::vector < Call >::iterator call_iterator;
+        std::vector < CallHandle >::iterator call_iterator;
 
-        for (call_iterator = verification_calls_.begin (); call_iterator != verification_calls_.end (); call_iterator++)
+        for (call_iterator = activeCalls_.begin (); call_iterator != activeCalls_.end (); call_iterator++)
         {
-            LOGDEBUG ("Print Call list. Call ID: " << call_iterator->getCallId () << " Region: " << call_iterator->
-                      getConfRegion ());
+            LOGDEBUG ("Print Call list. Call ID: " << callIds_[*call_iterator] << " Region: " <<
+                      regions_[*call_iterator]);
         }
     }
 
-    std::vector < Call > verification_calls_;
-
   private:
-    /*!
-     * ctor. Hide here as class is a singleton
-     */
-    Calls ()
+    Calls (const Calls &);
+    Calls & operator = (const Calls &);
+
+    typedef std::tr1::unordered_map < const char *, CallHandle, CStrHash, CStrEqual > CallIndex;
+
+    // Keep regionCalls_ in step with a call changing region. Region 0 is
+    // "no region" and is not indexed
+    void moveToRegion (CallHandle handle, int region)
     {
-    };
-    static Calls *pInstance_;
+        int oldRegion = regions_[handle];
+        if (oldRegion > 0 && (size_t) oldRegion < regionCalls_.size () && regionCalls_[oldRegion] == handle)
+            regionCalls_[oldRegion] = NO_CALL;
+        if (region > 0)
+        {
+            if ((size_t) region >= regionCalls_.size ())
+                regionCalls_.resize (region + 1, NO_CALL);
+            regionCalls_[region] = handle;
+        }
+        regions_[handle] = region;
+    }
+
+    // Per call state, indexed by CallHandle. A free slot has a NULL call ID
+    std::vector < char *>callIds_;
+    std::vector < int >regions_;
+    std::vector < unsigned char >audioMuted_;
+    std::vector < unsigned char >videoHidden_;
+    std::vector < CallHandle > freeHandles_;
+
+    std::vector < CallHandle > activeCalls_;
+    CallIndex callsById_;
+    std::vector < CallHandle > regionCalls_;    // by conference region
 };
 
 
@@ -34,6 +34,66 @@
 
 /*----------------------------------------------------------------------------*/
 
+// Overlay definitions. {region} etc. are filled in per use, see OverlayTemplate
+
+static const OverlayTemplate showCallerIdOverlay ("region={region},overlay_id=caller_overlay,left=30%,top=90%,hsize=40%,vsize=10%,priority=0.6,"
+                                                  "overlay_duration=lifeOfContent,overlay_bgopacity=0%,textstyle_id=textStyle2,"
+                                                  "fontfamily=TimesNewRoman,fontweight=bold,fontcolor=firebrick,textstyle_bgcolor=gray,"
+                                                  "textalignment=center,content_id=r2-1,p_id=conferee_name,p_style=textStyle2,text={text}");
+
+static const OverlayTemplate showVideoLabelOverlay ("region={region},overlay_id=video_overlay,left=30%,top=90%,hsize=40%,vsize=10%,priority=0.1,"
+                                                    "overlay_duration=lifeOfContent,overlay_bgopacity=0%,textstyle_id=textStyle2,"
+                                                    "fontfamily=TimesNewRoman,fontweight=bold,fontcolor=firebrick,textstyle_bgcolor=gray,"
+                                                    "textalignment=center,content_id=r2-1,p_id=ivideo_caption,p_style=textStyle2,text=Recorded Video");
+
+static const OverlayTemplate deleteVideoLabelOverlay ("region={region},overlay_id=video_overlay,priority=0");
+
+static const OverlayTemplate deleteCallerIdOverlay ("region={region},overlay_id=caller_overlay,priority=0");
+
+static const OverlayTemplate showMicOnOverlay ("region={region},overlay_id=micon_overlay,left=0%,top=0%,hsize=10%,vsize=10%,priority=0.3,"
+                                               "overlay_bgopacity=0%,imgstyle_id=imgStyle1,imgalignment=center,imgstyle_bgopacity=0%,"
+                                               "content_id=body1,content_applymode=replace,img_id=image1,img_style=imgStyle1,img_type=png,"
+                                               "img_uri=file:///var/lib/xms/media/en-US/restconfdemo/red_recording_dot.png");
+
+static const OverlayTemplate deleteMicOnOverlay ("region={region},overlay_id=micon_overlay,priority=0");
+
+static const OverlayTemplate showMicMuteOverlay ("region={region},overlay_id=micmute_overlay,left=0%,top=0%,hsize=15%,vsize=105,priority=0.2,"
+                                                 "overlay_bgopacity=0%,imgstyle_id=imgStyle1,imgalignment=center,imgstyle_bgopacity=0%,"
+                                                 "content_id=body1,content_applymode=replace,img_id=image1,img_style=imgStyle1,img_type=png,"
+                                                 "img_uri=file:///var/lib/xms/media/en-US/restconfdemo/mic_disabled.png");
+
+static const OverlayTemplate deleteMicMuteOverlay ("region={region},overlay_id=micmute_overlay,priority=0");
+
+static const OverlayTemplate showBagheadOverlay ("region={region},overlay_id=baghead_overlay,left=0%,top=0%,hsize=100%,vsize=100%,priority=0.5,"
+                                                 "overlay_bgopacity=0%,imgstyle_id=imgStyle1,imgalignment=center,imgstyle_bgopacity=0%,"
+                                                 "content_id=body1,content_applymode=replace,img_id=image1,img_style=imgStyle1,img_type=png,"
+                                                 "img_uri=file:///var/lib/xms/media/en-US/restconfdemo/baghead.png");
+
+static const OverlayTemplate deleteBagheadOverlay ("region={region},overlay_id=baghead_overlay,priority=0");
+
+static const OverlayTemplate showStockTickerOverlay ("region={region},overlay_id=stocktick,left=20%,top=50%,hsize=60%,vsize=50%,priority=0.5,"
+                                                     "overlay_bgcolor=CornflowerBlue,imgstyle_id=imgStyle1,imgalignment=center,imgstyle_bgopacity=0%,"
+                                                     "content_id=body1,content_applymode=replace,img_id=image1,img_style=imgStyle1,img_type=png,"
+                                                     "img_uri=file:///var/lib/xms/media/en-US/restconfdemo/stock_market.png,"
+                                                     "img_duration=0;region={region},overlay_id=stocktickText,left=20%,top=95%,hsize=60%,vsize=5%,"
+                                                     "priority=0.4,overlay_bgcolor=gray,textstyle_id=textStyle2,fontfamily=Arial,fontstyle=normal,"
+                                                     "fontweight=bold,fonteffects=none,fontsize=100%,fontcolor=firebrick,fontdirection=lr,"
+                                                     "textstyle_bgcolor=gray,textalignment=center,wrap=nowrap,content_id=body1,"
+                                                     "content_applymode=replace,scroll_mode=scrollContinuous,direction=rl,padding=0,speed=8,"
+                                                     "p_id=textstring1,p_style=textStyle2,p_duration=30s,encoding=UTF8,"
+                                                     "text=Symbol - AMD   Name - Advanced Micro Devices   Stock Exchange - NYSE   Opening Price - 4.1501   Asking Price - N/A   EBITDA - -90.0M  Symbol - BA   Name - Boeing Company   Stock   Days Low - 139.75   52 Week High - 142.80   52 Week Low - 73.00  Earnings per Share - 80.88   Asking Price - N/A   Volume - 454977   Days High - 81.8525  Days Low - 80    Symbol - CAB   Name - Cabela's Inc Clas   Stock Exchange - NYSE   Opening Price - 69.66   Asking Low - 47.65  Earnings per Share - 2.959   EBITDA - 437.3M  Symbol - DOW   Name - Dow 5   Days High - 43.47  Days Low - 43.00   52 Week High - 44.99   52 Week Low - 29.81    Symbol - IBM   Name - Internaltion Business Machines   Opening Price - 1156.85   Asking Price - N/A   Volume - 2766140   Days High - 116   EBITDA - 17.599B");
+
+static const OverlayTemplate deleteStockTickerOverlay ("region={region},overlay_id=stocktick,priority=0;region={region},overlay_id=stocktickText,"
+                                                       "priority=0");
+
+static const OverlayTemplate showSlideOverlay ("region={region},overlay_id=slideshow_overlay,left=0%,top=0%,hsize=66.6%,vsize=66.6%,"
+                                               "priority=0.4,hbwidth=2%,vbwidth=2%,bcolor=firebrick,overlay_duration=lifeOfContent,"
+                                               "imgstyle_id=imgStyle1,imgalignment=center,imgstyle_applymode=resizeToFit,imgsize=98%,"
+                                               "img_duration=5s,content_id=slide{slide},content_applymode=replace,img_id=image1,"
+                                               "img_style=imgStyle1,img_type=png,"
+                                               "img_uri=file:///var/lib/xms/media/en-US/restconfdemo/slide{slide}.png");
+
+static const OverlayTemplate deleteSlideOverlay ("region={region},overlay_id=slideshow_overlay,priority=0");
 
 Conference720p::Conference720p (std::string dtmf_mode)
 {
@@ -46,7 +106,7 @@ Conference720p::Conference720p (std::string dtmf_mode)
 
 Conference720p::~Conference720p ()
 {
-    if (conf_id_.empty ())
+    if (!conf_id_.empty ())
     {
         LOGDEBUG ("Destroying conference " << conf_id_);
         destroy_conference (conf_id_);
@@ -59,9 +119,11 @@ Conference720p::resetConference ()
     // initialize 
     is_very_first_call_ = true;
     nullExclusiveMediaOp ();
-    conf_id_ = '\0';
-    layout_ = '4';
+    conf_id_.clear ();
+    overlayBatch_.clear ();
     init_region_use ();
+    layout_ = LayoutTable::Instance ()->find ("4");
+    regions_.setLayout (layout_->getNumRegions ());
     recordInProgress_ = false;
     //overlay_id_ = '\0';
     captionsOn_ = false;
@@ -69,9 +131,13 @@ Conference720p::resetConference ()
     slide_show_ = false;
 }
 
+int (*Conference720p::fileCheck_) (const char *filename) = NULL;
+
 int
 Conference720p::file_exists (const char *filename)
 {
+    if (fileCheck_)
+        return fileCheck_ (filename);
     struct stat buffer;
     LOGDEBUG ("For file: " << filename << " stat returns " << stat (filename, &buffer));
     return (stat (filename, &buffer) == 0);
@@ -82,91 +148,66 @@ void
 Conference720p::notify_all_callers (const char *message)
 {
     // Notify all callers with message
-    std::vector < Call >::iterator call_iterator;
-    for (call_iterator = Calls::Instance ()->verification_calls_.begin ();
-         call_iterator != Calls::Instance ()->verification_calls_.end (); call_iterator++)
+    Calls *callList = &calls_;
+    const std::vector < CallHandle > &calls = callList->getCallList ();
+    std::vector < CallHandle >::const_iterator call_iterator;
+    for (call_iterator = calls.begin (); call_iterator != calls.end (); call_iterator++)
     {
-        send_info (call_iterator->getCallId (), "text/plain", message);
+        send_info (callList->getCallId (*call_iterator), "text/plain", message);
     }
 }
 
-const char *
+const LayoutGeometry *
 Conference720p::get_next_layout ()
 {
-    switch (layout_)
-    {
-    // Layouts rotate between 4 -> 6 -> 9 -> 4   
-/****** JH
-    case '1':
-        layout_ = '2';
-        break;
-    case '2':
-        layout_ = '4';
-        //return custom4PartyLayout();
-        return "4";
-        break;
-*************/
-    case '4':
-        layout_ = '6';
-        return "6";
-        break;
-    case '6':
-        layout_ = '9';
-        return "9";
-        break;
-    case '9':
-        layout_ = '4';
-        return "4";
-        break;
-    }
-    return &layout_;
+    // Layouts rotate 4 -> 6 -> 9 -> 16 -> 25 -> any from the layouts file -> 4
+    layout_ = LayoutTable::Instance ()->next (layout_);
+    regions_.setLayout (layout_->getNumRegions ());
+    return layout_;
 }
 
 void
 Conference720p::turnOnCaption (int region)
 {
     LOGDEBUG ("Turning conferee caption on for region " << region);
-    std::string showCallerId = showCallerIdOverlay (region, "XXXX for now");
-    update_conference (conf_id_, NULL, NULL, showCallerId.c_str ());
+    queueOverlay (showCallerIdOverlay, region, "XXXX for now");
 }
 
 void
 Conference720p::turnOffCaption (int region)
 {
     LOGDEBUG ("Turning conferee caption off for region " << region);
-    std::string delCallerId = deleteCallerIdOverlay (region);
-    update_conference (conf_id_, NULL, NULL, delCallerId.c_str ());
+    queueOverlay (deleteCallerIdOverlay, region);
 }
 
 void
 Conference720p::turnOnAllCaptions ()
 {
     LOGDEBUG ("Turning conferee captions on");
-    std::vector < Call >::iterator call_iterator;
-    // Need to make list public - can't get it with accessor?
+    Calls *callList = &calls_;
+    const std::vector < CallHandle > &calls = callList->getCallList ();
+    std::vector < CallHandle >::const_iterator call_iterator;
     int confereeNum = 1;
 
     // Loop over all calls first
-    for (call_iterator = Calls::Instance ()->verification_calls_.begin ();
-         call_iterator != Calls::Instance ()->verification_calls_.end (); call_iterator++)
+    for (call_iterator = calls.begin (); call_iterator != calls.end (); call_iterator++)
     {
-        LOGDEBUG ("Turning conferee caption on for region " << call_iterator->getConfRegion ());
+        LOGDEBUG ("Turning conferee caption on for region " << callList->getConfRegion (*call_iterator));
         char caption[32];
         sprintf (caption, "Conferee #%d", confereeNum);
-        std::string showCallerId = showCallerIdOverlay (call_iterator->getConfRegion (), caption);
-        update_conference (conf_id_, NULL, NULL, showCallerId.c_str ());
+        queueOverlay (showCallerIdOverlay, callList->getConfRegion (*call_iterator), caption);
 
         confereeNum++;
     }
 
     // Now loop over any videos playing
-    std::vector < ConfVideoPlay >::iterator conf_play_iterator;
+    ConfVideoPlays *playList = &plays_;
+    const std::vector < PlayHandle > &plays = playList->getConfVideoPlayList ();
+    std::vector < PlayHandle >::const_iterator conf_play_iterator;
 
-    for (conf_play_iterator = ConfVideoPlays::Instance ()->conf_video_plays_.begin ();
-         conf_play_iterator != ConfVideoPlays::Instance ()->conf_video_plays_.end (); conf_play_iterator++)
+    for (conf_play_iterator = plays.begin (); conf_play_iterator != plays.end (); conf_play_iterator++)
     {
-        std::string showVidLabel = showVideoLabelOverlay (conf_play_iterator->getConfVideoPlayRegion ());
-        update_conference (conf_id_, NULL, NULL, showVidLabel.c_str ());
+        queueOverlay (showVideoLabelOverlay, playList->getConfVideoPlayRegion (*conf_play_iterator));
     }
 }
 
@@ -174,16 +215,15 @@ void
 Conference720p::turnOffAllCaptions ()
 {
     LOGDEBUG ("Turning conferee captions off");
-    std::vector < Call >::iterator call_iterator;
+    Calls *callList = &calls_;
+    const std::vector < CallHandle > &calls = callList->getCallList ();
+    std::vector < CallHandle >::const_iterator call_iterator;
     int confereeNum = 1;
-    std::string delCallerId;
 
     // Loop over calls first
-    for (call_iterator = Calls::Instance ()->verification_calls_.begin ();
-         call_iterator != Calls::Instance ()->verification_calls_.end (); call_iterator++)
+    for (call_iterator = calls.begin (); call_iterator != calls.end (); call_iterator++)
     {
-        delCallerId = deleteCallerIdOverlay (call_iterator->getConfRegion ());
-        update_conference (conf_id_, NULL, NULL, delCallerId.c_str ());
+        queueOverlay (deleteCallerIdOverlay, callList->getConfRegion (*call_iterator));
         confereeNum++;
     }
 
@@ -195,14 +235,14 @@ void
 Conference720p::turnOffVideoLabels ()
 {
     //char xmlString[128];
-    std::vector < ConfVideoPlay >::iterator conf_play_iterator;
+    ConfVideoPlays *playList = &plays_;
+    const std::vector < PlayHandle > &plays = playList->getConfVideoPlayList ();
+    std::vector < PlayHandle >::const_iterator conf_play_iterator;
 
     // Loop over any videos playing
-    for (conf_play_iterator = ConfVideoPlays::Instance ()->conf_video_plays_.begin ();
-         conf_play_iterator != ConfVideoPlays::Instance ()->conf_video_plays_.end (); conf_play_iterator++)
+    for (conf_play_iterator = plays.begin (); conf_play_iterator != plays.end (); conf_play_iterator++)
     {
-        std::string deleteVidLabel = deleteVideoLabelOverlay (conf_play_iterator->getConfVideoPlayRegion ());
-        update_conference (conf_id_, NULL, NULL, deleteVidLabel.c_str ());
+        queueOverlay (deleteVideoLabelOverlay, playList->getConfVideoPlayRegion (*conf_play_iterator));
     }
 }
 
@@ -210,25 +250,21 @@ void
 Conference720p::moveRegionOverlays (const int fromRegion, const int toRegion)
 {
     // Delete overlay in fromRegion and activate in toRegion
-    if (Calls::Instance ()->isAudioMuteOnForCallId (Calls::Instance ()->getCallIdByConfRegion (fromRegion)))
+    if (calls_.isAudioMuteOnForRegion (fromRegion))
     {
         // Move the mute overlay to the new region
         LOGDEBUG ("Moving mic mute overlay from region " << fromRegion << " to region " << toRegion);
-        std::string deleteMicMute = deleteMicMuteOverlay (fromRegion);
-        update_conference (conf_id_, NULL, NULL, deleteMicMute.c_str ());
-        std::string showMicMute = showMicMuteOverlay (toRegion);
-        update_conference (conf_id_, NULL, NULL, showMicMute.c_str ());
+        queueOverlay (deleteMicMuteOverlay, fromRegion);
+        queueOverlay (showMicMuteOverlay, toRegion);
     }
-    if (Calls::Instance ()->isVideoHiddenForCallId (Calls::Instance ()->getCallIdByConfRegion (fromRegion)))
+    if (calls_.isVideoHiddenForRegion (fromRegion))
     {
         // Move the video hiding overlay to the new region
         LOGDEBUG ("Moving video hiding overlay from region " << fromRegion << " to region " << toRegion);
 
-        std::string delBaghead = deleteBagheadOverlay (fromRegion);
-        update_conference (conf_id_, NULL, NULL, delBaghead.c_str ());
+        queueOverlay (deleteBagheadOverlay, fromRegion);
 
-        std::string showBaghead = showBagheadOverlay (toRegion);
-        update_conference (conf_id_, NULL, NULL, showBaghead.c_str ());
+        queueOverlay (showBagheadOverlay, toRegion);
     }
 }
 
@@ -236,19 +272,17 @@ void
 Conference720p::copyRegionOverlays (const int fromRegion, const int toRegion)
 {
     // Same as moveRegionOverlays, but do not remove fromRegion overlay
-    if (Calls::Instance ()->isAudioMuteOnForCallId (Calls::Instance ()->getCallIdByConfRegion (fromRegion)))
+    if (calls_.isAudioMuteOnForRegion (fromRegion))
     {
         // Move the mute overlay to the new region
         LOGDEBUG ("Copying mic mute overlay from region " << fromRegion << " to region " << toRegion);
-        std::string showMicMute = showMicMuteOverlay (toRegion);
-        update_conference (conf_id_, NULL, NULL, showMicMute.c_str ());
+        queueOverlay (showMicMuteOverlay, toRegion);
     }
-    if (Calls::Instance ()->isVideoHiddenForCallId (Calls::Instance ()->getCallIdByConfRegion (fromRegion)))
+    if (calls_.isVideoHiddenForRegion (fromRegion))
     {
         // Move the video hiding overlay to the new region
         LOGDEBUG ("Copying video hiding overlay from region " << fromRegion << " to region " << toRegion);
-        std::string showBaghead = showBagheadOverlay (toRegion);
-        update_conference (conf_id_, NULL, NULL, showBaghead.c_str ());
+        queueOverlay (showBagheadOverlay, toRegion);
     }
 }
 
@@ -256,223 +290,19 @@ int
 Conference720p::get_next_region (const int region)
 {
     // Next region to rotate into depends on current layout
-    switch (layout_)
-    {
-    case '1':
-        return 0;
-        break;
-    case '2':
-        if (region == 2)
-            return 1;
-        else
-            return region + 1;
-        break;
-    case '4':
-        if (region == 4)
-            return 1;
-        else
-            return region + 1;
-        break;
-    case '6':
-        if (region == 6)
-            return 1;
-        else
-            return region + 1;
-        break;
-    case '9':
-        if (region == 9)
-            return 1;
-        else
-            return region + 1;
-        break;
-    }
-    return 0;
+    return regions_.nextInLayout (region);
 }
 
 bool
 Conference720p::is_region_max_for_layout (const int region)
 {
-    switch (layout_)
-    {
-    case '1':
-        if (region == 1)
-            return true;
-        break;
-    case '2':
-        if (region == 2)
-            return true;
-        break;
-    case '4':
-        if (region == 4)
-            return true;
-        break;
-    case '6':
-        if (region == 6)
-            return true;
-        break;
-    case '9':
-        if (region == 9)
-            return true;
-        break;
-    }
-    return false;
+    return regions_.isMaxForLayout (region);
 }
 
 int
-Conference720p::find_clicked_region (const char *resolution, int layout, int posX, int posY)
+Conference720p::find_clicked_region (const char *resolution, int posX, int posY)
 {
-    int maxX;
-    int maxY;
-
-    if (strcmp (resolution, "cif") == 0)
-    {
-        maxX = 352;
-        maxY = 240;
-    }
-    else if (strcmp (resolution, "vga") == 0)
-    {
-        maxX = 640;
-        maxY = 480;
-    }
-    else if (strcmp (resolution, "720p") == 0)
-    {
-        maxX = 1280;
-        maxY = 720;
-    }
-    else
-    {
-        LOGERROR ("Unsupported resolution - " << resolution);
-        return NULL;
-    }
-
-    // 1,2,4,6,9 determine the region number returned
-    if (layout == 1)
-    {
-        if ((posX >= 0 && posX <= maxX) && (posY >= 0 && posY <= maxY))
-        {
-            return 1;
-        }
-        else
-        {
-            return NULL;
-        }
-    }
-    else if (layout == 2)
-    {
-        // Get a positive result when clicking on black bars above and below
-        // conferee, but maybe that's not bad.  This is the only layout
-        // with unused real estate
-        if ((posX >= 0 && posX <= maxX * .50) && (posY >= 0 && posY <= maxY))
-        {
-            return 1;
-        }
-        else if ((posX >= .50 * maxX && posX <= maxX) && (posY >= 0 && posY <= maxY))
-        {
-            return 2;
-        }
-        else
-        {
-            return NULL;
-        }
-    }
-    else if (layout == 4)
-    {
-        if ((posX >= 0 && posX <= maxX * .50) && (posY >= 0 && posY <= maxY * .50))
-        {
-            return 1;
-        }
-        else if ((posX >= 0 && posX <= maxX * .50) && (posY >= maxY * .50 && posY <= maxY))
-        {
-            return 2;
-        }
-        else if ((posX >= .50 * maxX && posX <= maxX) && (posY >= 0 && posY <= maxY * .50))
-        {
-            return 3;
-        }
-        else if ((posX >= .50 * maxX && posX <= maxX) && (posY >= maxY * .50 && posY <= maxY))
-        {
-            return 4;
-        }
-        else
-        {
-            return NULL;
-        }
-    }
-    else if (layout == 6)
-    {
-        if ((posX >= 0 && posX <= maxX * .66) && (posY >= 0 && posY <= maxY * .66))
-        {
-            return 1;
-        }
-        else if ((posX >= .66 * maxX && posX <= maxX) && (posY >= 0 && posY <= maxY * .33))
-        {
-            return 2;
-        }
-        else if ((posX >= .66 * maxX && posX <= maxX) && (posY >= maxY * .33 && posY <= maxY * .66))
-        {
-            return 3;
-        }
-        else if ((posX >= .66 * maxX && posX <= maxX) && (posY >= maxY * .66 && posY <= maxY))
-        {
-            return 4;
-        }
-        else if ((posX >= .33 * maxX && posX <= .66 * maxX) && (posY >= maxY * .66 && posY <= maxY))
-        {
-            return 5;
-        }
-        else if ((posX >= 0 && posX <= .33 * maxX) && (posY >= maxY * .66 && posY <= maxY))
-        {
-            return 6;
-        }
-        else
-        {
-            return NULL;
-        }
-    }
-    else if (layout == 9)
-    {
-        if ((posX >= 0 && posX <= maxX * .33) && (posY >= 0 && posY <= maxY * .33))
-        {
-            return 1;
-        }
-        else if ((posX >= 0 && posX <= maxX * .33) && (posY >= .33 * maxY && posY <= maxY * .66))
-        {
-            return 2;
-        }
-        else if ((posX >= 0 && posX <= maxX * .33) && (posY >= .66 * maxY && posY <= maxY))
-        {
-            return 3;
-        }
-        else if ((posX >= .33 * maxX && posX <= .66 * maxX) && (posY >= 0 && posY <= .33 * maxY))
-        {
-            return 4;
-        }
-        else if ((posX >= .33 * maxX && posX <= .66 * maxX) && (posY >= maxY * .33 && posY <= .66 * maxY))
-        {
-            return 5;
-        }
-        else if ((posX >= .33 * maxX && posX <= .66 * maxX) && (posY >= maxY * .66 && posY <= maxY))
-        {
-            return 6;
-        }
-        else if ((posX >= .66 * maxX && posX <= maxX) && (posY >= 0 && posY <= .33 * maxY))
-        {
-            return 7;
-        }
-        else if ((posX >= .66 * maxX && posX <= maxX) && (posY >= maxY * .33 && posY <= .66 * maxY))
-        {
-            return 8;
-        }
-        else if ((posX >= .66 * maxX && posX <= maxX) && (posY >= maxY * .66 && posY <= maxY))
-        {
-            return 9;
-        }
-        else
-        {
-            return NULL;
-        }
-    }
-    return 0;
+    return LayoutTable::findClickedRegion (layout_, resolution, posX, posY);
 }
 
 void
@@ -483,26 +313,28 @@ Conference720p::resetDemo ()
     // Next call after this will start a new conference
     LOGDEBUG ("720p Conference reset");
     //Loop over all videos, stopping them
-    ConfVideoPlays::Instance ()->stopAllConfVideoPlays ();
+    plays_.stopAllConfVideoPlays ();
 
     // Destroy the conference.  This will automatically remove conference parties first
+    flushOverlays ();
     destroy_conference (conf_id_);
     conf_id_ = "";
 
     //  Loop over all open calls and hang them up.
-    std::vector < Call >::iterator call_iterator;
-    for (call_iterator = Calls::Instance ()->verification_calls_.begin ();
-         call_iterator != Calls::Instance ()->verification_calls_.end (); call_iterator++)
+    Calls *callList = &calls_;
+    const std::vector < CallHandle > &calls = callList->getCallList ();
+    std::vector < CallHandle >::const_iterator call_iterator;
+    for (call_iterator = calls.begin (); call_iterator != calls.end (); call_iterator++)
     {
-        LOGDEBUG ("Hanging up call " << call_iterator->getCallId ());
-        hangup (call_iterator->getCallId ());
+        LOGDEBUG ("Hanging up call " << callList->getCallId (*call_iterator));
+        hangup (callList->getCallId (*call_iterator));
         decNumCallers ();
-        int region = call_iterator->getConfRegion ();
+        int region = callList->getConfRegion (*call_iterator);
         LOGDEBUG ("Relinquishing conference region " << region);
         clear_region (region);
     }
     // Nobody left; clear the list of all calls
-    Calls::Instance ()->clearAllCalls ();
+    calls_.clearAllCalls ();
     // Resets for a  new conference on next call
     // Note that destroying a conference will internally kill
     // all overlays associated with the conference.  Saves
@@ -515,10 +347,10 @@ Conference720p::rotate_to_next_region ()
 {
     // Loop over all possible regions
     set_all_regions_not_processed ();
-    const char *displacedPlayFromRegionOne = NULL;
+    PlayHandle displacedPlayFromRegionOne = NO_PLAY;
     const char *displacedCallFromRegionOne = NULL;
     bool wrappedFromMaxToOne = false;
-    for (int curRegion = 9; curRegion >= 1; curRegion--)
+    for (int curRegion = regions_.highestUsed (); curRegion >= 1; curRegion--)
     {
         LOGDEBUG ("Looking at region " << curRegion << " Used: " << is_region_used (curRegion) <<
                   "  Not Processed: " << is_region_not_processed (curRegion) <<
@@ -528,7 +360,7 @@ Conference720p::rotate_to_next_region ()
         {
             if (is_region_not_processed (curRegion))
             {
-                const char *callId = Calls::Instance ()->getCallIdByConfRegion (curRegion);
+                const char *callId = calls_.getCallIdByConfRegion (curRegion);
                 LOGDEBUG ("Examine region " << curRegion << " for Call Id. Have: " << callId);
                 if (callId != NULL)
                 {
@@ -545,7 +377,7 @@ Conference720p::rotate_to_next_region ()
                         if (displacedCallFromRegionOne)
                         {
                             LOGDEBUG ("Restoring displaced call from region one into region two");
-                            if (Calls::Instance ()->isAudioMuteOnForCallId (callId))
+                            if (calls_.isAudioMuteOnForCallId (callId))
                             {
                                 update_party (displacedCallFromRegionOne, "recvonly", "sendrecv", "2");
                             }
@@ -554,72 +386,60 @@ Conference720p::rotate_to_next_region ()
                                 update_party (displacedCallFromRegionOne, "sendrecv", "sendrecv", "2");
                             }
                             set_region (2);
-                            Calls::Instance ()->setCallRegionByCallId (displacedCallFromRegionOne, 2);
-                            if (Calls::Instance ()->getCallIdByConfRegion (2) != NULL)
+                            calls_.setCallRegionByCallId (displacedCallFromRegionOne, 2);
+                            if (calls_.getCallIdByConfRegion (2) != NULL)
                             {
                                 // Adjust overlays for region2 
-                                LOGDEBUG ("AUDIOON region 2 = " << Calls::
-                                          Instance ()->isAudioMuteOnForCallId ((Calls::Instance ()->getCallIdByConfRegion (2))));
-                                LOGDEBUG ("VIDEOHIDDEN region 2 = " << Calls::
-                                          Instance ()->isVideoHiddenForCallId (Calls::Instance ()->getCallIdByConfRegion (2)));
-                                if (Calls::Instance ()->isAudioMuteOnForCallId (Calls::Instance ()->getCallIdByConfRegion (2)))
+                                LOGDEBUG ("AUDIOON region 2 = " << calls_.isAudioMuteOnForRegion (2));
+                                LOGDEBUG ("VIDEOHIDDEN region 2 = " << calls_.isVideoHiddenForRegion (2));
+                                if (calls_.isAudioMuteOnForRegion (2))
                                 {
-                                    std::string showMicMute = showMicMuteOverlay (2);
-                                    update_conference (conf_id_, NULL, NULL, showMicMute.c_str ());
+                                    queueOverlay (showMicMuteOverlay, 2);
                                 }
                                 else
                                 {
-                                    std::string deleteMicMute = deleteMicMuteOverlay (2);
-                                    update_conference (conf_id_, NULL, NULL, deleteMicMute.c_str ());
+                                    queueOverlay (deleteMicMuteOverlay, 2);
                                 }
-                                if (Calls::Instance ()->isVideoHiddenForCallId (Calls::Instance ()->getCallIdByConfRegion (2)))
+                                if (calls_.isVideoHiddenForRegion (2))
                                 {
-                                    std::string showBaghead = showBagheadOverlay (2);
-                                    update_conference (conf_id_, NULL, NULL, showBaghead.c_str ());
+                                    queueOverlay (showBagheadOverlay, 2);
                                 }
                                 else
                                 {
-                                    std::string delBaghead = deleteBagheadOverlay (2);
-                                    update_conference (conf_id_, NULL, NULL, delBaghead.c_str ());
+                                    queueOverlay (deleteBagheadOverlay, 2);
                                 }
                             }
 
-                            if (Calls::Instance ()->getCallIdByConfRegion (1) != NULL)
+                            if (calls_.getCallIdByConfRegion (1) != NULL)
                             {
                                 // Adjust overlays for region 1
-                                LOGDEBUG ("AUDIOON region 1 = " << Calls::
-                                          Instance ()->isAudioMuteOnForCallId ((Calls::Instance ()->getCallIdByConfRegion (1))));
-                                LOGDEBUG ("VIDEOHIDDEN region 1 = " << Calls::
-                                          Instance ()->isVideoHiddenForCallId (Calls::Instance ()->getCallIdByConfRegion (1)));
-                                if (Calls::Instance ()->isAudioMuteOnForCallId (Calls::Instance ()->getCallIdByConfRegion (1)))
+                                LOGDEBUG ("AUDIOON region 1 = " << calls_.isAudioMuteOnForRegion (1));
+                                LOGDEBUG ("VIDEOHIDDEN region 1 = " << calls_.isVideoHiddenForRegion (1));
+                                if (calls_.isAudioMuteOnForRegion (1))
                                 {
-                                    std::string showMicMute = showMicMuteOverlay (1);
-                                    update_conference (conf_id_, NULL, NULL, showMicMute.c_str ());
+                                    queueOverlay (showMicMuteOverlay, 1);
                                 }
                                 else
                                 {
-                                    std::string deleteMicMute = deleteMicMuteOverlay (1);
-                                    update_conference (conf_id_, NULL, NULL, deleteMicMute.c_str ());
+                                    queueOverlay (deleteMicMuteOverlay, 1);
                                 }
-                                if (Calls::Instance ()->isVideoHiddenForCallId (Calls::Instance ()->getCallIdByConfRegion (1)))
+                                if (calls_.isVideoHiddenForRegion (1))
                                 {
-                                    std::string showBaghead = showBagheadOverlay (1);
-                                    update_conference (conf_id_, NULL, NULL, showBaghead.c_str ());
+                                    queueOverlay (showBagheadOverlay, 1);
                                 }
                                 else
                                 {
-                                    std::string delBaghead = deleteBagheadOverlay (1);
-                                    update_conference (conf_id_, NULL, NULL, delBaghead.c_str ());
+                                    queueOverlay (deleteBagheadOverlay, 1);
                                 }
                             }
                         }
                         LOGDEBUG ("Displaced region one play = " << displacedPlayFromRegionOne);
-                        if (displacedPlayFromRegionOne)
+                        if (displacedPlayFromRegionOne != NO_PLAY)
                         {
                             LOGDEBUG ("Restoring displaced play from region one into region two");
-                            update_play (displacedPlayFromRegionOne, NULL, "2");
+                            update_play (plays_.getConfVideoPlayId (displacedPlayFromRegionOne), NULL, "2");
                             set_region (2);
-                            ConfVideoPlays::Instance ()->setConfVideoPlayRegionByPlayId (displacedPlayFromRegionOne, 2);
+                            plays_.setConfVideoPlayRegion (displacedPlayFromRegionOne, 2);
                         }
                         // Done with region one; exit loop
                         break;
@@ -631,15 +451,15 @@ Conference720p::rotate_to_next_region ()
                         wrappedFromMaxToOne = true;
                         // If region one is occupied, save its contents
                         LOGDEBUG ("Saving whatever is in region one (if anyithing) as displaced");
-                        displacedCallFromRegionOne = Calls::Instance ()->getCallIdByConfRegion (1);
-                        displacedPlayFromRegionOne = ConfVideoPlays::Instance ()->getVideoPlayIdByConfRegion (1);
+                        displacedCallFromRegionOne = calls_.getCallIdByConfRegion (1);
+                        displacedPlayFromRegionOne = plays_.getVideoPlayByConfRegion (1);
                     }
                     // Normal region processing
                     nextRegion = get_next_region (curRegion);
                     LOGDEBUG ("Video call with call ID " << callId << " in region " << curRegion << " moving to region " <<
                               nextRegion);
                     moveRegionOverlays (curRegion, nextRegion);
-                    Calls::Instance ()->setCallRegionByCallId (callId, nextRegion);
+                    calls_.setCallRegionByCallId (callId, nextRegion);
                     clear_region (curRegion);
                     set_region (nextRegion);
                     set_region_processed (curRegion);
@@ -654,10 +474,11 @@ Conference720p::rotate_to_next_region ()
                 else
                 {
                     LOGDEBUG ("Look for play in region" << curRegion);
-                    const char *playId = ConfVideoPlays::Instance ()->getVideoPlayIdByConfRegion (curRegion);
-                    LOGDEBUG ("Examine region " << curRegion << " for Play Id. Have: " << playId);
-                    if (playId != NULL)
+                    PlayHandle play = plays_.getVideoPlayByConfRegion (curRegion);
+                    LOGDEBUG ("Examine region " << curRegion << " for Play handle. Have: " << play);
+                    if (play != NO_PLAY)
                     {
+                        const char *playId = plays_.getConfVideoPlayId (play);
                         LOGDEBUG ("Play found in region " << curRegion);
                         int nextRegion;
                         char nextRegionString[10];
@@ -672,38 +493,36 @@ Conference720p::rotate_to_next_region ()
                                 LOGDEBUG ("Duct Tape 2");
                                 LOGDEBUG ("Restoring displaced call from region one into region two");
                                 // JH duct tape for disappearing party on restore to region 2
-                                if (Calls::Instance ()->isAudioMuteOnForCallId (callId))
+                                if (calls_.isAudioMuteOnForCallId (callId))
                                     update_party (displacedCallFromRegionOne, "recvonly", "sendrecv", "2");
                                 else
                                     update_party (displacedCallFromRegionOne, "sendrecv", "sendrecv", "2");
                                 set_region (2);
-                                Calls::Instance ()->setCallRegionByCallId (displacedCallFromRegionOne, 2);
-                                if (Calls::Instance ()->isAudioMuteOnForCallId (Calls::Instance ()->getCallIdByConfRegion (2)))
+                                calls_.setCallRegionByCallId (displacedCallFromRegionOne, 2);
+                                if (calls_.isAudioMuteOnForRegion (2))
                                 {
                                     LOGDEBUG ("Turn on mic mute overlay in region 2");
-                                    std::string showMicMute = showMicMuteOverlay (2);
-                                    update_conference (conf_id_, NULL, NULL, showMicMute.c_str ());
+                                    queueOverlay (showMicMuteOverlay, 2);
                                 }
                                 else
                                 {
-                                    std::string deleteMicMute = deleteMicMuteOverlay (2);
-                                    update_conference (conf_id_, NULL, NULL, deleteMicMute.c_str ());
+                                    queueOverlay (deleteMicMuteOverlay, 2);
                                 }
-                                if (Calls::Instance ()->isVideoHiddenForCallId (Calls::Instance ()->getCallIdByConfRegion (2)))
+                                if (calls_.isVideoHiddenForRegion (2))
                                 {
                                     // Move the video hiding overlay to the new region
                                     LOGDEBUG ("Turn on video hide overlay in region 2");
-                                    std::string showBaghead = showBagheadOverlay (2);
-                                    update_conference (conf_id_, NULL, NULL, showBaghead.c_str ());
+                                    queueOverlay (showBagheadOverlay, 2);
                                 }
                             }
                             LOGDEBUG ("Displaced region one play = " << displacedPlayFromRegionOne);
-                            if (displacedPlayFromRegionOne)
+                            if (displacedPlayFromRegionOne != NO_PLAY)
                             {
                                 LOGDEBUG ("Restoring displaced play from region one into region two");
-                                update_play (displacedPlayFromRegionOne, NULL, "2");
+                                update_play (plays_.getConfVideoPlayId (displacedPlayFromRegionOne), NULL,
+                                             "2");
                                 set_region (2);
-                                ConfVideoPlays::Instance ()->setConfVideoPlayRegionByPlayId (displacedPlayFromRegionOne, 2);
+                                plays_.setConfVideoPlayRegion (displacedPlayFromRegionOne, 2);
                             }
                             // Done with region one; exit loop
                             break;
@@ -715,14 +534,14 @@ Conference720p::rotate_to_next_region ()
                             LOGDEBUG ("Saving whatever is in region one (if anyithing) as displaced");
 
                             // If region one is occupied, save its contents
-                            displacedCallFromRegionOne = Calls::Instance ()->getCallIdByConfRegion (1);
-                            displacedPlayFromRegionOne = ConfVideoPlays::Instance ()->getVideoPlayIdByConfRegion (1);
+                            displacedCallFromRegionOne = calls_.getCallIdByConfRegion (1);
+                            displacedPlayFromRegionOne = plays_.getVideoPlayByConfRegion (1);
                         }
                         // Normal processing
                         nextRegion = get_next_region (curRegion);
                         LOGDEBUG ("Video play with play ID " << playId << " in region " << curRegion << " moving to region "
                                   << nextRegion);
-                        ConfVideoPlays::Instance ()->setConfVideoPlayRegionByPlayId (playId, nextRegion);
+                        plays_.setConfVideoPlayRegion (play, nextRegion);
                         clear_region (curRegion);
                         set_region (nextRegion);
                         set_region_processed (curRegion);
@@ -737,8 +556,37 @@ Conference720p::rotate_to_next_region ()
     }
 }
 
+void
+Conference720p::queueOverlay (const OverlayTemplate & overlay, int region, const char *text, int slide)
+{
+    // XMS takes a ';' separated list of overlay definitions in one
+    // region_overlays attribute. Collect them; flushOverlays() sends them.
+    // The payload is written straight into the batch
+    if (!overlayBatch_.empty ())
+        overlayBatch_ += ';';
+    overlay.appendTo (overlayBatch_, region, text, slide);
+}
+
+void
+Conference720p::flushOverlays ()
+{
+    if (overlayBatch_.empty ())
+        return;
+    if (!conf_id_.empty ())
+        update_conference (conf_id_, NULL, NULL, overlayBatch_.c_str ());
+    overlayBatch_.clear ();
+}
+
 void
 Conference720p::onEvent (xmsEventParser * eventParser)
+{
+    // All overlay changes made for one event go out in a single PUT
+    handleEvent (eventParser);
+    flushOverlays ();
+}
+
+void
+Conference720p::handleEvent (xmsEventParser * eventParser)
 {
     std::string eventType = eventParser->getEventType ();
     LOGDEBUG ("Conference720p app handling event");
@@ -746,20 +594,24 @@ Conference720p::onEvent (xmsEventParser * eventParser)
 
     {
         std::string call_id = eventParser->findValByKey ("call_id");
+        // Intern the call ID; from here on the call is known by its handle
+        calls_.addNewCall (call_id.c_str ());
 
         if (isVeryFirstCall ())
         {
             // On first call, create a conference, reserving no resources,
-            // with a max of 9 parties, 4 tiles, 720p resolution
-            conf_id_ = create_conference ("0", "9", "4", "720p");
+            // with a max of 25 parties (the largest layout), 4 tiles, 720p
+            // resolution
+            conf_id_ = create_conference ("0", "25", "4", "720p");
             LOGDEBUG ("First call - created new conference " << conf_id_);
             didVeryFirstCall ();
         }
 
         incNumCallers ();
-        if (getNumCallers () > 6)
+        // One region each in the largest layout
+        if (getNumCallers () > RegionAllocator::MAX_REGIONS)
         {
-            LOGDEBUG ("Exceeding six callers allowed in 720p Conference demo. Not accepting call.");
+            LOGDEBUG ("Exceeding " << RegionAllocator::MAX_REGIONS << " callers allowed in 720p Conference demo. Not accepting call.");
             hangup (call_id);
             decNumCallers ();
             return;
@@ -778,7 +630,7 @@ Conference720p::onEvent (xmsEventParser * eventParser)
         char region_string[10];
         sprintf (region_string, "%d", region);
         // Who's where bookkeeping
-        Calls::Instance ()->setConfRegionById (call_id.c_str (), region);
+        calls_.setConfRegionById (call_id.c_str (), region);
 
         LOGDEBUG ("Adding party to conference " << conf_id_ << " in region " << region);
         add_party (call_id, conf_id_, region_string);
@@ -802,25 +654,23 @@ Conference720p::onEvent (xmsEventParser * eventParser)
         decNumCallers ();
         std::string call_id = eventParser->findValByKey ("call_id");
 
-        int region = Calls::Instance ()->getConfRegionByCallId (call_id.c_str ());
-        if (Calls::Instance ()->isAudioMuteOnForCallId (call_id.c_str ()))
+        int region = calls_.getConfRegionByCallId (call_id.c_str ());
+        if (calls_.isAudioMuteOnForCallId (call_id.c_str ()))
         {
             // Get rid of muted microphone overlay
             LOGDEBUG ("Removing mic mute overlay from region " << region);
-            std::string deleteMicMute = deleteMicMuteOverlay (region);
-            update_conference (conf_id_, NULL, NULL, deleteMicMute.c_str ());
+            queueOverlay (deleteMicMuteOverlay, region);
         }
-        if (Calls::Instance ()->isVideoHiddenForCallId (call_id.c_str ()))
+        if (calls_.isVideoHiddenForCallId (call_id.c_str ()))
         {
             // Get rid of video hiding overlay
             LOGDEBUG ("Removing video hiding overlay from region " << region);
-            std::string delBaghead = deleteBagheadOverlay (region);
-            update_conference (conf_id_, NULL, NULL, delBaghead.c_str ());
+            queueOverlay (deleteBagheadOverlay, region);
         }
         LOGDEBUG ("Relinquishing conference region " << region);
         clear_region (region);
         LOGDEBUG ("Removing " << call_id << " from active call list");
-        Calls::Instance ()->delCall (call_id.c_str ());
+        calls_.delCall (call_id.c_str ());
         if (areCaptionsOn ())
             turnOffCaption (region);
         if (getNumCallers () == 0)
@@ -829,14 +679,12 @@ Conference720p::onEvent (xmsEventParser * eventParser)
             if (scrollingOverlayOn ())
             {
                 LOGDEBUG ("Turning scrolling overlay off");
-                std::string delTicker = deleteStockTickerOverlay (0);
-                update_conference (conf_id_, NULL, NULL, delTicker.c_str ());
+                queueOverlay (deleteStockTickerOverlay, 0);
             }
             if (slideShowOn ())
             {
                 LOGDEBUG ("Turning slide show off");
-                std::string delSlide = deleteSlideOverlay (0);
-                update_conference (conf_id_, NULL, NULL, delSlide.c_str ());
+                queueOverlay (deleteSlideOverlay, 0);
                 setSlideShowOff ();
             }
             if (strlen (getExclusiveMediaOp ()) != 0)
@@ -846,6 +694,7 @@ Conference720p::onEvent (xmsEventParser * eventParser)
             }
             // Destroy conference and reset so a new one is started for next caller
             LOGDEBUG ("Destroy conference " << conf_id_ << " and reset for a new one");
+            flushOverlays ();
             destroy_conference (conf_id_);
             conf_id_ = "";
             resetConference ();
@@ -864,8 +713,7 @@ Conference720p::onEvent (xmsEventParser * eventParser)
                 // Notify all callers of record in progress
                 notify_all_callers ("720p Conference now being recorded...");
                 // Put a recording icon on the screen
-                std::string showMicOn = showMicOnOverlay (0);
-                update_conference (conf_id_, NULL, NULL, showMicOn.c_str ());
+                queueOverlay (showMicOnOverlay, 0);
                 std::string media_id = record_conference (conf_id_,
                                                           "file://restconfdemo/conf_recording.wav",
                                                           "audio/x-wav",
@@ -914,9 +762,8 @@ Conference720p::onEvent (xmsEventParser * eventParser)
                                                            "file://restconfdemo",
                                                            "conf_recording.vid",
                                                            "video/x-vid", "file://restconfdemo", region_string, "0");
-                    ConfVideoPlay recordingPlay (conf_id_, media_id.c_str (), region);
-                    ConfVideoPlays::Instance ()->addNewPlay (recordingPlay);
-                    ConfVideoPlays::Instance ()->printConfVideoPlayList ();
+                    plays_.addNewPlay (conf_id_, media_id.c_str (), region);
+                    plays_.printConfVideoPlayList ();
                 }
                 else
                 {
@@ -945,8 +792,7 @@ Conference720p::onEvent (xmsEventParser * eventParser)
                     setExclusiveMediaOp (media_id.c_str ());
                     if (areCaptionsOn ())
                     {
-                        std::string showVidLabel = showVideoLabelOverlay (0);
-                        update_conference (conf_id_, NULL, NULL, showVidLabel.c_str ());
+                        queueOverlay (showVideoLabelOverlay, 0);
                     }
                 }
                 else
@@ -978,13 +824,11 @@ Conference720p::onEvent (xmsEventParser * eventParser)
                                                            "file://restconfdemo",
                                                            "Dialogic_NetworkFuel.vid", "video/x-vid",
                                                            "file://restconfdemo", region_string, "infinite");
-                    ConfVideoPlay recordingPlay (conf_id_, media_id.c_str (), region);
-                    ConfVideoPlays::Instance ()->addNewPlay (recordingPlay);
-                    ConfVideoPlays::Instance ()->printConfVideoPlayList ();
+                    plays_.addNewPlay (conf_id_, media_id.c_str (), region);
+                    plays_.printConfVideoPlayList ();
                     if (areCaptionsOn ())
                     {
-                        std::string showVidLabel = showVideoLabelOverlay (region);
-                        update_conference (conf_id_, NULL, NULL, showVidLabel.c_str ());
+                        queueOverlay (showVideoLabelOverlay, region);
                     }
                 }
                 else
@@ -1016,13 +860,11 @@ Conference720p::onEvent (xmsEventParser * eventParser)
                                                            "file://restconfdemo",
                                                            "sintel_short_clip.vid",
                                                            "video/x-vid", "file://restconfdemo", region_string, "infinite");
-                    ConfVideoPlay sintelPlay (conf_id_, media_id.c_str (), region);
-                    ConfVideoPlays::Instance ()->addNewPlay (sintelPlay);
-                    ConfVideoPlays::Instance ()->printConfVideoPlayList ();
+                    plays_.addNewPlay (conf_id_, media_id.c_str (), region);
+                    plays_.printConfVideoPlayList ();
                     if (areCaptionsOn ())
                     {
-                        std::string showVidLabel = showVideoLabelOverlay (region);
-                        update_conference (conf_id_, NULL, NULL, showVidLabel.c_str ());
+                        queueOverlay (showVideoLabelOverlay, region);
                     }
                 }
                 else
@@ -1044,7 +886,7 @@ Conference720p::onEvent (xmsEventParser * eventParser)
                 if (strlen (getExclusiveMediaOp ()) == 0)
                 {
                     LOGDEBUG ("Stopping any ongoing region videos");
-                    ConfVideoPlays::Instance ()->stopAllConfVideoPlays ();
+                    plays_.stopAllConfVideoPlays ();
                     LOGDEBUG ("Playing Network Fuel into full conference screen");
                     std::string media_id = play_into_conf (conf_id_,
                                                            "Dialogic_NetworkFuel.wav",
@@ -1094,7 +936,7 @@ Conference720p::onEvent (xmsEventParser * eventParser)
         else if (digit == "8")
         {
             LOGDEBUG ("Stopping all media play operations");
-            ConfVideoPlays::Instance ()->stopAllConfVideoPlays ();
+            plays_.stopAllConfVideoPlays ();
             if (strlen (getExclusiveMediaOp ()) != 0)
             {
                 LOGDEBUG ("Stopping exclusive media operation");
@@ -1112,8 +954,7 @@ Conference720p::onEvent (xmsEventParser * eventParser)
                 //  Scrolling overlay is on full conference screen "0"
                 LOGDEBUG ("Displaying scrolling overlay");
                 setScrollingOverlayOn ();
-                std::string showTicker = showStockTickerOverlay (0);
-                update_conference (conf_id_, NULL, NULL, showTicker.c_str ());
+                queueOverlay (showStockTickerOverlay, 0);
             }
             else
                 LOGDEBUG ("Scrolling overlay already on");
@@ -1124,8 +965,7 @@ Conference720p::onEvent (xmsEventParser * eventParser)
             {
                 LOGDEBUG ("Turning scrolling overlay off");
                 setScrollingOverlayOff ();
-                std::string delTicker = deleteStockTickerOverlay (0);
-                update_conference (conf_id_, NULL, NULL, delTicker.c_str ());
+                queueOverlay (deleteStockTickerOverlay, 0);
             }
             else
                 LOGDEBUG ("Scrolling overlay not on");
@@ -1137,8 +977,7 @@ Conference720p::onEvent (xmsEventParser * eventParser)
                 LOGDEBUG ("Displaying silde show");
                 setSlideShowOn ();
                 // Scrolling overlay is on full conference screen "0"
-                std::string slide = showSlideOverlay (0, 1);
-                update_conference (conf_id_, NULL, NULL, slide.c_str ());
+                queueOverlay (showSlideOverlay, 0, NULL, 1);
             }
             else
                 LOGDEBUG ("Slide show already on");
@@ -1148,8 +987,7 @@ Conference720p::onEvent (xmsEventParser * eventParser)
             if (slideShowOn ())
             {
                 LOGDEBUG ("Turning slide show off");
-                std::string delShow = deleteSlideOverlay (0);
-                update_conference (conf_id_, NULL, NULL, delShow.c_str ());
+                queueOverlay (deleteSlideOverlay, 0);
                 setSlideShowOff ();
             }
             else
@@ -1170,9 +1008,13 @@ Conference720p::onEvent (xmsEventParser * eventParser)
         else if (digit == "#")
         {
             LOGDEBUG ("Changing conference layout");
-            // Rotating over all layouts - 4, 6, 9 
-            //Standard regions
-            update_conference (conf_id_, get_next_layout (), NULL, NULL);
+            // Rotating over all layouts. XMS knows its standard ones by
+            // size; custom ones are sent region by region
+            const LayoutGeometry *layout = get_next_layout ();
+            if (layout->isStandard ())
+                update_conference (conf_id_, layout->getName ().c_str (), NULL, NULL);
+            else
+                update_conference (conf_id_, NULL, layout->getLayoutRegions ().c_str (), NULL);
         }
         else if (digit == "*")
         {
@@ -1204,21 +1046,20 @@ Conference720p::onEvent (xmsEventParser * eventParser)
     else if (eventType == "end_play")
     {
         LOGDEBUG ("End play event received");
-        if (ConfVideoPlays::Instance ()->areAnyConfPlaysActive ())
+        if (plays_.areAnyConfPlaysActive ())
         {
             // Mark region cleared and update play list
             std::string play_id = eventParser->findValByKey ("transaction_id");
-            int region = ConfVideoPlays::Instance ()->getConfRegionByPlayId (play_id.c_str ());
+            int region = plays_.getConfRegionByPlayId (play_id.c_str ());
             clear_region (region);
-            ConfVideoPlays::Instance ()->clearConfRegionByPlayId (play_id.c_str ());
-            ConfVideoPlays::Instance ()->delConfVideoPlay (play_id.c_str ());
-            ConfVideoPlays::Instance ()->printConfVideoPlayList ();
+            plays_.clearConfRegionByPlayId (play_id.c_str ());
+            plays_.delConfVideoPlay (play_id.c_str ());
+            plays_.printConfVideoPlayList ();
 
             // If captions are on
             if (areCaptionsOn ())
             {
-                std::string deleteVidLabel = deleteVideoLabelOverlay (region);
-                update_conference (conf_id_, NULL, NULL, deleteVidLabel.c_str ());
+                queueOverlay (deleteVideoLabelOverlay, region);
             }
         }
         if (strlen (getExclusiveMediaOp ()) != 0)
@@ -1234,8 +1075,7 @@ Conference720p::onEvent (xmsEventParser * eventParser)
         LOGDEBUG ("End record event received");
         notify_all_callers ("720p Conference recording terminated");
         // Remove recording icon from screen
-        std::string deleteMicOn = deleteMicOnOverlay (0);
-        update_conference (conf_id_, NULL, NULL, deleteMicOn.c_str ());
+        queueOverlay (deleteMicOnOverlay, 0);
 
         // Mark the Exclusive media operation as complete
         nullExclusiveMediaOp ();
@@ -1247,20 +1087,16 @@ Conference720p::onEvent (xmsEventParser * eventParser)
         std::string contentId = eventParser->findValByKey ("content_id");
         if (contentId == "slide1")
         {
-            std::string slide = showSlideOverlay (0, 2);
-            update_conference (conf_id_, NULL, NULL, slide.c_str ());
+            queueOverlay (showSlideOverlay, 0, NULL, 2);
         }
         else if (contentId == "slide2")
         {
-            std::string slide = showSlideOverlay (0, 3);
-            update_conference (conf_id_, NULL, NULL, slide.c_str ());
+            queueOverlay (showSlideOverlay, 0, NULL, 3);
         }
         else
         {
-            std::string delShow = deleteSlideOverlay (0);
-            update_conference (conf_id_, NULL, NULL, delShow.c_str ());
-            std::string slide = showSlideOverlay (0, 1);
-            update_conference (conf_id_, NULL, NULL, slide.c_str ());
+            queueOverlay (deleteSlideOverlay, 0);
+            queueOverlay (showSlideOverlay, 0, NULL, 1);
         }
     }
     else if (eventType == "info")
@@ -1288,16 +1124,16 @@ Conference720p::onEvent (xmsEventParser * eventParser)
                 /*** If the click is from an Android, simply interpret the click as "mute/unmute me"
                 if (strcmp (userName, "android") == 0)
                 {
-                    if (Calls::Instance ()->isAudioMuteOnForCallId (infoCallId))
+                    if (calls_.isAudioMuteOnForCallId (infoCallId))
                     {
                         update_party (infoCallId, "sendrecv", "sendrecv", NULL, NULL, NULL);
-                        Calls::Instance ()->setAudioUnmutedByCallId (infoCallId);
+                        calls_.setAudioUnmutedByCallId (infoCallId);
                         LOGDEBUG ("Setting call ID " << infoCallId << " to unmuted ");
                     }
                     else
                     {
                         update_party (infoCallId, "recvonly", "recvonly", NULL, NULL, NULL);
-                        Calls::Instance ()->setAudioMutedByCallId (infoCallId);
+                        calls_.setAudioMutedByCallId (infoCallId);
                         LOGDEBUG ("Setting call ID " << infoCallId << " to muted ");
                     }
                     return;
@@ -1305,12 +1141,11 @@ Conference720p::onEvent (xmsEventParser * eventParser)
 
             // Otherwise, we need to be more clever - get the region clicked and see if the conference
             // controller is the clicker, and allow or not allow                            
-            int region = find_clicked_region ("720p", get_cur_layout (),
-                                              posX, posY);
-            LOGDEBUG ("Layout is " << get_cur_layout () << " so region " << region << " was clicked");
+            int region = find_clicked_region ("720p", posX, posY);
+            LOGDEBUG ("Layout is " << layout_->getName () << " so region " << region << " was clicked");
             if (region != 0)
             {
-                const char *regionCallId = Calls::Instance ()->getCallIdByConfRegion (region);
+                const char *regionCallId = calls_.getCallIdByConfRegion (region);
                 if (regionCallId != NULL)
                 {
                     if (strcmp (function, "mute") == 0)
@@ -1322,20 +1157,18 @@ Conference720p::onEvent (xmsEventParser * eventParser)
                             (strcmp (userName, "controller") == 0) || (strcmp (userName, "ctrlr") == 0) ||
                             (strcmp (infoCallId.c_str (), regionCallId) == 0))
                         {
-                            if (Calls::Instance ()->isAudioMuteOnForCallId (regionCallId))
+                            if (calls_.isAudioMuteOnForCallId (regionCallId))
                             {
-                                std::string deleteMicMute = deleteMicMuteOverlay (region);
-                                update_conference (conf_id_, NULL, NULL, deleteMicMute.c_str ());
+                                queueOverlay (deleteMicMuteOverlay, region);
                                 update_party (regionCallId, "sendrecv", "sendrecv", NULL);
-                                Calls::Instance ()->setAudioUnmutedByCallId (regionCallId);
+                                calls_.setAudioUnmutedByCallId (regionCallId);
                                 LOGDEBUG ("Setting call ID " << regionCallId << " to unmuted ");
                             }
                             else
                             {
-                                std::string showMicMute = showMicMuteOverlay (region);
-                                update_conference (conf_id_, NULL, NULL, showMicMute.c_str ());
+                                queueOverlay (showMicMuteOverlay, region);
                                 update_party (regionCallId, "recvonly", "sendrecv", NULL);
-                                Calls::Instance ()->setAudioMutedByCallId (regionCallId);
+                                calls_.setAudioMutedByCallId (regionCallId);
                                 LOGDEBUG ("Setting call ID " << regionCallId << " to muted ");
                             }
                         }
@@ -1353,20 +1186,18 @@ Conference720p::onEvent (xmsEventParser * eventParser)
                             (strcmp (userName, "controller") == 0) || (strcmp (userName, "ctrlr") == 0) ||
                             (strcmp (infoCallId.c_str (), regionCallId) == 0))
                         {
-                            if (Calls::Instance ()->isVideoHiddenForCallId (regionCallId))
+                            if (calls_.isVideoHiddenForCallId (regionCallId))
                             {
                                 // Get rid of overlay hiding stream
-                                std::string delBaghead = deleteBagheadOverlay (region);
-                                update_conference (conf_id_, NULL, NULL, delBaghead.c_str ());
-                                Calls::Instance ()->setVideoVisibleByCallId (regionCallId);
+                                queueOverlay (deleteBagheadOverlay, region);
+                                calls_.setVideoVisibleByCallId (regionCallId);
                                 LOGDEBUG ("Turning video back on for call ID " << regionCallId);
                             }
                             else
                             {
                                 // Display an overlay to blot out video stream
-                                std::string showBaghead = showBagheadOverlay (region);
-                                update_conference (conf_id_, NULL, NULL, showBaghead.c_str ());
-                                Calls::Instance ()->setVideoHiddenByCallId (regionCallId);
+                                queueOverlay (showBagheadOverlay, region);
+                                calls_.setVideoHiddenByCallId (regionCallId);
                                 LOGDEBUG ("Overlaying baghead for call ID " << regionCallId);
                             }
                         }
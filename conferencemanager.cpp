@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include "logger.h"
+#include "conferencemanager.h"
+#include "dispatchxmscmd.h"
+#include "xmsnodepool.h"
+
+/*----------------------------------------------------------------------------*/
+
+/*
+ * ctor
+ */
+ConferenceManager::ConferenceManager (const std::string & dtmf_mode, ConfRouteCallback confRouteCallback, void *userp)
+{
+    dtmfMode_ = dtmf_mode;
+    confRouteCallback_ = confRouteCallback;
+    confRouteUserp_ = userp;
+}
+
+/*
+ * dtor
+ */
+ConferenceManager::~ConferenceManager ()
+{
+    std::map < std::string, Room * >::iterator room_iterator;
+    for (room_iterator = roomsByName_.begin (); room_iterator != roomsByName_.end (); room_iterator++)
+    {
+        // Conference720p dtor destroys the XMS conference
+        delete room_iterator->second->conference;
+        delete room_iterator->second;
+    }
+}
+
+std::string
+ConferenceManager::roomNameFor (xmsEventParser * event)
+{
+    // sip:room42@xms.example.com -> room42
+    std::string uri = event->findValByKey ("called_uri");
+    if (uri.empty ())
+        uri = event->findValByKey ("uri");
+    std::string::size_type start = uri.find (':');
+    start = (start == std::string::npos) ? 0 : start + 1;
+    std::string::size_type end = uri.find_first_of ("@;>", start);
+    std::string name = uri.substr (start, end == std::string::npos ? std::string::npos : end - start);
+    if (name.empty ())
+        name = "default";
+    // Calls can only meet in a conference on their own XMS, so with more
+    // than one server a room is per server
+    int node = XmsNodePool::currentNode ();
+    if (node >= 0 && XmsNodePool::Instance ()->size () > 1)
+        name += "@" + XmsNodePool::Instance ()->getNode (node)->addr;
+    return name;
+}
+
+ConferenceManager::Room *
+ConferenceManager::findRoom (xmsEventParser * event)
+{
+    RoomIndex::iterator room_iterator;
+
+    if (event->getResourceType () == "conference")
+    {
+        room_iterator = roomsByConfId_.find (event->getResourceId ());
+        return room_iterator != roomsByConfId_.end ()? room_iterator->second : NULL;
+    }
+
+    std::string call_id = event->findValByKey ("call_id");
+    if (call_id.empty () && event->getResourceType () == "call")
+        call_id = event->getResourceId ();
+    room_iterator = roomsByCallId_.find (call_id);
+    return room_iterator != roomsByCallId_.end ()? room_iterator->second : NULL;
+}
+
+void
+ConferenceManager::syncConfId (Room * room)
+{
+    // A room's XMS conference comes and goes with its first and last caller
+    const std::string & confId = room->conference->getConfId ();
+    if (confId == room->confId)
+        return;
+    if (!room->confId.empty ())
+    {
+        roomsByConfId_.erase (room->confId);
+        if (confRouteCallback_)
+            confRouteCallback_ (room->confId, false, confRouteUserp_);
+    }
+    if (!confId.empty ())
+    {
+        roomsByConfId_[confId] = room;
+        if (confRouteCallback_)
+            confRouteCallback_ (confId, true, confRouteUserp_);
+    }
+    room->confId = confId;
+}
+
+void
+ConferenceManager::reapIfIdle (Room * room)
+{
+    if (room->calls > 0 || !room->confId.empty ())
+        return;
+    LOGDEBUG ("Room " << room->name << " is empty. Removing it");
+    roomsByName_.erase (room->name);
+    delete room->conference;
+    delete room;
+}
+
+void
+ConferenceManager::onEvent (xmsEventParser * event)
+{
+    const std::string & eventType = event->getEventType ();
+    Room *room;
+
+    if (eventType == "incoming")
+    {
+        std::string call_id = event->findValByKey ("call_id");
+        std::string name = roomNameFor (event);
+        std::map < std::string, Room * >::iterator name_iterator = roomsByName_.find (name);
+        if (name_iterator == roomsByName_.end ())
+        {
+            int node = XmsNodePool::currentNode ();
+            if (node >= 0 && !XmsNodePool::Instance ()->isInRotation (node))
+            {
+                // No new conferences on a failing server; turning the call
+                // away lets the SIP side retry it elsewhere
+                LOGWARN ("XMS node for room " << name << " is out of rotation. Rejecting call " << call_id);
+                hangup (call_id);
+                return;
+            }
+            LOGINFO ("Opening room " << name);
+            room = new Room;
+            room->name = name;
+            room->conference = new Conference720p (dtmfMode_);
+            room->calls = 0;
+            roomsByName_[name] = room;
+        }
+        else
+        {
+            room = name_iterator->second;
+        }
+        LOGDEBUG ("Call " << call_id << " routed to room " << name);
+        roomsByCallId_[call_id] = room;
+        room->calls++;
+    }
+    else
+    {
+        room = findRoom (event);
+        if (!room)
+        {
+            LOGWARN ("No conference for " << eventType << " event on " << event->getResourceType () << " " <<
+                     event->getResourceId () << ". Ignoring it");
+            return;
+        }
+    }
+
+    room->conference->onEvent (event);
+
+    if (eventType == "hangup")
+    {
+        std::string call_id = event->findValByKey ("call_id");
+        if (call_id.empty ())
+            call_id = event->getResourceId ();
+        if (roomsByCallId_.erase (call_id))
+            room->calls--;
+    }
+    syncConfId (room);
+    reapIfIdle (room);
+}
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+#ifndef _CONFERENCEMANAGER_H
+#define _CONFERENCEMANAGER_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <string>
+#include <map>
+#include <tr1/unordered_map>
+#include "conference720p.h"
+#include "xmseventparser.h"
+
+/*----------------------------------------------------------------------------*/
+
+/*!
+ * \class ConferenceManager
+ * Runs any number of conferences ("rooms") in one process and routes each
+ * XMS event to the room it belongs to.
+ *
+ * A room is named after the user part of the address the caller dialled,
+ * so everyone calling the same address meets in the same conference; with
+ * more than one XMS, rooms of the same name on different servers are kept
+ * apart. The
+ * room is created on its first incoming call and deleted once its last call
+ * has hung up and its XMS conference is gone.
+ *
+ * Events are routed by call ID, or by XMS conference ID for events raised on
+ * the conference itself (end_play, end_record, overlay expiry).
+ */
+class ConferenceManager
+{
+  public:
+    /*!
+     * Told when a room's XMS conference ID is registered (added) or goes
+     * away, so whoever routes events to this manager can follow it.
+     */
+    typedef void (*ConfRouteCallback) (const std::string & confId, bool added, void *userp);
+
+    ConferenceManager (const std::string & dtmf_mode, ConfRouteCallback confRouteCallback = NULL, void *userp = NULL);
+    ~ConferenceManager ();
+
+    void onEvent (xmsEventParser * event);
+
+    /*!
+     * Room an incoming call belongs to, from its called address.
+     */
+    static std::string roomNameFor (xmsEventParser * event);
+
+    size_t getNumRooms () const
+    {
+        return roomsByName_.size ();
+    }
+
+  private:
+    ConferenceManager (const ConferenceManager &);
+    ConferenceManager & operator = (const ConferenceManager &);
+
+    struct Room
+    {
+        std::string name;
+        Conference720p *conference;
+        std::string confId;     // as last registered in roomsByConfId_
+        int calls;              // routed call IDs
+    };
+
+    typedef std::tr1::unordered_map < std::string, Room * >RoomIndex;
+
+    Room *findRoom (xmsEventParser * event);
+    void syncConfId (Room * room);
+    void reapIfIdle (Room * room);
+
+    std::string dtmfMode_;
+    ConfRouteCallback confRouteCallback_;
+    void *confRouteUserp_;
+    std::map < std::string, Room * >roomsByName_;
+    RoomIndex roomsByCallId_;
+    RoomIndex roomsByConfId_;
+};
+
+#endif // _CONFERENCEMANAGER_H
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -20,87 +20,195 @@
  *
  */
 
+
 #ifndef _CONFVIDEOPLAYS_H
 #define _CONFVIDEOPLAYS_H
 
 /*------------------------------ Dependencies --------------------------------*/
 
+#include <stdlib.h>
+#include <string.h>
 #include <string>
+#include <algorithm>
 #include <vector>
-#include "confvideoplay.h"
+#include <tr1/unordered_map>
+#include "logger.h"
+#include "cstrhash.h"
 #include "dispatchxmscmd.h"
 /*----------------------------------------------------------------------------*/
 
 /*!
- * \class onfVideoPPLays - an STL vector of all video plays into a conference
- * 	The class is a singleton.
- * 
+ * Stable handle for a video play into a conference. A handle stays valid,
+ * and keeps referring to the same play, until delConfVideoPlay (). Handles
+ * are small integers and are reused afterwards.
+ */
+typedef int PlayHandle;
+static const PlayHandle NO_PLAY = -1;
+
+/*!
+ * \class ConfVideoPlays - all video plays into a conference
+ * 	Each Conference720p owns one.
+ *
+ * 	Laid out like Calls: per play state in vectors indexed by PlayHandle, a
+ * 	hash map from XMS transaction ID to handle, and a table from conference
+ * 	region to the play shown there. Lookups by transaction ID or by region
+ * 	are O(1), and the region rotation works on handles directly.
  */
 class ConfVideoPlays
 {
   public:
+    ConfVideoPlays ()
+    {
+    };
+
     /*!
      * dtor.
      */
-    ~ConfVideoPlays ();
+    ~ConfVideoPlays ()
+    {
+        clearConfVideoPlayList ();
+    }
+
+    /*!
+     * Track a new play. Returns its handle, or NO_PLAY if the play has no
+     * transaction ID.
+     */
+    PlayHandle addNewPlay (const std::string & confId, const char *play_id, int region)
+    {
+        if (play_id == NULL || *play_id == '\0')
+        {
+            LOGWARN ("Bad play ID. Video play not added to active play list");
+            return NO_PLAY;
+        }
+        PlayHandle handle = findPlay (play_id);
+        if (handle != NO_PLAY)
+        {
+            LOGWARN ("Play ID " << play_id << " already in active play list");
+            return handle;
+        }
+
+        if (!freeHandles_.empty ())
+        {
+            handle = freeHandles_.back ();
+            freeHandles_.pop_back ();
+        }
+        else
+        {
+            handle = (PlayHandle) playIds_.size ();
+            playIds_.push_back (NULL);
+            confIds_.push_back (std::string ());
+            regions_.push_back (0);
+        }
+        // Own copy, so the map key never moves when the vectors grow
+        playIds_[handle] = strdup (play_id);
+        confIds_[handle] = confId;
+        regions_[handle] = 0;
+        playsById_[playIds_[handle]] = handle;
+        activePlays_.push_back (handle);
+        setConfVideoPlayRegion (handle, region);
+        return handle;
+    }
+
+    PlayHandle findPlay (const char *play_id) const
+    {
+        if (play_id == NULL)
+            return NO_PLAY;
+        PlayIndex::const_iterator index_iterator = playsById_.find (play_id);
+        if (index_iterator == playsById_.end ())
+            return NO_PLAY;
+        return index_iterator->second;
+    }
+
+    /*!
+     * Active plays, in the order they started.
+     */
+    const std::vector < PlayHandle > &getConfVideoPlayList () const
+    {
+        return activePlays_;
+    }
+
+    // By handle. The handle must be one of getConfVideoPlayList ()
+
+    const char *getConfVideoPlayId (PlayHandle handle) const
+    {
+        return playIds_[handle];
+    }
 
-    static ConfVideoPlays *Instance ()
+    const std::string & getConfId (PlayHandle handle) const
     {
-        if (!pInstance_)
-            pInstance_ = new ConfVideoPlays;
+        return confIds_[handle];
+    }
+
+    int getConfVideoPlayRegion (PlayHandle handle) const
+    {
+        return regions_[handle];
+    }
+
+    void setConfVideoPlayRegion (PlayHandle handle, int region)
+    {
+        int oldRegion = regions_[handle];
+        if (oldRegion > 0 && (size_t) oldRegion < regionPlays_.size () && regionPlays_[oldRegion] == handle)
+            regionPlays_[oldRegion] = NO_PLAY;
+        if (region > 0)
+        {
+            if ((size_t) region >= regionPlays_.size ())
+                regionPlays_.resize (region + 1, NO_PLAY);
+            regionPlays_[region] = handle;
+        }
+        regions_[handle] = region;
+    }
+
+    // By conference region
 
-        return pInstance_;
+    PlayHandle getVideoPlayByConfRegion (int region) const
+    {
+        if (region <= 0 || (size_t) region >= regionPlays_.size ())
+            return NO_PLAY;
+        return regionPlays_[region];
     }
 
-    void addNewPlay (ConfVideoPlay newPlay)
+    const char *getVideoPlayIdByConfRegion (const int region)
     {
-        conf_video_plays_.push_back (newPlay);
+        PlayHandle handle = getVideoPlayByConfRegion (region);
+        if (handle == NO_PLAY)
+            return NULL;
+        LOGDEBUG ("Play ID for region " << region << " is " << playIds_[handle]);
+        return playIds_[handle];
     }
 
+    // By XMS transaction ID
+
     void setConfRegionById (const char *play_id, const int region)
     {
-        std::vector < ConfVideoPlay >::iterator conf_play_iterator;
-        for (conf_play_iterator = conf_video_plays_.begin (); conf_play_iterator != conf_video_plays_.end ();
-             conf_play_iterator++)
+        PlayHandle handle = findPlay (play_id);
+        if (handle != NO_PLAY)
         {
-            if (strcmp (conf_play_iterator->getConfVideoPlayId (), play_id) == 0)
-            {
-                LOGDEBUG ("Setting conference region for video play id " << play_id << " to " << region);
-                conf_play_iterator->setConfVideoPlayRegion (region);
-            }
+            LOGDEBUG ("Setting conference region for video play id " << play_id << " to " << region);
+            setConfVideoPlayRegion (handle, region);
         }
     }
 
     void clearConfRegionByPlayId (const char *play_id)
     {
-        std::vector < ConfVideoPlay >::iterator conf_play_iterator;
-        for (conf_play_iterator = conf_video_plays_.begin (); conf_play_iterator != conf_video_plays_.end ();
-             conf_play_iterator++)
+        PlayHandle handle = findPlay (play_id);
+        if (handle != NO_PLAY)
         {
-            if (strcmp (conf_play_iterator->getConfVideoPlayId (), play_id) == 0)
-            {
-                LOGDEBUG ("Clearing conference region for play id " << play_id);
-                conf_play_iterator->clearConfVideoPlayRegion ();
-            }
+            LOGDEBUG ("Clearing conference region for play id " << play_id);
+            setConfVideoPlayRegion (handle, 0);
         }
     }
 
     bool areAnyConfPlaysActive ()
-	{
-		return !conf_video_plays_.empty();
-	}
+    {
+        return !activePlays_.empty ();
+    }
 
     bool isConfPlayActive (const char *play_id)
     {
-        std::vector < ConfVideoPlay >::iterator conf_play_iterator;
-        for (conf_play_iterator = conf_video_plays_.begin (); conf_play_iterator != conf_video_plays_.end ();
-             conf_play_iterator++)
+        if (findPlay (play_id) != NO_PLAY)
         {
-            if (strcmp (conf_play_iterator->getConfVideoPlayId (), play_id) == 0)
-            {
-                LOGDEBUG ("Conference play for ID " << play_id << " is active");
-                return true;
-            }
+            LOGDEBUG ("Conference play for ID " << play_id << " is active");
+            return true;
         }
         LOGDEBUG ("Conference play for ID " << play_id << " is not active");
         return false;
@@ -108,111 +216,98 @@ class ConfVideoPlays
 
     int getConfRegionByPlayId (const char *play_id)
     {
-        std::vector < ConfVideoPlay >::iterator conf_play_iterator;
-        for (conf_play_iterator = conf_video_plays_.begin (); conf_play_iterator != conf_video_plays_.end ();
-             conf_play_iterator++)
+        PlayHandle handle = findPlay (play_id);
+        if (handle != NO_PLAY)
         {
-            if (strcmp (conf_play_iterator->getConfVideoPlayId (), play_id) == 0)
-            {
-                LOGDEBUG ("Conference region for play id " << play_id << " is " << conf_play_iterator->getConfVideoPlayRegion ());
-                return conf_play_iterator->getConfVideoPlayRegion ();
-            }
+            LOGDEBUG ("Conference region for play id " << play_id << " is " << regions_[handle]);
+            return regions_[handle];
         }
         LOGWARN ("Video play being fetched from active play list does not exist");
-        return NULL;
+        return 0;
     }
 
-    const char *getVideoPlayIdByConfRegion (const int region)
+    void setConfVideoPlayRegionByPlayId (const char *playId, int region)
     {
-        std::vector < ConfVideoPlay >::iterator play_iterator;
-        for (play_iterator = conf_video_plays_.begin (); play_iterator != conf_video_plays_.end (); play_iterator++)
+        PlayHandle handle = findPlay (playId);
+        if (handle != NO_PLAY)
         {
-            if (play_iterator->getConfVideoPlayRegion () == region)
-            {
-                LOGDEBUG ("Call ID for region " << region << " is " << play_iterator->getConfVideoPlayId ());
-                return play_iterator->getConfVideoPlayId ();
-            }
+            LOGDEBUG ("Setting new region " << region << " for video Play ID: " << playId);
+            setConfVideoPlayRegion (handle, region);
         }
-        return NULL;
     }
 
-
     void delConfVideoPlay (const char *play_id)
     {
-        std::vector < ConfVideoPlay >::iterator conf_play_iterator;
-
-        for (conf_play_iterator = conf_video_plays_.begin (); conf_play_iterator != conf_video_plays_.end ();
-             conf_play_iterator++)
+        PlayIndex::iterator index_iterator = play_id ? playsById_.find (play_id) : playsById_.end ();
+        if (index_iterator == playsById_.end ())
         {
-            if (strcmp (conf_play_iterator->getConfVideoPlayId (), play_id) == 0)
-            {
-                LOGDEBUG ("Deleting play with play ID " << conf_play_iterator->getConfVideoPlayId () << " from active play list");
-                conf_video_plays_.erase (conf_play_iterator);
-                return;
-            }
+            LOGDEBUG ("Nothing in active play list for deletion");
+            return;
         }
-        LOGDEBUG ("Nothing in active play list for deletion");
+        PlayHandle handle = index_iterator->second;
+        LOGDEBUG ("Deleting play with play ID " << play_id << " from active play list");
+        setConfVideoPlayRegion (handle, 0);
+        // Key is the interned ID; drop it before freeing
+        playsById_.erase (index_iterator);
+        free (playIds_[handle]);
+        playIds_[handle] = NULL;
+        confIds_[handle].clear ();
+        activePlays_.erase (std::find (activePlays_.begin (), activePlays_.end (), handle));
+        freeHandles_.push_back (handle);
     }
 
-	void setConfVideoPlayRegionByPlayId (const char * playId, int region)
-	{
-	    std::vector < ConfVideoPlay >::iterator conf_play_iterator;
-
-        for (conf_play_iterator = conf_video_plays_.begin (); conf_play_iterator != conf_video_plays_.end ();
-             conf_play_iterator++)
-        {
-            if  (strcmp(conf_play_iterator->getConfVideoPlayId (), playId) == 0)
-			{
-            	LOGDEBUG ("Setting new region " << region << " for video Play ID: " << conf_play_iterator->getConfVideoPlayId ());
-				conf_play_iterator->setConfVideoPlayRegion (region);
-			}
-		}
-	}
-
-
     void stopAllConfVideoPlays ()
     {
-        std::vector < ConfVideoPlay >::iterator conf_play_iterator;
+        std::vector < PlayHandle >::iterator conf_play_iterator;
 
-        for (conf_play_iterator = conf_video_plays_.begin (); conf_play_iterator != conf_video_plays_.end ();
+        for (conf_play_iterator = activePlays_.begin (); conf_play_iterator != activePlays_.end ();
              conf_play_iterator++)
         {
-            LOGDEBUG ("Stopping Video Play ID: " << conf_play_iterator->getConfVideoPlayId ());
-	    // Issue stop command; List cleanup done when END_PLAY event is received
-            stop (conf_play_iterator->getConfId(), conf_play_iterator->getConfVideoPlayId ());
+            LOGDEBUG ("Stopping Video Play ID: " << playIds_[*conf_play_iterator]);
+            // Issue stop command; List cleanup done when END_PLAY event is received
+            stop (confIds_[*conf_play_iterator], playIds_[*conf_play_iterator]);
         }
     }
 
     void clearConfVideoPlayList ()
-	{
-		 conf_video_plays_.clear();
+    {
+        playsById_.clear ();
+        for (size_t handle = 0; handle < playIds_.size (); handle++)
+            free (playIds_[handle]);
+        playIds_.clear ();
+        confIds_.clear ();
+        regions_.clear ();
+        freeHandles_.clear ();
+        activePlays_.clear ();
+        regionPlays_.clear ();
     }
 
     void printConfVideoPlayList ()
     {
-        std::vector < ConfVideoPlay >::iterator conf_play_iterator;
+        std::vector < PlayHandle >::iterator conf_play_iterator;
 
-        for (conf_play_iterator = conf_video_plays_.begin (); conf_play_iterator != conf_video_plays_.end ();
+        for (conf_play_iterator = activePlays_.begin (); conf_play_iterator != activePlays_.end ();
              conf_play_iterator++)
         {
-            LOGDEBUG ("COnference Video Play list item: " << conf_play_iterator->getConfVideoPlayId ());
+            LOGDEBUG ("COnference Video Play list item: " << playIds_[*conf_play_iterator]);
         }
     }
 
-    // Needs to be public; can't get to it thru accessor
-    std::vector < ConfVideoPlay > conf_video_plays_;
-
   private:
-    /*!
-     * ctor. Hide here as class is a singleton
-     */
-    ConfVideoPlays ()
-    {
-    };
-    static ConfVideoPlays *pInstance_;
+    ConfVideoPlays (const ConfVideoPlays &);
+    ConfVideoPlays & operator = (const ConfVideoPlays &);
 
+    typedef std::tr1::unordered_map < const char *, PlayHandle, CStrHash, CStrEqual > PlayIndex;
 
+    // Per play state, indexed by PlayHandle. A free slot has a NULL play ID
+    std::vector < char *>playIds_;
+    std::vector < std::string > confIds_;
+    std::vector < int >regions_;
+    std::vector < PlayHandle > freeHandles_;
 
+    std::vector < PlayHandle > activePlays_;
+    PlayIndex playsById_;
+    std::vector < PlayHandle > regionPlays_;    // by conference region
 };
 
 
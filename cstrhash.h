@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+#ifndef _CSTRHASH_H
+#define _CSTRHASH_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <string.h>
+#include <stddef.h>
+/*----------------------------------------------------------------------------*/
+
+// Hash and equality functors for using C strings as hash map keys, so that a
+// lookup by call ID or play ID compares characters rather than building a
+// std::string.  The key must point at storage that lives as long as the
+// map entry, normally the c_str () of the object the entry refers to.
+
+struct CStrHash
+{
+    size_t operator () (const char *s) const
+    {
+        // FNV-1a
+        size_t hash = 2166136261u;
+        while (*s)
+        {
+            hash ^= (unsigned char) *s++;
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+};
+
+struct CStrEqual
+{
+    bool operator () (const char *a, const char *b) const
+    {
+        return strcmp (a, b) == 0;
+    }
+};
+
+#endif // _CSTRHASH_H
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,168 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include "logger.h"
+#include "curlhandlepool.h"
+
+/*----------------------------------------------------------------------------*/
+
+CurlHandlePool *
+    CurlHandlePool::pInstance_ = NULL;
+
+/*
+ * ctor
+ */
+CurlHandlePool::CurlHandlePool ()
+{
+    pthread_mutex_init (&poolLock_, NULL);
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++)
+        pthread_mutex_init (&shareLocks_[i], NULL);
+
+    // DNS and connection caches are shared by every handle in the pool.
+    // REST requests come from more than one thread, so the share needs locks.
+    share_ = curl_share_init ();
+    if (share_)
+    {
+        curl_share_setopt (share_, CURLSHOPT_LOCKFUNC, shareLock);
+        curl_share_setopt (share_, CURLSHOPT_UNLOCKFUNC, shareUnlock);
+        curl_share_setopt (share_, CURLSHOPT_USERDATA, (void *) this);
+        curl_share_setopt (share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt (share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+    else
+    {
+        LOGERROR ("curl_share_init failed. REST connections will not be shared");
+    }
+
+    // Built once; every PUT and DELETE sends the same headers
+    xmlHeaders_ = NULL;
+    xmlHeaders_ = curl_slist_append (xmlHeaders_, "Accept: application/xml");
+    xmlHeaders_ = curl_slist_append (xmlHeaders_, "Content-Type: application/xml");
+    xmlHeaders_ = curl_slist_append (xmlHeaders_, "Connection: keep-alive");
+}
+
+/*
+ * dtor
+ */
+CurlHandlePool::~CurlHandlePool ()
+{
+    cleanup ();
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++)
+        pthread_mutex_destroy (&shareLocks_[i]);
+    pthread_mutex_destroy (&poolLock_);
+}
+
+void
+CurlHandlePool::shareLock (CURL * curl, curl_lock_data data, curl_lock_access access, void *userp)
+{
+    CurlHandlePool *pool = (CurlHandlePool *) userp;
+    pthread_mutex_lock (&pool->shareLocks_[data]);
+}
+
+void
+CurlHandlePool::shareUnlock (CURL * curl, curl_lock_data data, void *userp)
+{
+    CurlHandlePool *pool = (CurlHandlePool *) userp;
+    pthread_mutex_unlock (&pool->shareLocks_[data]);
+}
+
+void
+CurlHandlePool::setCommonOptions (CURL * curl)
+{
+    if (share_)
+        curl_easy_setopt (curl, CURLOPT_SHARE, share_);
+
+    // some servers don't like requests that are made without a user-agent
+    // field, so we provide one
+    curl_easy_setopt (curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
+    curl_easy_setopt (curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt (curl, CURLOPT_NOSIGNAL, 1L);
+}
+
+CURL *
+CurlHandlePool::checkout ()
+{
+    CURL *curl = NULL;
+
+    pthread_mutex_lock (&poolLock_);
+    if (!idleHandles_.empty ())
+    {
+        curl = idleHandles_.back ();
+        idleHandles_.pop_back ();
+    }
+    pthread_mutex_unlock (&poolLock_);
+
+    if (!curl)
+    {
+        curl = curl_easy_init ();
+        if (!curl)
+            return NULL;
+        LOGDEBUG ("New cURL handle added to REST handle pool");
+    }
+    setCommonOptions (curl);
+    return curl;
+}
+
+void
+CurlHandlePool::checkin (CURL * curl)
+{
+    if (!curl)
+        return;
+
+    // Drop per request options (URL, method, body, callbacks). Live
+    // connections are held in the share, not in the options.
+    curl_easy_reset (curl);
+
+    pthread_mutex_lock (&poolLock_);
+    idleHandles_.push_back (curl);
+    pthread_mutex_unlock (&poolLock_);
+}
+
+void
+CurlHandlePool::cleanup ()
+{
+    pthread_mutex_lock (&poolLock_);
+    std::vector < CURL * >::iterator handle_iterator;
+    for (handle_iterator = idleHandles_.begin (); handle_iterator != idleHandles_.end (); handle_iterator++)
+    {
+        curl_easy_cleanup (*handle_iterator);
+    }
+    idleHandles_.clear ();
+    pthread_mutex_unlock (&poolLock_);
+
+    if (share_)
+    {
+        curl_share_cleanup (share_);
+        share_ = NULL;
+    }
+    if (xmlHeaders_)
+    {
+        curl_slist_free_all (xmlHeaders_);
+        xmlHeaders_ = NULL;
+    }
+}
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+#ifndef _CURLHANDLEPOOL_H
+#define _CURLHANDLEPOOL_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <vector>
+#include <pthread.h>
+#include <curl/curl.h>
+
+/*----------------------------------------------------------------------------*/
+
+/*!
+ * \class CurlHandlePool
+ * A pool of reusable cURL easy handles for REST requests to XMS.
+ * All handles are attached to one CURLSH so DNS lookups and open
+ * connections are shared; a handle checked out for a request finds the
+ * socket left warm by the previous request.  The class is a singleton.
+ */
+class CurlHandlePool
+{
+  public:
+    /*!
+     * dtor.
+     */
+    ~CurlHandlePool ();
+
+    static CurlHandlePool *Instance ()
+    {
+        if (!pInstance_)
+            pInstance_ = new CurlHandlePool;
+
+        return pInstance_;
+    }
+
+    /*!
+     * Get a handle for one request. The handle has the shared cache and the
+     * common options already set.  Returns NULL if cURL cannot create one.
+     */
+    CURL *checkout ();
+
+    /*!
+     * Return a handle once the request is complete. Per request options are
+     * reset; the connection stays open in the shared cache.
+     */
+    void checkin (CURL * curl);
+
+    /*!
+     * Standard XML request headers. Owned by the pool, do not free.
+     */
+    struct curl_slist *xmlHeaders ()
+    {
+        return xmlHeaders_;
+    }
+
+    /*!
+     * Release every idle handle and the shared cache.  Called at shutdown,
+     * before curl_global_cleanup().
+     */
+    void cleanup ();
+
+  private:
+    /*!
+     * ctor. Hide here as class is a singleton
+     */
+    CurlHandlePool ();
+
+    void setCommonOptions (CURL * curl);
+
+    static void shareLock (CURL * curl, curl_lock_data data, curl_lock_access access, void *userp);
+    static void shareUnlock (CURL * curl, curl_lock_data data, void *userp);
+
+    static CurlHandlePool *pInstance_;
+
+    CURLSH *share_;
+    struct curl_slist *xmlHeaders_;
+    std::vector < CURL * >idleHandles_;
+    pthread_mutex_t poolLock_;
+    pthread_mutex_t shareLocks_[CURL_LOCK_DATA_LAST];
+};
+
+
+#endif // _CURLHANDLEPOOL_H
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
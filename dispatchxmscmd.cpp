@@ -25,280 +25,100 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
-#include <curl/curl.h>
-
 #include "logger.h"
 #include "dispatchxmscmd.h"
 #include "xmscmds.h"
 #include "xmsreplyparser.h"
-#include "replycontentcallback.h"
+#include "restdispatcher.h"
+#include "xmsnodepool.h"
+#include "eventcapture.h"
 
 /*----------------------------------------------------------------------------*/
 
-// REST service address/port
-extern
-    std::string
-    xmsAddr;
+// Synchronous requests are queued on the REST dispatcher like any other
+// and waited on, so they stay in order with earlier asynchronous commands
+// on the same resource.  operation names the request in LatencyStats.
 
-/********************************  
-struct MemoryStruct
-{
-    char *
-        memory;
-    size_t
-        size;
-};
-
-static
-    size_t
-replyContentCallback (void *contents, size_t size, size_t nmemb, void *userp)
+void
+dispatchPostAsync (const char *operation, const std::string & resource, const std::string & xmlContent, int node, RestCompletionCallback callback, void *userp)
 {
-    size_t realsize = size * nmemb;
-    struct MemoryStruct *
-        mem = (struct MemoryStruct *) userp;
-    mem->memory = (char *) realloc (mem->memory, mem->size + realsize + 1);
-
-    if (mem->memory == NULL)
-    {
-        // out of memory!
-        LOGCRIT ("ReplyContentCallback - not enough memory (realloc returned NULL)");
-        return 0;
-    }
+    if (node < 0)
+    {
+        LOGERROR ("No usable XMS node. POST to " << resource << " not sent");
+        RestResult result;
+        result.curlCode = CURLE_COULDNT_CONNECT;
+        result.respCode = 0;
+        result.success = false;
+        if (callback)
+            callback (result, userp);
+        return;
+    }
+    std::string url = XmsNodePool::Instance ()->urlBase (node) + resource;
+    LOGDEBUG ("XML content for resource " << resource << " is " << xmlContent.c_str ());
+    // Keyed by node as well, so POSTs to different servers don't queue together
+    RestDispatcher::Instance ()->submit ("POST", XmsNodePool::Instance ()->getNode (node)->addr + resource, url, xmlContent,
+                                         callback, userp, node, operation);
+}
 
-    memcpy (&(mem->memory[mem->size]), contents, realsize);
-    mem->size += realsize;
-    mem->memory[mem->size] = 0;
+void
+dispatchPutAsync (const char *operation, const std::string & resource, const std::string & xmlContent, const std::string & id,
+                  RestCompletionCallback callback, void *userp)
+{
+    int node = XmsNodePool::Instance ()->nodeFor (id);
+    std::string url = XmsNodePool::Instance ()->urlBase (node) + resource + id + "?appid=app";
+    RestDispatcher::Instance ()->submit ("PUT", resource + id, url, xmlContent, callback, userp, node, operation);
+}
 
-    return realsize;
+void
+dispatchDeleteAsync (const char *operation, const std::string & resource, const std::string & id, RestCompletionCallback callback, void *userp)
+{
+    int node = XmsNodePool::Instance ()->nodeFor (id);
+    std::string url = XmsNodePool::Instance ()->urlBase (node) + resource + id + "?appid=app";
+    RestDispatcher::Instance ()->submit ("DELETE", resource + id, url, std::string (), callback, userp, node, operation);
 }
-******************************************/
 
 std::string
-dispatchPost (std::string resource, std::string xmlContent)
+dispatchPost (const char *operation, const std::string & resource, const std::string & xmlContent, int node)
 {
-    CURL *curl;
-    CURLcode res;
-    struct MemoryStruct replyContent;
-    replyContent.memory = (char *) malloc (1);
-    replyContent.size = 0;
-    std::string replyContentString;
-
-    curl = curl_easy_init ();
-    if (curl)
-    {
-
-        std::string url = "http://" + xmsAddr + resource;
-        curl_easy_setopt (curl, CURLOPT_URL, url.c_str ());
-        // Set callback for request
-        curl_easy_setopt (curl, CURLOPT_WRITEFUNCTION, replyContentCallback);
-        //
-        // pass our replyContent struct to the callback function to get reply to POST
-        curl_easy_setopt (curl, CURLOPT_WRITEDATA, (void *) &replyContent);
-
-        // some servers don't like requests that are made without a user-agent
-        // field, so we provide one
-        curl_easy_setopt (curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
-
-        // Add XML content for POST
-        LOGDEBUG ("XML content for resource " << resource << " is " << xmlContent.c_str ());
-        curl_easy_setopt (curl, CURLOPT_POSTFIELDS, xmlContent.c_str ());
-        curl_easy_setopt (curl, CURLOPT_POSTFIELDSIZE, (long) xmlContent.size ());
-
-        // Perform the request, res will get the return code
-        res = curl_easy_perform (curl);
-        LOGDEBUG ("POST result is " << res);
-        if (res != CURLE_OK)
-        {
-            LOGERROR ("POST- curl_easy_perform() failed: " << curl_easy_strerror (res));
-            return replyContentString;
-        }
-        else
-        {
-            // Get the response
-            long respCode;
-            res = curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &respCode);
-            if (res == CURLE_OK)
-            {
-                LOGDEBUG ("Response code to POST is " << respCode);
-                if (respCode == 201)
-                {
-                    // Now, our replyContent.memory points to a memory block that is replyContent.size
-                    // bytes big and contains the reply
-                    LOGDEBUG ("POST returns " << replyContent.size << " bytes");
-                    LOGDEBUG ("POST reply is " << replyContent.memory);
-                    replyContentString = replyContent.memory;
-                    return replyContentString;
-                }
-                else if (respCode >= 400 && respCode <= 499)
-                {
-                    LOGWARN ("400 series response to POST - " << respCode);
-                }
-            }
-            free (replyContent.memory);
-            replyContent.size = 0;
-        }
-    }
-    return replyContentString;
+    RestWaiter waiter;
+    dispatchPostAsync (operation, resource, xmlContent, node, RestWaiter::complete, &waiter);
+    const RestResult & result = waiter.wait ();
+    if (!result.success)
+        return std::string ();
+    return result.content;
 }
 
 std::string
-dispatchPut (std::string resource, std::string xmlContent, std::string id)
+dispatchPut (const char *operation, const std::string & resource, const std::string & xmlContent, const std::string & id)
 {
-    CURL *curl;
-    CURLcode res;
-    struct MemoryStruct replyContent;
-    replyContent.memory = (char *) malloc (1);
-    replyContent.size = 0;
-    std::string replyContentString;
-
-    curl = curl_easy_init ();
-    if (curl)
-    {
-        struct curl_slist *headers = NULL;
-        headers = curl_slist_append (headers, "Accept: application/xml");
-        headers = curl_slist_append (headers, "Content-Type: application/xml");
-        headers = curl_slist_append (headers, "Connection: keep-alive");
-        std::string contentLengthHeader = "Content-Length: " + xmlContent.size ();
-        headers = curl_slist_append (headers, contentLengthHeader.c_str ());
-        curl_easy_setopt (curl, CURLOPT_HTTPHEADER, headers);
-
-        std::string url = "http://" + xmsAddr + resource + id + "?appid=app";
-        LOGDEBUG ("URL for PUT: " << url);
-        curl_easy_setopt (curl, CURLOPT_URL, url.c_str ());
-
-        curl_easy_setopt (curl, CURLOPT_CUSTOMREQUEST, "PUT");
-
-        // send all data to this function  
-        curl_easy_setopt (curl, CURLOPT_WRITEFUNCTION, replyContentCallback);
-
-        curl_easy_setopt (curl, CURLOPT_POSTFIELDS, xmlContent.c_str ());
-        curl_easy_setopt (curl, CURLOPT_POSTFIELDSIZE, (long) xmlContent.size ());
-        curl_easy_setopt (curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
-
-        // we pass our replyContent struct to the callback function to get reply to PUT
-        curl_easy_setopt (curl, CURLOPT_WRITEDATA, (void *) &replyContent);
-
-        // Perform the request, res will get the return code 
-        LOGDEBUG ("Sending HTTP PUT via Curl using URL " << url);
-        LOGDEBUG ("Content of PUT is " << xmlContent);
-        res = curl_easy_perform (curl);
-        // Check for errors 
-        if (res != CURLE_OK)
-        {
-            LOGERROR ("curl_easy_perform() for PUT failed: " << curl_easy_strerror (res));
-        }
-        else
-        {
-            // Get the response
-            long respCode;
-            res = curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &respCode);
-            if (res == CURLE_OK)
-            {
-                LOGDEBUG ("Response code to PUT is " << respCode);
-                if (respCode == 200)
-                {
-                    // Now, our replyContent.memory points to a memory block that is replyContent.size
-                    // bytes big and contains the reply
-                    LOGDEBUG ("PUT returns " << replyContent.size << " bytes");
-                    LOGDEBUG ("PUT reply is " << replyContent.memory);
-                    replyContentString = replyContent.memory;
-                }
-                else if (respCode >= 400 && respCode <= 499)
-                {
-                    LOGWARN ("400 series response to PUT - " << respCode);
-                }
-            }
-            // Done with  replyContent
-            free (replyContent.memory);
-            replyContent.size = 0;
-        }
-    }
-    else
-    {
-        LOGERROR ("cur_easy_init failed for PUT");
-    }
-    return replyContentString;
+    RestWaiter waiter;
+    dispatchPutAsync (operation, resource, xmlContent, id, RestWaiter::complete, &waiter);
+    const RestResult & result = waiter.wait ();
+    if (!result.success)
+        return std::string ();
+    return result.content;
 }
 
 int
-dispatchDelete (std::string resource, std::string id)
+dispatchDelete (const char *operation, const std::string & resource, const std::string & id)
 {
-    CURL *curl;
-    CURLcode res;
-    struct MemoryStruct replyContent;
-    replyContent.memory = (char *) malloc (1);
-    replyContent.size = 0;
-
-    curl = curl_easy_init ();
-    if (curl)
-    {
-        struct curl_slist *headers = NULL;
-        headers = curl_slist_append (headers, "Accept: application/xml");
-        headers = curl_slist_append (headers, "Content-Type: application/xml");
-        headers = curl_slist_append (headers, "Connection: keep-alive");
-        //std::string contentLengthHeader = "Content-Length: " + xmlContent.size ();
-        //headers = curl_slist_append (headers, contentLengthHeader.c_str ());
-        curl_easy_setopt (curl, CURLOPT_HTTPHEADER, headers);
-
-        std::string url = "http://" + xmsAddr + resource + id + "?appid=app";
-        curl_easy_setopt (curl, CURLOPT_URL, url.c_str ());
-
-        curl_easy_setopt (curl, CURLOPT_CUSTOMREQUEST, "DELETE");
-
-        // send all data to this function  
-        curl_easy_setopt (curl, CURLOPT_WRITEFUNCTION, replyContentCallback);
-
-        //curl_easy_setopt (curl, CURLOPT_POSTFIELDS, xmlContent.c_str ());
-        //curl_easy_setopt (curl, CURLOPT_POSTFIELDSIZE, (long) xmlContent.size ());
-        curl_easy_setopt (curl, CURLOPT_USERAGENT, "libcurl-agent/1.0");
-
-        // we pass our replyContent struct to the callback function to get reply to PUT
-        curl_easy_setopt (curl, CURLOPT_WRITEDATA, (void *) &replyContent);
-
-        // Perform the request, res will get the return code 
-        LOGDEBUG ("Sending HTTP DELETE via Curl using URL " << url);
-        //LOGDEBUG ("Content of PUT is " << xmlContent);
-        res = curl_easy_perform (curl);
-        // Check for errors 
-        if (res != CURLE_OK)
-        {
-            LOGERROR ("curl_easy_perform() for DELETE failed: " << curl_easy_strerror (res));
-        }
-        else
-        {
-            // Get the response
-            long respCode;
-            res = curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &respCode);
-            if (res == CURLE_OK)
-            {
-                LOGDEBUG ("Response code to DELETE is " << respCode);
-                if (respCode != 204)
-                {
-                    // 204 is success for DELETE. No content is returned with it
-                    LOGERROR ("DELETE for call/conference ID " << resource + id << " was not successful");
-                    return 1;
-                }
-                else if (respCode >= 400 && respCode <= 499)
-                {
-                    LOGWARN ("400 series response to DELETE - " << respCode);
-                }
-            }
-        }
-    }
-    else
+    RestWaiter waiter;
+    dispatchDeleteAsync (operation, resource, id, RestWaiter::complete, &waiter);
+    const RestResult & result = waiter.wait ();
+    if (!result.success)
     {
-        LOGERROR ("cur_easy_init failed for DELETE");
+        LOGERROR ("DELETE for call/conference ID " << resource + id << " was not successful");
+        return 1;
     }
     return 0;
 }
 
-
 int
-answer (std::string callId, const char *dtmf_mode)
+answer (const std::string & callId, const char *dtmf_mode, RestCompletionCallback callback, void *userp)
 {
 
-    std::string answerXml = answer_call_xml (dtmf_mode);
-    dispatchPut ("/default/calls/", answerXml, callId);
+    const std::string & answerXml = answer_call_xml (dtmf_mode);
+    dispatchPutAsync ("answer", "/default/calls/", answerXml, callId, callback, userp);
     return 0;
 }
 
@@ -307,29 +127,29 @@ answer (std::string callId, const char *dtmf_mode)
  * Wrapper for xms_hangup()
  */
 int
-hangup (std::string callId)
+hangup (const std::string & callId, RestCompletionCallback callback, void *userp)
 {
-    std::string hangupXml = hangup_xml ();
-    dispatchPut ("/default/calls/", hangupXml, callId);
+    const std::string & hangupXml = hangup_xml ();
+    dispatchPutAsync ("hangup", "/default/calls/", hangupXml, callId, callback, userp);
     return 0;
 }
 
 std::string
-play_into_conf (std::string conf_id, const char *audio_uri, const char *audio_type,
+play_into_conf (const std::string & conf_id, const char *audio_uri, const char *audio_type,
                 const char *base_audio_uri, const char *video_uri, const char *video_type,
                 const char *base_video_uri, const char *region, const char *repeat)
 {
     std::string reply;
     std::string mediaId;
 
-    std::string playXml = play_into_conf_xml (conf_id, audio_uri, audio_type, base_audio_uri, video_uri,
-                                              video_type, base_video_uri, region, repeat);
+    const std::string & playXml = play_into_conf_xml (conf_id, audio_uri, audio_type, base_audio_uri, video_uri,
+                                                      video_type, base_video_uri, region, repeat);
 
-    reply = dispatchPut ("/default/conferences/", playXml, conf_id);
+    reply = dispatchPut ("play_into_conf", "/default/conferences/", playXml, conf_id);
     if (!reply.empty ())
     {
         xmsReplyParser *parser = new xmsReplyParser (reply, playIntoConference);
-        mediaId = parser->getMediaId ();
+        mediaId = EventCapture::Instance ()->serverId ("play", parser->getMediaId ());
         delete parser;
         return mediaId;
     }
@@ -342,7 +162,7 @@ play_into_conf (std::string conf_id, const char *audio_uri, const char *audio_ty
 
 
 std::string
-record_conference (std::string conf_id,
+record_conference (const std::string & conf_id,
                    const char *audio_uri,
                    const char *audio_type,
                    const char *audio_codec,
@@ -356,16 +176,16 @@ record_conference (std::string conf_id,
     std::string reply;
     std::string mediaId;
 
-    std::string recordXml = record_conf_xml (conf_id, audio_uri, audio_type, audio_codec, audio_rate,
-					     video_uri, video_type, video_codec, video_level,
-					     video_height, video_width, video_maxbitrate, video_framerate,
-						record_time);
+    const std::string & recordXml = record_conf_xml (conf_id, audio_uri, audio_type, audio_codec, audio_rate,
+                                                     video_uri, video_type, video_codec, video_level,
+                                                     video_height, video_width, video_maxbitrate, video_framerate,
+                                                     record_time);
 
-    reply = dispatchPut ("/default/conferences/", recordXml, conf_id);
+    reply = dispatchPut ("record_conference", "/default/conferences/", recordXml, conf_id);
     if (!reply.empty ())
     {
         xmsReplyParser *parser = new xmsReplyParser (reply, recordConference);
-        mediaId = parser->getMediaId ();
+        mediaId = EventCapture::Instance ()->serverId ("record", parser->getMediaId ());
         delete parser;
         return mediaId;
     }
@@ -377,10 +197,10 @@ record_conference (std::string conf_id,
 }
 
 int
-stop (std::string confId, std::string transactionId)
+stop (const std::string & confId, const std::string & transactionId, RestCompletionCallback callback, void *userp)
 {
-    std::string stopXml = stop_xml (transactionId);
-    dispatchPut ("/default/conferences/", stopXml, confId);
+    const std::string & stopXml = stop_xml (transactionId);
+    dispatchPutAsync ("stop", "/default/conferences/", stopXml, confId, callback, userp);
     return 0;
 }
 
@@ -436,51 +256,60 @@ create_conference (const char *reserve, const char *max_parties, const char *lay
 {
 
     std::string confId;
-    std::string createConfXml = create_conference_xml (reserve, max_parties, layout, layout_size);
-    std::string reply = dispatchPost ("/default/conferences?appid=app", createConfXml);
+    const std::string & createConfXml = create_conference_xml (reserve, max_parties, layout, layout_size);
+    // The conference goes on the node of the call that asked for it, or
+    // nowhere: XMS can only join a call to a conference on its own server
+    int node = XmsNodePool::Instance ()->placeNew ();
+    std::string reply = dispatchPost ("create_conference", "/default/conferences?appid=app", createConfXml, node);
     if (!reply.empty ())
     {
         xmsReplyParser *parser = new xmsReplyParser (reply, createConference);
-        std::string confId = parser->getConfId ();
+        // On replay, the ID the recorded events know it by
+        confId = EventCapture::Instance ()->serverId ("conference", parser->getConfId ());
         delete parser;
-        return confId;
+        XmsNodePool::Instance ()->bind (confId, node, XMS_CONFERENCE);
     }
     else
     {
         LOGCRIT ("No conference ID from create conference POST");
-        return confId;
     }
+    return confId;
 }
 
 
 int
-destroy_conference (std::string conf_id)
+destroy_conference (const std::string & conf_id, RestCompletionCallback callback, void *userp)
 {
 
-    dispatchDelete ("/default/conferences/", conf_id);
+    dispatchDeleteAsync ("destroy_conference", "/default/conferences/", conf_id, callback, userp);
+    // The DELETE has its node; later commands for the ID have no use for it
+    XmsNodePool::Instance ()->unbind (conf_id);
     return 0;
 }
 
 int
-destroy_eventhandler (std::string evhandler_id)
+destroy_eventhandler (const std::string & evhandler_id)
 {
 
-    dispatchDelete ("/default/eventhandlers/", evhandler_id);
+    // Sent at shutdown and nothing needs the reply, so it goes out with
+    // whatever else is queued rather than holding up the caller
+    dispatchDeleteAsync ("destroy_eventhandler", "/default/eventhandlers/", evhandler_id, NULL, NULL);
+    XmsNodePool::Instance ()->unbind (evhandler_id);
     return 0;
 }
 
 int
-add_party (std::string call_id, std::string conf_id, const char *region)
+add_party (const std::string & call_id, const std::string & conf_id, const char *region, RestCompletionCallback callback, void *userp)
 {
-    std::string addPartyXml = add_party_xml (conf_id, region);
+    const std::string & addPartyXml = add_party_xml (conf_id, region);
     //LOGDEBUG("Wrapper - add_party xml - " << addPartyXml);
-    dispatchPut ("/default/calls/", addPartyXml, call_id);
+    dispatchPutAsync ("add_party", "/default/calls/", addPartyXml, call_id, callback, userp);
     // JH - error handling!!
     return 0;
 }
 
 int
-remove_party (std::string call_id)
+remove_party (const std::string & call_id)
 {
 /****************************** rest
     struct xms_param *request = xms_param_new ();
@@ -502,10 +331,11 @@ remove_party (std::string call_id)
 }
 
 int
-update_party (std::string call_id, const char *audio, const char *video, const char *region)
+update_party (const std::string & call_id, const char *audio, const char *video, const char *region,
+              RestCompletionCallback callback, void *userp)
 {
-    std::string updatePartyXml = update_party_xml (audio, video, region);
-    dispatchPut ("/default/calls/", updatePartyXml, call_id);
+    const std::string & updatePartyXml = update_party_xml (audio, video, region);
+    dispatchPutAsync ("update_party", "/default/calls/", updatePartyXml, call_id, callback, userp);
     // JH - error handling!!
     return 0;
 
@@ -565,7 +395,7 @@ update_party (std::string call_id, const char *audio, const char *video, const c
 
 
 int
-update_call (std::string call_id, const char *tx_volume, const char *rx_volume, int async_dtmf, int async_tone)
+update_call (const std::string & call_id, const char *tx_volume, const char *rx_volume, int async_dtmf, int async_tone)
 {
 /***********************************rest
     struwct xms_param *request = xms_param_new ();
@@ -649,7 +479,7 @@ unjoin (const char *call_id, const char *call_id2)
  *  * Test xms_dial()
  *   */
 int
-dial (std::string call_id, const char *dest_uri, const char *called_uri, const char *caller_uri, int cpa)
+dial (const std::string & call_id, const char *dest_uri, const char *called_uri, const char *caller_uri, int cpa)
 {
 /*****************************************rest
     struct xms_param *request = xms_param_new ();
@@ -684,7 +514,7 @@ dial (std::string call_id, const char *dest_uri, const char *called_uri, const c
 
 
 char *
-overlay (std::string call_id, const char *uri, const char *duration, const char *direction)
+overlay (const std::string & call_id, const char *uri, const char *duration, const char *direction)
 {
 /***************************************rest
     struct xms_param *request = xms_param_new ();
@@ -724,10 +554,11 @@ overlay (std::string call_id, const char *uri, const char *duration, const char
 }
 
 int
-update_conference (std::string conf_id, const char *layout_size, const char *layout_regions, const char *region_overlays)
+update_conference (const std::string & conf_id, const char *layout_size, const char *layout_regions, const char *region_overlays,
+                   RestCompletionCallback callback, void *userp)
 {
-    std::string updateConfXml = update_conference_xml (layout_regions, layout_size, region_overlays);
-    dispatchPut ("/default/conferences/", updateConfXml, conf_id);
+    const std::string & updateConfXml = update_conference_xml (layout_regions, layout_size, region_overlays);
+    dispatchPutAsync ("update_conference", "/default/conferences/", updateConfXml, conf_id, callback, userp);
     return 0;
 /****************************************rest
     struct xms_param *request = xms_param_new ();
@@ -800,7 +631,7 @@ update_play (const char *media_id, const char *action, const char *region)
  *  *  * Test xms_send_info()
  *   *   */
 int
-send_info (std::string call_id, const char *content_type, const char *content)
+send_info (const std::string & call_id, const char *content_type, const char *content)
 {
 /**********************************88rest
     struct xms_param *request = xms_param_new ();
@@ -21,11 +21,13 @@
  */
 
 #ifndef _DISPATCHXMSCMD_H
-#define __DISPATCHXMSCMD_H
+#define _DISPATCHXMSCMD_H
 
 /*------------------------------ Dependencies --------------------------------*/
 
 //#include <xms.h>
+#include <string>
+#include "restdispatcher.h"
 
 /*----------------------------------------------------------------------------*/
 
@@ -37,9 +39,14 @@
 
 //struct xms_param *get_event ();
 
-int answer (std::string call_id, const char *dtmf_mode);
+// Commands without a reply payload are queued on the REST dispatcher and
+// return at once. The optional callback runs on the dispatcher thread when
+// XMS answers.  Commands that return an ID wait for the reply, but are still
+// ordered behind earlier commands on the same call or conference.
 
-int hangup (std::string call_id);
+int answer (const std::string & call_id, const char *dtmf_mode, RestCompletionCallback callback = NULL, void *userp = NULL);
+
+int hangup (const std::string & call_id, RestCompletionCallback callback = NULL, void *userp = NULL);
 
 
 char *play (const char *id,
@@ -47,7 +54,7 @@ char *play (const char *id,
             const char *audio_type,
             const char *audio_base_uri, const char *video_uri, const char *video_type, const char *video_base_uri);
 
-std::string play_into_conf (std::string conf_id,
+std::string play_into_conf (const std::string & conf_id,
                       const char *audio_uri,
                       const char *audio_type,
                       const char *audio_base_uri,
@@ -55,7 +62,7 @@ std::string play_into_conf (std::string conf_id,
                       const char *repeat);
 
 std::string
-record_conference (std::string conf_id,
+record_conference (const std::string & conf_id,
                    const char *audio_uri,
                    const char *audio_type,
                    const char *audio_codec,
@@ -66,32 +73,35 @@ record_conference (std::string conf_id,
                    const char *video_level,
                    const char *video_height, const char *video_width, const char *video_maxbitrate, const char *video_framerate, const char *record_time);
 
-int stop (std::string confId, std::string transactionId);
+int stop (const std::string & confId, const std::string & transactionId, RestCompletionCallback callback = NULL, void *userp = NULL);
 
 char *create_call (int signaling, const char *sdp, const char *dtmf_mode);
 
 std::string create_conference (const char *reserve, const char *max_parties, const char *layout,  const char *layout_size);
 
-int destroy_conference (std::string conf_id);
+int destroy_conference (const std::string & conf_id, RestCompletionCallback callback = NULL, void *userp = NULL);
 
-int destroy_eventhandler (std::string evhandler_id);
+int destroy_eventhandler (const std::string & evhandler_id);
 
-int add_party (std::string call_id, std::string conf_id, const char *region);
+int add_party (const std::string & call_id, const std::string & conf_id, const char *region,
+               RestCompletionCallback callback = NULL, void *userp = NULL);
 
-int remove_party (std::string call_id);
+int remove_party (const std::string & call_id);
 
-int update_party (std::string call_id, const char *audio, const char *video, const char *region);
+int update_party (const std::string & call_id, const char *audio, const char *video, const char *region,
+                  RestCompletionCallback callback = NULL, void *userp = NULL);
 
-int update_call (std::string call_id, const char *tx_volume, const char *rx_volume, int async_dtmf, int async_tone);
+int update_call (const std::string & call_id, const char *tx_volume, const char *rx_volume, int async_dtmf, int async_tone);
 
 //int unjoin (const char *call_id, const char *call_id2);
 //int join (const char *call_id, const char *call_id2);
-int dial (std:: string call_id, const char *dest_uri, const char *called_uri, const char *caller_uri, int cpa);
-char *overlay (std::string call_id, const char *uri, const char *duration, const char *direction);
+int dial (const std::string & call_id, const char *dest_uri, const char *called_uri, const char *caller_uri, int cpa);
+char *overlay (const std::string & call_id, const char *uri, const char *duration, const char *direction);
 
-int update_conference (std::string conf_id, const char *layout_regions, const char *layout_size, const char *region_overlays);
+int update_conference (const std::string & conf_id, const char *layout_size, const char *layout_regions, const char *region_overlays,
+                       RestCompletionCallback callback = NULL, void *userp = NULL);
 int update_play (const char *media_id, const char *action, const char *region);
-int send_info (std::string call_id, const char *content_type, const char *content);
+int send_info (const std::string & call_id, const char *content_type, const char *content);
 
 #endif // _DISPATCHXMSCMD_H
 
@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <string.h>
+#include <unistd.h>
+
+#include "logger.h"
+#include "eventcapture.h"
+#include "eventtrace.h"
+#include "eventworkers.h"
+#include "xmsnodepool.h"
+#include "xmseventparser.h"
+
+/*----------------------------------------------------------------------------*/
+
+EventCapture *
+    EventCapture::pInstance_ = NULL;
+bool
+    EventCapture::recording_ = false;
+bool
+    EventCapture::replaying_ = false;
+__thread const xmsEventParser *
+    EventCapture::currentEvent_ = NULL;
+
+const char
+    EventCapture::MAGIC[] = "XMSEVENTS 1\n";
+
+/*
+ * ctor
+ */
+EventCapture::EventCapture ()
+{
+    file_ = NULL;
+    startUs_ = 0;
+    speed_ = 1;
+    numNodes_ = 1;
+    threadStarted_ = false;
+    stopping_ = 0;
+    routed_ = 0;
+    finished_ = NULL;
+    replayStartUs_ = 0;
+    pthread_mutex_init (&lock_, NULL);
+}
+
+/*
+ * dtor
+ */
+EventCapture::~EventCapture ()
+{
+    closeRecording ();
+    pthread_mutex_destroy (&lock_);
+}
+
+bool
+EventCapture::openRecording (const std::string & path)
+{
+    pthread_mutex_lock (&lock_);
+    file_ = fopen (path.c_str (), "wb");
+    if (!file_)
+    {
+        pthread_mutex_unlock (&lock_);
+        LOGCRIT ("Cannot open event recording " << path);
+        return false;
+    }
+    // Written from the event handler thread, so keep syscalls rare
+    setvbuf (file_, NULL, _IOFBF, 1 << 20);
+    fwrite (MAGIC, 1, sizeof (MAGIC) - 1, file_);
+    startUs_ = EventTrace::now ();
+    __atomic_store_n (&recording_, true, __ATOMIC_RELAXED);
+    pthread_mutex_unlock (&lock_);
+    LOGINFO ("Recording events to " << path);
+    return true;
+}
+
+void
+EventCapture::closeRecording ()
+{
+    pthread_mutex_lock (&lock_);
+    __atomic_store_n (&recording_, false, __ATOMIC_RELAXED);
+    if (file_)
+    {
+        fclose (file_);
+        file_ = NULL;
+    }
+    pthread_mutex_unlock (&lock_);
+}
+
+void
+EventCapture::writeRecord (RecordType type, int node, const char *data, size_t length)
+{
+    RecordHeader header;
+    memset (&header, 0, sizeof (header));
+    header.length = length;
+    header.type = type;
+    header.node = node;
+
+    pthread_mutex_lock (&lock_);
+    if (file_)
+    {
+        header.offsetUs = EventTrace::now () - startUs_;
+        fwrite (&header, sizeof (header), 1, file_);
+        fwrite (data, 1, length, file_);
+    }
+    pthread_mutex_unlock (&lock_);
+}
+
+void
+EventCapture::recordEvent (const char *event, size_t length, int node)
+{
+    writeRecord (RECORD_EVENT, node, event, length);
+}
+
+std::string
+EventCapture::serverId (const char *kind, const std::string & id)
+{
+    if (!currentEvent_ || (!recording () && !replaying_))
+        return id;
+
+    // A call asks for its IDs in the same order on replay, but calls
+    // interleave differently, so each call keeps its own list
+    std::string key = std::string (kind) + '\n' + currentEvent_->findValByKey ("call_id");
+    if (replaying_)
+    {
+        pthread_mutex_lock (&lock_);
+        std::string recorded = id;
+        std::map < std::string, std::deque < std::string > >::iterator id_iterator = serverIds_.find (key);
+        if (id_iterator != serverIds_.end ())
+        {
+            recorded = id_iterator->second.front ();
+            id_iterator->second.pop_front ();
+            if (id_iterator->second.empty ())
+                serverIds_.erase (id_iterator);
+        }
+        pthread_mutex_unlock (&lock_);
+        LOGDEBUG ("Replay: " << kind << " " << id << " is " << recorded << " in the recording");
+        return recorded;
+    }
+
+    std::string record = key + '\n' + id;
+    writeRecord (RECORD_SERVER_ID, -1, record.data (), record.size ());
+    return id;
+}
+
+bool
+EventCapture::loadReplay (const std::string & path)
+{
+    FILE *file = fopen (path.c_str (), "rb");
+    if (!file)
+    {
+        LOGCRIT ("Cannot open event recording " << path);
+        return false;
+    }
+    char buf[65536];
+    size_t got;
+    while ((got = fread (buf, 1, sizeof (buf), file)) > 0)
+        replayData_.append (buf, got);
+    fclose (file);
+
+    if (replayData_.compare (0, sizeof (MAGIC) - 1, MAGIC) != 0)
+    {
+        LOGCRIT (path << " is not an event recording");
+        return false;
+    }
+
+    size_t offset = sizeof (MAGIC) - 1;
+    size_t numServerIds = 0;
+    while (offset + sizeof (RecordHeader) <= replayData_.size ())
+    {
+        RecordHeader header;
+        memcpy (&header, replayData_.data () + offset, sizeof (header));
+        offset += sizeof (header);
+        if (offset + header.length > replayData_.size ())
+            break;
+
+        if (header.type == RECORD_EVENT)
+        {
+            ReplayEvent event;
+            event.offset = offset;
+            event.length = header.length;
+            event.node = header.node;
+            event.offsetUs = header.offsetUs;
+            events_.push_back (event);
+        }
+        else if (header.type == RECORD_SERVER_ID)
+        {
+            std::string record = replayData_.substr (offset, header.length);
+            std::string::size_type split = record.rfind ('\n');
+            if (split != std::string::npos)
+            {
+                serverIds_[record.substr (0, split)].push_back (record.substr (split + 1));
+                numServerIds++;
+            }
+        }
+        offset += header.length;
+    }
+    if (offset != replayData_.size ())
+        LOGWARN ("Event recording " << path << " ends in a partial record. Replaying what is complete");
+
+    replaying_ = true;
+    LOGNOTICE ("Loaded " << events_.size () << " events and " << numServerIds << " XMS assigned IDs from " << path);
+    return true;
+}
+
+bool
+EventCapture::startReplay (double speed, int numNodes, void (*finished) (void))
+{
+    speed_ = speed;
+    finished_ = finished;
+    numNodes_ = numNodes < 1 ? 1 : numNodes;
+    replayStartUs_ = EventTrace::now ();
+    if (pthread_create (&thread_, NULL, replayThread, (void *) this))
+    {
+        LOGCRIT ("Cannot create event replay thread");
+        return false;
+    }
+    threadStarted_ = true;
+    return true;
+}
+
+void
+EventCapture::stopReplay ()
+{
+    if (!threadStarted_)
+        return;
+    __atomic_store_n (&stopping_, 1, __ATOMIC_RELAXED);
+    pthread_join (thread_, NULL);
+    threadStarted_ = false;
+}
+
+void *
+EventCapture::replayThread (void *voidPtr)
+{
+    ((EventCapture *) voidPtr)->replay ();
+    return NULL;
+}
+
+void
+EventCapture::replay ()
+{
+    // Waits are cut into slices so stopReplay is not held up by a long gap
+    static const uint64_t WAIT_SLICE_US = 100000;
+    std::vector < ReplayEvent >::const_iterator event_iterator;
+    for (event_iterator = events_.begin (); event_iterator != events_.end (); event_iterator++)
+    {
+        if (speed_ > 0)
+        {
+            uint64_t dueUs = replayStartUs_ + (uint64_t) (event_iterator->offsetUs / speed_);
+            uint64_t nowUs = EventTrace::now ();
+            while (dueUs > nowUs && !__atomic_load_n (&stopping_, __ATOMIC_RELAXED))
+            {
+                usleep (dueUs - nowUs < WAIT_SLICE_US ? dueUs - nowUs : WAIT_SLICE_US);
+                nowUs = EventTrace::now ();
+            }
+        }
+        if (__atomic_load_n (&stopping_, __ATOMIC_RELAXED))
+        {
+            LOGNOTICE ("Replay stopped after " << event_iterator - events_.begin () << " of " << events_.size () << " events");
+            return;
+        }
+        // As the event handler thread of the node it came from would
+        int node = event_iterator->node < 0 ? 0 : event_iterator->node % numNodes_;
+        XmsNodePool::setCurrentNode (node);
+        EventWorkers::Instance ()->route (replayData_.data () + event_iterator->offset, event_iterator->length, node);
+        __atomic_store_n (&routed_, routed_ + 1, __ATOMIC_RELAXED);
+    }
+    LOGNOTICE ("Replay: all " << events_.size () << " events routed in " <<
+               (EventTrace::now () - replayStartUs_) / 1000 << " ms");
+    if (finished_)
+        finished_ ();
+}
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+#ifndef _EVENTCAPTURE_H
+#define _EVENTCAPTURE_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <pthread.h>
+
+/*----------------------------------------------------------------------------*/
+
+class xmsEventParser;
+
+/*!
+ * \class EventCapture
+ * Records the events XMS sends, and replays a recording through the
+ * normal worker rings and Conference720p::onEvent, so an incident can be
+ * reproduced and profiled without the media server.
+ *
+ * A recording is a magic line followed by length prefixed records in
+ * host byte order, each stamped with microseconds since recording began:
+ *  - EVENT: one complete event as it came off the long poll, and the
+ *    XMS node it came from
+ *  - SERVER_ID: an ID XMS handed out in a REST reply (a conference, or
+ *    a play or record transaction), and the call whose event asked for
+ *    it.  Replayed events refer to these IDs, so on replay the app takes
+ *    the recorded one rather than whatever the sink or stand-in server
+ *    returned
+ *
+ * Replay runs on its own thread in place of the event handler threads. It
+ * paces the events at their recorded spacing divided by the speed, or
+ * sends them as fast as the rings take them for speed 0.
+ *
+ * The class is a singleton.
+ */
+class EventCapture
+{
+  public:
+    ~EventCapture ();
+
+    static EventCapture *Instance ()
+    {
+        if (!pInstance_)
+            pInstance_ = new EventCapture;
+
+        return pInstance_;
+    }
+
+    /*!
+     * Record to path from now on. Call before the event handler threads start.
+     */
+    bool openRecording (const std::string & path);
+
+    /*!
+     * Flush and stop recording.
+     */
+    void closeRecording ();
+
+    static bool recording ()
+    {
+        return __atomic_load_n (&recording_, __ATOMIC_RELAXED);
+    }
+
+    /*!
+     * Event handler threads. Append one complete event from node.
+     */
+    void recordEvent (const char *event, size_t length, int node);
+
+    /*!
+     * Read a recording into memory, so disk reads don't pace the replay.
+     */
+    bool loadReplay (const std::string & path);
+
+    /*!
+     * Start routing the loaded events to the workers. Recorded node
+     * indexes are folded onto numNodes. finished is called on the replay
+     * thread once every event is routed.
+     */
+    bool startReplay (double speed, int numNodes, void (*finished) (void));
+
+    /*!
+     * Stop routing events if the replay is still going, and wait for the
+     * replay thread. Call before the workers stop.
+     */
+    void stopReplay ();
+
+    static bool replaying ()
+    {
+        return replaying_;
+    }
+
+    /*!
+     * Events routed so far; all of them once the replay has finished.
+     */
+    size_t replayEvents () const
+    {
+        return __atomic_load_n (&routed_, __ATOMIC_RELAXED);
+    }
+
+    uint64_t replayStartUs () const
+    {
+        return replayStartUs_;
+    }
+
+    /*!
+     * Event workers. The event being handled on this thread, NULL between events.
+     */
+    static void setCurrentEvent (const xmsEventParser * event)
+    {
+        currentEvent_ = event;
+    }
+
+    /*!
+     * XMS returned id, of kind "conference", "play" or "record", for a
+     * request the current event made. Recording, it is written down;
+     * replaying, the ID it had when recorded is returned in its place.
+     */
+    std::string serverId (const char *kind, const std::string & id);
+
+  private:
+    /*!
+     * ctor. Hide here as class is a singleton
+     */
+    EventCapture ();
+
+    enum RecordType
+    { RECORD_EVENT = 1, RECORD_SERVER_ID = 2 };
+
+    struct RecordHeader
+    {
+        uint32_t length;        // of what follows the header
+        uint16_t type;
+        int16_t node;
+        uint64_t offsetUs;      // since recording began
+    };
+
+    struct ReplayEvent
+    {
+        size_t offset;          // into replayData_
+        uint32_t length;
+        int node;
+        uint64_t offsetUs;
+    };
+
+    static const char MAGIC[];
+
+    static void *replayThread (void *voidPtr);
+    void replay ();
+    void writeRecord (RecordType type, int node, const char *data, size_t length);
+
+    static EventCapture *pInstance_;
+    static bool recording_;
+    static bool replaying_;
+    static __thread const xmsEventParser *currentEvent_;
+
+    // The recording file, or on replay serverIds_
+    pthread_mutex_t lock_;
+    FILE *file_;
+    uint64_t startUs_;
+
+    // Replay. Loaded before the replay thread starts
+    std::string replayData_;
+    std::vector < ReplayEvent > events_;
+    // Kind and call ID -> IDs in the order they were handed out
+    std::map < std::string, std::deque < std::string > >serverIds_;
+    double speed_;
+    int numNodes_;
+    pthread_t thread_;
+    bool threadStarted_;
+    int stopping_;              // set by stopReplay, read by the replay thread
+    size_t routed_;
+    void (*finished_) (void);
+    uint64_t replayStartUs_;
+};
+
+#endif // _EVENTCAPTURE_H
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+#ifndef _EVENTFRAMER_H
+#define _EVENTFRAMER_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <string.h>
+#include "logger.h"
+
+/*----------------------------------------------------------------------------*/
+
+// class EventFramer - split the XMS long poll byte stream into events.
+//
+// The long poll GET stays open and XMS writes one <web_service> document per
+// event, each preceded by a few bytes of framing. cURL hands us whatever
+// arrived on the socket: a chunk can hold several events, or only part of
+// one. Bytes are appended to a fixed buffer and each complete document is
+// passed to the event callback as a pointer/length slice into that buffer.
+// Nothing is allocated per event.
+
+class EventFramer
+{
+  public:
+    typedef void (*EventCallback) (const char *event, size_t length, void *userp);
+
+    // Largest single event we expect from XMS, with room to spare
+    static const size_t BUFFER_SIZE = 64 * 1024;
+
+    EventFramer (EventCallback callback, void *userp)
+    {
+        callback_ = callback;
+        userp_ = userp;
+        head_ = 0;
+        tail_ = 0;
+        resync_ = false;
+    }
+
+    // Feed bytes from the socket. Returns the number of bytes consumed,
+    // which is always length; an event too big for the buffer is dropped.
+    size_t append (const char *data, size_t length)
+    {
+        size_t consumed = 0;
+        while (consumed < length)
+        {
+            if (tail_ == BUFFER_SIZE)
+            {
+                // Slide the partial event at head_ back to the start
+                if (head_ == 0)
+                {
+                    LOGERROR ("XMS event larger than " << BUFFER_SIZE << " bytes. Dropping it");
+                    head_ = tail_ = 0;
+                    resync_ = true;
+                }
+                else
+                {
+                    memmove (buffer_, buffer_ + head_, tail_ - head_);
+                    tail_ -= head_;
+                    head_ = 0;
+                }
+            }
+            size_t room = BUFFER_SIZE - tail_;
+            size_t n = (length - consumed < room) ? length - consumed : room;
+            memcpy (buffer_ + tail_, data + consumed, n);
+            tail_ += n;
+            consumed += n;
+            extractEvents ();
+        }
+        return length;
+    }
+
+  private:
+    EventFramer (const EventFramer &);
+    EventFramer & operator = (const EventFramer &);
+
+    void extractEvents ()
+    {
+        static const char endTag[] = "</web_service>";
+        static const size_t endTagLength = sizeof (endTag) - 1;
+
+        while (head_ < tail_)
+        {
+            // Skip framing bytes up to the start of the next document
+            const char *start = (const char *) memchr (buffer_ + head_, '<', tail_ - head_);
+            if (!start)
+            {
+                head_ = tail_ = 0;
+                return;
+            }
+            head_ = start - buffer_;
+
+            const char *end = (const char *) memmem (start, tail_ - head_, endTag, endTagLength);
+            if (!end)
+                break;          // rest of this event is still on the way
+            size_t length = (end + endTagLength) - start;
+
+            if (resync_)
+            {
+                // Tail end of a dropped oversize event
+                resync_ = false;
+            }
+            else
+            {
+                callback_ (start, length, userp_);
+            }
+            head_ += length;
+        }
+        if (head_ == tail_)
+            head_ = tail_ = 0;
+    }
+
+    EventCallback callback_;
+    void *userp_;
+    size_t head_;               // first byte not yet passed on
+    size_t tail_;               // end of received data
+    bool resync_;
+    char buffer_[BUFFER_SIZE];
+};
+
+#endif // _EVENTFRAMER_H
+/* vim:ts=4:set nu:
+ * EOF
+ */
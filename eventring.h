@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+#ifndef _EVENTRING_H
+#define _EVENTRING_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+/*----------------------------------------------------------------------------*/
+
+/*!
+ * \struct EventBuffer
+ * One slot of the event ring. The memory belongs to the slot and is reused
+ * for every event that passes through it; it only grows.
+ */
+struct EventBuffer
+{
+    char *data;
+    size_t length;
+    size_t capacity;
+    int source;                 // XMS node the event came from
+    uint64_t traceId;           // EventTrace ID, 0 if not traced
+    uint64_t queuedUs;          // when it was pushed, if traced
+};
+
+/*!
+ * \class EventRing
+ * Bounded single producer / single consumer queue of raw XMS events.
+ * There is one producer, the event handler threads taking turns under the
+ * router's lock, and one event worker as the only consumer, so the ring
+ * itself needs no lock: each side owns one index and publishes it
+ * with a release store.  An eventfd counts wakeups, so a signal sent while
+ * the consumer is busy is never lost, and the consumer drains every ready
+ * event per wakeup.
+ */
+class EventRing
+{
+  public:
+    // Must be a power of two
+    static const size_t CAPACITY = 1024;
+
+    EventRing ()
+    {
+        head_ = 0;
+        tail_ = 0;
+        eventFd_ = -1;
+        for (size_t i = 0; i < CAPACITY; i++)
+        {
+            slots_[i].data = NULL;
+            slots_[i].length = 0;
+            slots_[i].capacity = 0;
+            slots_[i].source = -1;
+            slots_[i].traceId = 0;
+            slots_[i].queuedUs = 0;
+        }
+    }
+
+    ~EventRing ()
+    {
+        for (size_t i = 0; i < CAPACITY; i++)
+            free (slots_[i].data);
+        if (eventFd_ >= 0)
+            close (eventFd_);
+    }
+
+    /*!
+     * Create the wakeup eventfd. Call once before either thread starts.
+     */
+    bool init ()
+    {
+        eventFd_ = eventfd (0, 0);
+        return eventFd_ >= 0;
+    }
+
+    /*!
+     * Producer side. Copy an event into the next free slot and publish it.
+     * Returns false if the ring is full.
+     */
+    bool push (const char *event, size_t length, int source = -1, uint64_t traceId = 0, uint64_t queuedUs = 0)
+    {
+        size_t tail = __atomic_load_n (&tail_, __ATOMIC_RELAXED);
+        size_t head = __atomic_load_n (&head_, __ATOMIC_ACQUIRE);
+        if (tail - head == CAPACITY)
+            return false;
+
+        EventBuffer & slot = slots_[tail & (CAPACITY - 1)];
+        if (slot.capacity < length + 1)
+        {
+            char *grown = (char *) realloc (slot.data, length + 1);
+            if (!grown)
+                return false;
+            slot.data = grown;
+            slot.capacity = length + 1;
+        }
+        memcpy (slot.data, event, length);
+        slot.data[length] = 0;
+        slot.length = length;
+        slot.source = source;
+        slot.traceId = traceId;
+        slot.queuedUs = queuedUs;
+
+        __atomic_store_n (&tail_, tail + 1, __ATOMIC_RELEASE);
+        wakeup ();
+        return true;
+    }
+
+    /*!
+     * Consumer side. Oldest event, or NULL if the ring is empty. The slot
+     * stays valid until pop().
+     */
+    EventBuffer *front ()
+    {
+        size_t head = __atomic_load_n (&head_, __ATOMIC_RELAXED);
+        size_t tail = __atomic_load_n (&tail_, __ATOMIC_ACQUIRE);
+        if (head == tail)
+            return NULL;
+        return &slots_[head & (CAPACITY - 1)];
+    }
+
+    /*!
+     * Consumer side. Hand the oldest slot back to the producer.
+     */
+    void pop ()
+    {
+        size_t head = __atomic_load_n (&head_, __ATOMIC_RELAXED);
+        __atomic_store_n (&head_, head + 1, __ATOMIC_RELEASE);
+    }
+
+    /*!
+     * Wake the consumer. Only calls write(), so it is safe from a signal
+     * handler.
+     */
+    void wakeup ()
+    {
+        uint64_t one = 1;
+        if (write (eventFd_, &one, sizeof (one)) < 0)
+        {
+            // Counter saturated; the consumer has wakeups pending anyway
+        }
+    }
+
+    /*!
+     * Consumer side. Block until at least one wakeup has been posted.
+     */
+    void wait ()
+    {
+        uint64_t count;
+        if (read (eventFd_, &count, sizeof (count)) < 0)
+        {
+            // EINTR; caller re-checks the ring and its exit flag
+        }
+    }
+
+  private:
+    EventRing (const EventRing &);
+    EventRing & operator = (const EventRing &);
+
+    // Indices only ever increase; slot is index & (CAPACITY - 1).
+    // Kept on separate cache lines so the two threads don't share one.
+    size_t head_;               // written by consumer
+    char pad1_[64 - sizeof (size_t)];
+    size_t tail_;               // written by producer
+    char pad2_[64 - sizeof (size_t)];
+    int eventFd_;
+    EventBuffer slots_[CAPACITY];
+};
+
+#endif // _EVENTRING_H
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sstream>
+
+#include "logger.h"
+#include "eventtrace.h"
+
+/*----------------------------------------------------------------------------*/
+
+EventTrace *
+    EventTrace::pInstance_ = NULL;
+bool
+    EventTrace::enabled_ = false;
+__thread uint64_t
+    EventTrace::currentTrace_ = 0;
+__thread int
+    EventTrace::threadId_ = 0;
+
+/*
+ * ctor
+ */
+EventTrace::EventTrace ()
+{
+    nextTraceId_ = 0;
+    file_ = NULL;
+    firstRecord_ = true;
+    pthread_mutex_init (&lock_, NULL);
+}
+
+/*
+ * dtor
+ */
+EventTrace::~EventTrace ()
+{
+    close ();
+    pthread_mutex_destroy (&lock_);
+}
+
+bool
+EventTrace::open (const std::string & path)
+{
+    pthread_mutex_lock (&lock_);
+    file_ = fopen (path.c_str (), "w");
+    if (!file_)
+    {
+        pthread_mutex_unlock (&lock_);
+        LOGCRIT ("Cannot open event trace file " << path);
+        return false;
+    }
+    fputs ("[\n", file_);
+    firstRecord_ = true;
+    __atomic_store_n (&enabled_, true, __ATOMIC_RELAXED);
+    pthread_mutex_unlock (&lock_);
+    LOGINFO ("Tracing events to " << path);
+    return true;
+}
+
+void
+EventTrace::close ()
+{
+    pthread_mutex_lock (&lock_);
+    __atomic_store_n (&enabled_, false, __ATOMIC_RELAXED);
+    if (file_)
+    {
+        fputs ("\n]\n", file_);
+        fclose (file_);
+        file_ = NULL;
+    }
+    pthread_mutex_unlock (&lock_);
+}
+
+int
+EventTrace::threadId ()
+{
+    if (!threadId_)
+        threadId_ = (int) syscall (SYS_gettid);
+    return threadId_;
+}
+
+void
+EventTrace::appendEscaped (std::string & out, const std::string & value)
+{
+    for (std::string::const_iterator c = value.begin (); c != value.end (); c++)
+    {
+        if (*c == '"' || *c == '\\')
+            out += '\\';
+        if ((unsigned char) *c >= ' ')
+            out += *c;
+    }
+}
+
+void
+EventTrace::span (const char *name, const char *category, uint64_t traceId, uint64_t startUs, uint64_t endUs,
+                  const std::string & detail, bool startsFlow)
+{
+    if (endUs < startUs)
+        endUs = startUs;
+
+    // Formatted outside the lock; the lock only covers the write
+    std::ostringstream record;
+    record << "{\"name\":\"" << name << "\",\"cat\":\"" << category << "\",\"ph\":\"X\",\"pid\":" << getpid ()
+        << ",\"tid\":" << threadId () << ",\"ts\":" << startUs << ",\"dur\":" << endUs - startUs
+        << ",\"args\":{\"trace\":" << traceId;
+    std::string text = record.str ();
+    if (!detail.empty ())
+    {
+        text += ",\"detail\":\"";
+        appendEscaped (text, detail);
+        text += "\"";
+    }
+    text += "}}";
+
+    if (traceId)
+    {
+        // Flow events bind to the span enclosing their timestamp
+        std::ostringstream flow;
+        flow << ",\n{\"name\":\"event\",\"cat\":\"flow\",\"ph\":\"" << (startsFlow ? "s" : "t")
+            << "\",\"id\":" << traceId << ",\"pid\":" << getpid () << ",\"tid\":" << threadId ()
+            << ",\"ts\":" << startUs << "}";
+        text += flow.str ();
+    }
+
+    pthread_mutex_lock (&lock_);
+    if (file_)
+    {
+        if (!firstRecord_)
+            fputs (",\n", file_);
+        firstRecord_ = false;
+        fputs (text.c_str (), file_);
+    }
+    pthread_mutex_unlock (&lock_);
+}
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+#ifndef _EVENTTRACE_H
+#define _EVENTTRACE_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <string>
+#include <pthread.h>
+
+/*----------------------------------------------------------------------------*/
+
+/*!
+ * \class EventTrace
+ * Optional trace of each XMS event through the application, written as
+ * Chrome trace-event JSON (load it in chrome://tracing or Perfetto).
+ *
+ * Every event gets a trace ID when it comes off the long poll socket.
+ * The spans recorded under it are:
+ *  - receive: event handler thread, from the socket read to the event
+ *    sitting in its worker's ring
+ *  - queue: time in the ring until the worker picks it up
+ *  - parse, handle: the worker tokenizing the event and running onEvent
+ *  - one span per REST request the handler issues, on the dispatcher
+ *    thread, split into the wait behind earlier requests on the same
+ *    resource and the round trip to XMS
+ * The spans of one event are tied together by a flow, so the viewer draws
+ * an arrow from the socket to each REST call it caused.
+ *
+ * Nothing is timed unless a trace file is open; each site tests
+ * enabled() first.  The class is a singleton.
+ */
+class EventTrace
+{
+  public:
+    ~EventTrace ();
+
+    static EventTrace *Instance ()
+    {
+        if (!pInstance_)
+            pInstance_ = new EventTrace;
+
+        return pInstance_;
+    }
+
+    /*!
+     * Start tracing to path. Call before the threads that trace start.
+     */
+    bool open (const std::string & path);
+
+    /*!
+     * Finish the JSON and stop tracing.
+     */
+    void close ();
+
+    static bool enabled ()
+    {
+        return __atomic_load_n (&enabled_, __ATOMIC_RELAXED);
+    }
+
+    /*!
+     * Monotonic clock in microseconds, the trace's time base.
+     */
+    static uint64_t now ()
+    {
+        struct timespec ts;
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+        return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    }
+
+    static uint64_t toMicroseconds (const struct timespec & ts)
+    {
+        return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    }
+
+    uint64_t newTraceId ()
+    {
+        return __atomic_add_fetch (&nextTraceId_, 1, __ATOMIC_RELAXED);
+    }
+
+    /*!
+     * The trace the calling thread is working for; 0 for none. REST
+     * requests submitted meanwhile are recorded under it.
+     */
+    static uint64_t currentTrace ()
+    {
+        return currentTrace_;
+    }
+    static void setCurrentTrace (uint64_t traceId)
+    {
+        currentTrace_ = traceId;
+    }
+
+    /*!
+     * Record one span on the calling thread.
+     * \param name - span name; a string literal.
+     * \param category - "event" or "rest".
+     * \param traceId - trace the span belongs to.
+     * \param startUs, endUs - from now().
+     * \param detail - optional, shown with the span's arguments.
+     * \param startsFlow - the first span of the trace.
+     */
+    void span (const char *name, const char *category, uint64_t traceId, uint64_t startUs, uint64_t endUs,
+               const std::string & detail = std::string (), bool startsFlow = false);
+
+  private:
+    /*!
+     * ctor. Hide here as class is a singleton
+     */
+    EventTrace ();
+
+    static int threadId ();
+    static void appendEscaped (std::string & out, const std::string & value);
+
+    static EventTrace *pInstance_;
+    static bool enabled_;
+    static __thread uint64_t currentTrace_;
+    static __thread int threadId_;
+
+    uint64_t nextTraceId_;
+    pthread_mutex_t lock_;
+    FILE *file_;
+    bool firstRecord_;
+};
+
+#endif // _EVENTTRACE_H
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,277 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <unistd.h>
+
+#include "logger.h"
+#include "cstrhash.h"
+#include "eventworkers.h"
+#include "xmsnodepool.h"
+#include "eventtrace.h"
+#include "eventcapture.h"
+
+/*----------------------------------------------------------------------------*/
+
+EventWorkers *
+    EventWorkers::pInstance_ = NULL;
+
+/*
+ * ctor
+ */
+EventWorkers::EventWorkers ()
+{
+    stopping_ = false;
+    pthread_mutex_init (&routeLock_, NULL);
+    pthread_mutex_init (&confRouteLock_, NULL);
+}
+
+/*
+ * dtor
+ */
+EventWorkers::~EventWorkers ()
+{
+    stop ();
+    std::vector < Worker * >::iterator worker_iterator;
+    for (worker_iterator = workers_.begin (); worker_iterator != workers_.end (); worker_iterator++)
+        delete *worker_iterator;
+    pthread_mutex_destroy (&confRouteLock_);
+    pthread_mutex_destroy (&routeLock_);
+}
+
+bool
+EventWorkers::start (int numWorkers, const std::string & dtmf_mode)
+{
+    if (numWorkers < 1)
+        numWorkers = 1;
+
+    for (int index = 0; index < numWorkers; index++)
+    {
+        Worker *worker = new Worker;
+        worker->owner = this;
+        worker->index = index;
+        worker->conferences = new ConferenceManager (dtmf_mode, confRouteChanged, worker);
+        if (!worker->ring.init ())
+        {
+            LOGCRIT ("Cannot create event ring wakeup eventfd for worker " << index);
+            delete worker->conferences;
+            delete worker;
+            return false;
+        }
+        if (pthread_create (&worker->thread, NULL, workerThread, (void *) worker))
+        {
+            LOGCRIT ("Cannot create event worker thread " << index);
+            delete worker->conferences;
+            delete worker;
+            return false;
+        }
+        workers_.push_back (worker);
+    }
+    LOGDEBUG (numWorkers << " event worker threads created");
+    return true;
+}
+
+void
+EventWorkers::stop ()
+{
+    if (workers_.empty () || __atomic_load_n (&stopping_, __ATOMIC_ACQUIRE))
+        return;
+
+    __atomic_store_n (&stopping_, true, __ATOMIC_RELEASE);
+    std::vector < Worker * >::iterator worker_iterator;
+    for (worker_iterator = workers_.begin (); worker_iterator != workers_.end (); worker_iterator++)
+        (*worker_iterator)->ring.wakeup ();
+    for (worker_iterator = workers_.begin (); worker_iterator != workers_.end (); worker_iterator++)
+    {
+        pthread_join ((*worker_iterator)->thread, NULL);
+        // Closes the worker's conferences. The worker itself, and its ring,
+        // stay: the event handler thread may still be winding down
+        delete (*worker_iterator)->conferences;
+        (*worker_iterator)->conferences = NULL;
+    }
+    LOGDEBUG ("Event workers stopped");
+}
+
+void *
+EventWorkers::workerThread (void *voidPtr)
+{
+    Worker *worker = (Worker *) voidPtr;
+    worker->owner->run (worker);
+    return NULL;
+}
+
+void
+EventWorkers::confRouteChanged (const std::string & confId, bool added, void *userp)
+{
+    Worker *worker = (Worker *) userp;
+    EventWorkers *self = worker->owner;
+
+    pthread_mutex_lock (&self->confRouteLock_);
+    if (added)
+        self->confRoutes_[confId] = worker->index;
+    else
+        self->confRoutes_.erase (confId);
+    pthread_mutex_unlock (&self->confRouteLock_);
+}
+
+void
+EventWorkers::run (Worker * worker)
+{
+    LOGDEBUG ("Event worker " << worker->index << " running");
+    while (true)
+    {
+        // Wakeups are counted, so nothing posted while we were busy is lost
+        worker->ring.wait ();
+
+        EventBuffer *ready;
+        while ((ready = worker->ring.front ()) != NULL)
+        {
+            LOGDEBUG ("Worker " << worker->index << " event is " << ready->data);
+            uint64_t traceId = ready->traceId;
+            uint64_t parseStart = 0;
+            if (traceId)
+            {
+                parseStart = EventTrace::now ();
+                EventTrace::Instance ()->span ("queue", "event", traceId, ready->queuedUs, parseStart);
+            }
+            // Tokenized in place; the slot goes back once the event is handled
+            xmsEventParser curEvent (ready->data, ready->length);
+            uint64_t handleStart = 0;
+            if (traceId)
+            {
+                handleStart = EventTrace::now ();
+                EventTrace::Instance ()->span ("parse", "event", traceId, parseStart, handleStart);
+            }
+            // Anything this event creates goes on the node it came from, and
+            // any REST request it sends is traced with it
+            XmsNodePool::setCurrentNode (ready->source);
+            EventTrace::setCurrentTrace (traceId);
+            EventCapture::setCurrentEvent (&curEvent);
+            worker->conferences->onEvent (&curEvent);
+            EventCapture::setCurrentEvent (NULL);
+            EventTrace::setCurrentTrace (0);
+            if (traceId)
+                EventTrace::Instance ()->span ("handle", "event", traceId, handleStart, EventTrace::now (),
+                                               curEvent.getEventType ());
+            worker->ring.pop ();
+        }
+
+        if (__atomic_load_n (&stopping_, __ATOMIC_ACQUIRE))
+            break;
+    }
+    LOGDEBUG ("Event worker " << worker->index << " exiting");
+}
+
+int
+EventWorkers::workerFor (xmsEventParser & event)
+{
+    const std::string & eventType = event.getEventType ();
+    RouteTable::iterator route_iterator;
+
+    if (eventType == "incoming")
+    {
+        std::string room = ConferenceManager::roomNameFor (&event);
+        int index = CStrHash ()(room.c_str ()) % workers_.size ();
+        std::string call_id = event.findValByKey ("call_id");
+        callRoutes_[call_id] = index;
+        XmsNodePool::Instance ()->bind (call_id, XmsNodePool::currentNode (), XMS_CALL);
+        return index;
+    }
+
+    if (event.getResourceType () == "conference")
+    {
+        int index = 0;
+        pthread_mutex_lock (&confRouteLock_);
+        route_iterator = confRoutes_.find (event.getResourceId ());
+        if (route_iterator != confRoutes_.end ())
+            index = route_iterator->second;
+        pthread_mutex_unlock (&confRouteLock_);
+        return index;
+    }
+
+    std::string call_id = event.findValByKey ("call_id");
+    if (call_id.empty () && event.getResourceType () == "call")
+        call_id = event.getResourceId ();
+    route_iterator = callRoutes_.find (call_id);
+    if (route_iterator == callRoutes_.end ())
+        return 0;               // the worker logs it as unroutable
+    int index = route_iterator->second;
+    if (eventType == "hangup")
+    {
+        callRoutes_.erase (route_iterator);
+        XmsNodePool::Instance ()->unbind (call_id);
+    }
+    return index;
+}
+
+void
+EventWorkers::route (const char *event, size_t length, int node, uint64_t receivedUs)
+{
+    if (__atomic_load_n (&stopping_, __ATOMIC_ACQUIRE) || workers_.empty ())
+        return;
+
+    xmsEventParser parsed (event, length);
+    if (parsed.getEventType () == "keepalive")
+    {
+        // These can come anytime, and have no call ID
+        LOGDEBUG ("Keepalive received");
+        return;
+    }
+
+    uint64_t traceId = 0;
+    if (EventTrace::enabled ())
+    {
+        traceId = EventTrace::Instance ()->newTraceId ();
+        if (!receivedUs)
+            receivedUs = EventTrace::now ();
+    }
+
+    pthread_mutex_lock (&routeLock_);
+    Worker *worker = workers_[workerFor (parsed)];
+    // If the worker has fallen a full ring behind, hold off reading the
+    // socket until it catches up
+    bool warned = false;
+    while (!worker->ring.push (event, length, node, traceId, traceId ? EventTrace::now () : 0))
+    {
+        pthread_mutex_unlock (&routeLock_);
+        if (__atomic_load_n (&stopping_, __ATOMIC_ACQUIRE))
+            return;
+        if (!warned)
+        {
+            LOGWARN ("Event ring for worker " << worker->index << " full. Waiting on it");
+            warned = true;
+        }
+        usleep (1000);
+        pthread_mutex_lock (&routeLock_);
+    }
+    pthread_mutex_unlock (&routeLock_);
+
+    if (traceId)
+        EventTrace::Instance ()->span ("receive", "event", traceId, receivedUs, EventTrace::now (),
+                                       parsed.getEventType (), true);
+}
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+#ifndef _EVENTWORKERS_H
+#define _EVENTWORKERS_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <tr1/unordered_map>
+#include "eventring.h"
+#include "conferencemanager.h"
+
+/*----------------------------------------------------------------------------*/
+
+/*!
+ * \class EventWorkers
+ * A fixed pool of threads that handle XMS events, each running its own
+ * ConferenceManager.  Every conference is pinned to one worker, so events
+ * for a conference are handled in order while different conferences run in
+ * parallel, and a conference waiting on a REST reply holds up only the
+ * rooms on its own worker.
+ *
+ * Each XMS node's event handler thread calls route () for each event. It
+ * picks the worker and copies the event into that worker's EventRing:
+ *  - incoming: by hash of the room name, so a room always lands on the same
+ *    worker; the call ID is then remembered for the call's later events
+ *  - conference events: by XMS conference ID, registered by the worker
+ *    when it creates the conference
+ *  - call events: by the call ID remembered on incoming
+ * The class is a singleton.
+ */
+class EventWorkers
+{
+  public:
+    /*!
+     * dtor.
+     */
+    ~EventWorkers ();
+
+    static EventWorkers *Instance ()
+    {
+        if (!pInstance_)
+            pInstance_ = new EventWorkers;
+
+        return pInstance_;
+    }
+
+    /*!
+     * Start numWorkers worker threads.
+     */
+    bool start (int numWorkers, const std::string & dtmf_mode);
+
+    /*!
+     * Let the workers finish what is queued, then stop them and close
+     * their conferences.
+     */
+    void stop ();
+
+    /*!
+     * Event handler threads. Queue one event from XMS node on its worker.
+     * receivedUs is when its bytes came off the socket, for EventTrace.
+     */
+    void route (const char *event, size_t length, int node, uint64_t receivedUs = 0);
+
+  private:
+    /*!
+     * ctor. Hide here as class is a singleton
+     */
+    EventWorkers ();
+
+    struct Worker
+    {
+        EventWorkers *owner;
+        int index;
+        pthread_t thread;
+        EventRing ring;
+        ConferenceManager *conferences;
+    };
+
+    typedef std::tr1::unordered_map < std::string, int >RouteTable;
+
+    static void *workerThread (void *voidPtr);
+    static void confRouteChanged (const std::string & confId, bool added, void *userp);
+    void run (Worker * worker);
+    int workerFor (xmsEventParser & event);
+
+    static EventWorkers *pInstance_;
+
+    std::vector < Worker * >workers_;
+    bool stopping_;
+
+    // Event handler threads, under routeLock_. Also makes the handler
+    // threads take turns as producer on each ring
+    pthread_mutex_t routeLock_;
+    RouteTable callRoutes_;
+
+    // Written by workers, read by the event handler thread
+    pthread_mutex_t confRouteLock_;
+    RouteTable confRoutes_;
+};
+
+#endif // _EVENTWORKERS_H
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <string.h>
+
+#include "latencystats.h"
+
+/*----------------------------------------------------------------------------*/
+
+LatencyStats *
+    LatencyStats::pInstance_ = NULL;
+
+LatencyHistogram::LatencyHistogram ()
+{
+    count_ = 0;
+    sum_ = 0;
+    max_ = 0;
+    memset (buckets_, 0, sizeof (buckets_));
+}
+
+int
+LatencyHistogram::bucketFor (uint64_t value)
+{
+    if (value < (uint64_t) SUB_BUCKETS)
+        return (int) value;
+
+    // Top SUB_BUCKET_BITS + 1 bits pick the bucket within its power of two
+    int magnitude = 63 - __builtin_clzll (value);
+    if (magnitude > MAX_MAGNITUDE)
+        return NUM_BUCKETS - 1;
+    int shift = magnitude - SUB_BUCKET_BITS;
+    return (magnitude - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + (int) ((value >> shift) - SUB_BUCKETS);
+}
+
+uint64_t
+LatencyHistogram::highestInBucket (int bucket)
+{
+    if (bucket < SUB_BUCKETS)
+        return (uint64_t) bucket;
+
+    int shift = bucket / SUB_BUCKETS - 1;
+    uint64_t low = (uint64_t) (bucket % SUB_BUCKETS + SUB_BUCKETS) << shift;
+    return low + ((uint64_t) 1 << shift) - 1;
+}
+
+void
+LatencyHistogram::record (uint64_t valueUs)
+{
+    buckets_[bucketFor (valueUs)]++;
+    count_++;
+    sum_ += valueUs;
+    if (valueUs > max_)
+        max_ = valueUs;
+}
+
+uint64_t
+LatencyHistogram::percentile (double q) const
+{
+    if (count_ == 0)
+        return 0;
+
+    uint64_t target = (uint64_t) (q * count_);
+    if (target < q * count_)
+        target++;
+    if (target == 0)
+        target = 1;
+
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < NUM_BUCKETS; bucket++)
+    {
+        seen += buckets_[bucket];
+        if (seen >= target)
+        {
+            // Never report more than was actually seen
+            uint64_t value = highestInBucket (bucket);
+            return value < max_ ? value : max_;
+        }
+    }
+    return max_;
+}
+
+/*
+ * ctor
+ */
+LatencyStats::LatencyStats ()
+{
+    pthread_mutex_init (&lock_, NULL);
+}
+
+/*
+ * dtor
+ */
+LatencyStats::~LatencyStats ()
+{
+    pthread_mutex_destroy (&lock_);
+}
+
+void
+LatencyStats::record (const char *operation, long respCode, uint64_t latencyUs, bool failed)
+{
+    pthread_mutex_lock (&lock_);
+    OperationStats & stats = operations_[operation];
+    stats.all.record (latencyUs);
+    stats.byStatus[respCode].record (latencyUs);
+    if (failed)
+        stats.errors++;
+    pthread_mutex_unlock (&lock_);
+}
+
+void
+LatencyStats::dumpHistogram (std::ostream & out, const LatencyHistogram & histogram)
+{
+    out << " count=" << histogram.count ()
+        << " mean=" << histogram.mean ()
+        << " p50=" << histogram.percentile (0.5)
+        << " p99=" << histogram.percentile (0.99)
+        << " p999=" << histogram.percentile (0.999)
+        << " max=" << histogram.max ();
+}
+
+void
+LatencyStats::dump (std::ostream & out)
+{
+    pthread_mutex_lock (&lock_);
+    out << "REST latency in microseconds";
+    if (operations_.empty ())
+        out << ": no requests yet";
+
+    std::map < std::string, OperationStats >::const_iterator op_iterator;
+    for (op_iterator = operations_.begin (); op_iterator != operations_.end (); op_iterator++)
+    {
+        const OperationStats & stats = op_iterator->second;
+        out << "\n" << op_iterator->first << ":";
+        dumpHistogram (out, stats.all);
+        out << " errors=" << stats.errors;
+
+        std::map < long, LatencyHistogram >::const_iterator status_iterator;
+        for (status_iterator = stats.byStatus.begin (); status_iterator != stats.byStatus.end (); status_iterator++)
+        {
+            out << "\n    " << op_iterator->first << " status " << status_iterator->first << ":";
+            dumpHistogram (out, status_iterator->second);
+        }
+    }
+    pthread_mutex_unlock (&lock_);
+}
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+#ifndef _LATENCYSTATS_H
+#define _LATENCYSTATS_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <stdint.h>
+#include <string>
+#include <map>
+#include <ostream>
+#include <pthread.h>
+
+/*----------------------------------------------------------------------------*/
+
+/*!
+ * \class LatencyHistogram
+ * HDR style histogram of microsecond latencies.  Values below
+ * SUB_BUCKETS are counted exactly; above that each power of two is split
+ * into SUB_BUCKETS linear buckets, so any recorded value is known to within
+ * 1/SUB_BUCKETS (about 6%).  Recording is a couple of shifts and an
+ * increment, and the size is fixed whatever the range of values.
+ */
+class LatencyHistogram
+{
+  public:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    // 2^36 us is nearly a day; anything longer lands in the last bucket
+    static const int MAX_MAGNITUDE = 35;
+    static const int NUM_BUCKETS = (MAX_MAGNITUDE - SUB_BUCKET_BITS + 2) * SUB_BUCKETS;
+
+    LatencyHistogram ();
+
+    void record (uint64_t valueUs);
+
+    uint64_t count () const
+    {
+        return count_;
+    }
+    uint64_t max () const
+    {
+        return max_;
+    }
+    uint64_t mean () const
+    {
+        return count_ ? sum_ / count_ : 0;
+    }
+
+    /*!
+     * Smallest value v such that at least fraction q of the samples are no
+     * larger than v (within bucket precision).  0 if empty.
+     */
+    uint64_t percentile (double q) const;
+
+  private:
+    static int bucketFor (uint64_t value);
+    static uint64_t highestInBucket (int bucket);
+
+    uint64_t count_;
+    uint64_t sum_;
+    uint64_t max_;
+    uint64_t buckets_[NUM_BUCKETS];
+};
+
+/*!
+ * \class LatencyStats
+ * REST round trip times to XMS, per operation (answer, add_party, ...) and
+ * per HTTP status within it.  Status 0 counts requests that got no HTTP
+ * reply at all.  Recorded by the REST dispatcher as each request
+ * completes; dumped to the log on SIGUSR1 and at shutdown.  The class is a
+ * singleton.
+ */
+class LatencyStats
+{
+  public:
+    ~LatencyStats ();
+
+    static LatencyStats *Instance ()
+    {
+        if (!pInstance_)
+            pInstance_ = new LatencyStats;
+
+        return pInstance_;
+    }
+
+    /*!
+     * Count one completed request.
+     * \param operation - what was asked of XMS.
+     * \param respCode - HTTP status, 0 if there was none.
+     * \param latencyUs - submit to completion, microseconds, including any
+     * wait behind earlier requests on the same resource.
+     * \param failed - not the reply the operation expects.
+     */
+    void record (const char *operation, long respCode, uint64_t latencyUs, bool failed);
+
+    /*!
+     * Write one line per operation, then one per status within it.
+     */
+    void dump (std::ostream & out);
+
+  private:
+    /*!
+     * ctor. Hide here as class is a singleton
+     */
+    LatencyStats ();
+
+    struct OperationStats
+    {
+        OperationStats ()
+        {
+            errors = 0;
+        }
+
+        LatencyHistogram all;
+        uint64_t errors;
+        std::map < long, LatencyHistogram > byStatus;
+    };
+
+    static void dumpHistogram (std::ostream & out, const LatencyHistogram & histogram);
+
+    static LatencyStats *pInstance_;
+
+    pthread_mutex_t lock_;
+    std::map < std::string, OperationStats > operations_;
+};
+
+#endif // _LATENCYSTATS_H
+/* vim:ts=4:set nu:
+ * EOF
+ */
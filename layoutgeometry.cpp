@@ -0,0 +1,326 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sstream>
+
+#include "logger.h"
+#include "inifile.h"
+#include "layoutgeometry.h"
+#include "regionallocator.h"
+
+/*----------------------------------------------------------------------------*/
+
+// Region edges are given to one decimal, so thirds leave a 0.1% sliver at
+// the right and bottom of the picture; count it as part of the region
+static const float EDGE_SLACK = 0.1f;
+
+static bool
+regionContains (const LayoutRegion & region, float x, float y)
+{
+    return x >= region.left && x <= region.left + region.size + EDGE_SLACK &&
+        y >= region.top && y <= region.top + region.size + EDGE_SLACK;
+}
+
+/*
+ * ctor
+ */
+LayoutGeometry::LayoutGeometry ()
+{
+    standard_ = false;
+    memset (grid_, 0, sizeof (grid_));
+}
+
+bool
+LayoutGeometry::parse (const std::string & name, const std::string & layoutRegions, bool standard)
+{
+    std::vector < LayoutRegion > regions;
+    std::stringstream entries (layoutRegions);
+    std::string entry;
+    while (std::getline (entries, entry, ';'))
+    {
+        if (entry.empty ())
+            continue;
+        LayoutRegion region;
+        if (sscanf (entry.c_str (), " %d = %f , %f , %f", &region.region, &region.left, &region.top, &region.size) != 4 ||
+            region.region < 1 || region.size <= 0)
+        {
+            LOGERROR ("Layout " << name << ": bad region definition '" << entry << "'");
+            return false;
+        }
+        // The conference tracks regions in a RegionAllocator
+        if (region.region > RegionAllocator::MAX_REGIONS)
+        {
+            LOGERROR ("Layout " << name << ": region number above " << RegionAllocator::MAX_REGIONS << " in '" << entry << "'");
+            return false;
+        }
+        regions.push_back (region);
+    }
+    if (regions.empty ())
+    {
+        LOGERROR ("Layout " << name << " has no regions");
+        return false;
+    }
+    if (regions.size () > (size_t) RegionAllocator::MAX_REGIONS)
+    {
+        LOGERROR ("Layout " << name << " has " << regions.size () << " regions, more than " << RegionAllocator::MAX_REGIONS);
+        return false;
+    }
+    // Parties are placed by region number, so the numbers must be 1..N with
+    // none skipped or repeated
+    std::vector < bool >used (regions.size () + 1, false);
+    std::vector < LayoutRegion >::const_iterator region_iterator;
+    for (region_iterator = regions.begin (); region_iterator != regions.end (); region_iterator++)
+    {
+        if (region_iterator->region > (int) regions.size () || used[region_iterator->region])
+        {
+            LOGERROR ("Layout " << name << ": region numbers must be 1 to " << regions.size () << ", each used once, got " << region_iterator->region);
+            return false;
+        }
+        used[region_iterator->region] = true;
+    }
+
+    name_ = name;
+    layoutRegions_ = layoutRegions;
+    standard_ = standard;
+    regions_.swap (regions);
+    buildGrid ();
+    return true;
+}
+
+int
+LayoutGeometry::scan (float xPercent, float yPercent) const
+{
+    // First region in order wins where regions touch or overlap
+    std::vector < LayoutRegion >::const_iterator region_iterator;
+    for (region_iterator = regions_.begin (); region_iterator != regions_.end (); region_iterator++)
+    {
+        if (regionContains (*region_iterator, xPercent, yPercent))
+            return region_iterator->region;
+    }
+    return 0;
+}
+
+void
+LayoutGeometry::buildGrid ()
+{
+    const float cell = 100.0f / GRID_SIZE;
+    for (int col = 0; col < GRID_SIZE; col++)
+    {
+        float x0 = col * cell;
+        float x1 = x0 + cell;
+        for (int row = 0; row < GRID_SIZE; row++)
+        {
+            float y0 = row * cell;
+            float y1 = y0 + cell;
+
+            // The cell is settled by the first region reaching into it; it
+            // is that region's only if the region covers all of it
+            unsigned char value = 0;
+            std::vector < LayoutRegion >::const_iterator region_iterator;
+            for (region_iterator = regions_.begin (); region_iterator != regions_.end (); region_iterator++)
+            {
+                float left = region_iterator->left;
+                float top = region_iterator->top;
+                float right = left + region_iterator->size + EDGE_SLACK;
+                float bottom = top + region_iterator->size + EDGE_SLACK;
+                if (left >= x1 || right < x0 || top >= y1 || bottom < y0)
+                    continue;
+                if (left <= x0 && right >= x1 && top <= y0 && bottom >= y1 && region_iterator->region < MIXED_CELL)
+                    value = region_iterator->region;
+                else
+                    value = MIXED_CELL;
+                break;
+            }
+            grid_[col][row] = value;
+        }
+    }
+}
+
+int
+LayoutGeometry::hitTest (float xPercent, float yPercent) const
+{
+    if (xPercent < 0 || xPercent > 100 || yPercent < 0 || yPercent > 100)
+        return 0;
+
+    int col = (int) (xPercent * GRID_SIZE / 100);
+    int row = (int) (yPercent * GRID_SIZE / 100);
+    if (col == GRID_SIZE)
+        col--;
+    if (row == GRID_SIZE)
+        row--;
+    unsigned char value = grid_[col][row];
+    if (value != MIXED_CELL)
+        return value;
+    return scan (xPercent, yPercent);
+}
+
+LayoutTable *
+    LayoutTable::pInstance_ = NULL;
+
+/*
+ * ctor
+ */
+LayoutTable::LayoutTable ()
+{
+    // XMS standard layouts. Regions are numbered down each column, left to
+    // right, as XMS does
+    add ("1", "1=0,0,100", true, false);
+    add ("2", "1=0,25,50;2=50,25,50", true, false);
+    add ("4", "1=0,0,50;2=0,50,50;3=50,0,50;4=50,50,50", true, true);
+    add ("6", "1=0,0,66.6;2=66.6,0,33.3;3=66.6,33.3,33.3;4=66.6,66.6,33.3;5=33.3,66.6,33.3;6=0,66.6,33.3", true, true);
+    add ("9", "1=0,0,33.3;2=0,33.3,33.3;3=0,66.6,33.3;4=33.3,0,33.3;5=33.3,33.3,33.3;6=33.3,66.6,33.3;"
+         "7=66.6,0,33.3;8=66.6,33.3,33.3;9=66.6,66.6,33.3", true, true);
+    for (int side = 4; side <= 5; side++)
+    {
+        std::ostringstream name;
+        std::ostringstream layoutRegions;
+        name << side * side;
+        for (int i = 0; i < side * side; i++)
+        {
+            layoutRegions << (i ? ";" : "") << i + 1 << "=" << (i / side) * 100 / side << "," << (i % side) * 100 /
+                side << "," << 100 / side;
+        }
+        add (name.str (), layoutRegions.str (), true, true);
+    }
+}
+
+/*
+ * dtor
+ */
+LayoutTable::~LayoutTable ()
+{
+    std::vector < LayoutGeometry * >::iterator layout_iterator;
+    for (layout_iterator = layouts_.begin (); layout_iterator != layouts_.end (); layout_iterator++)
+        delete *layout_iterator;
+}
+
+bool
+LayoutTable::add (const std::string & name, const std::string & layoutRegions, bool standard, bool inCycle)
+{
+    LayoutGeometry *layout = new LayoutGeometry;
+    if (!layout->parse (name, layoutRegions, standard))
+    {
+        delete layout;
+        return false;
+    }
+    layouts_.push_back (layout);
+    if (inCycle)
+        cycle_.push_back (layout);
+    return true;
+}
+
+bool
+LayoutTable::load (const std::string & filename)
+{
+    IniFile ini;
+    if (!ini.load (filename))
+    {
+        LOGERROR ("Cannot load layouts from " << filename);
+        return false;
+    }
+
+    IniFile::section_data_t layouts;
+    ini.getSection ("layouts", layouts);
+    IniFile::section_data_t::const_iterator entry_iterator;
+    for (entry_iterator = layouts.begin (); entry_iterator != layouts.end (); entry_iterator++)
+    {
+        if (find (entry_iterator->first))
+        {
+            LOGWARN ("Layout " << entry_iterator->first << " is already defined. Ignoring " << filename << " entry");
+            continue;
+        }
+        if (add (entry_iterator->first, entry_iterator->second, false, true))
+            LOGDEBUG ("Loaded layout " << entry_iterator->first << " = " << entry_iterator->second);
+    }
+    return true;
+}
+
+const LayoutGeometry *
+LayoutTable::find (const std::string & name) const
+{
+    std::vector < LayoutGeometry * >::const_iterator layout_iterator;
+    for (layout_iterator = layouts_.begin (); layout_iterator != layouts_.end (); layout_iterator++)
+    {
+        if ((*layout_iterator)->getName () == name)
+            return *layout_iterator;
+    }
+    return NULL;
+}
+
+const LayoutGeometry *
+LayoutTable::next (const LayoutGeometry * current) const
+{
+    for (size_t i = 0; i < cycle_.size (); i++)
+    {
+        if (cycle_[i] == current)
+            return cycle_[(i + 1) % cycle_.size ()];
+    }
+    return cycle_.front ();
+}
+
+bool
+LayoutTable::resolutionSize (const char *resolution, int &width, int &height)
+{
+    static const struct
+    {
+        const char *name;
+        int width;
+        int height;
+    } resolutions[] =
+    {
+        {"cif", 352, 240}, {"vga", 640, 480}, {"720p", 1280, 720}, {"1080p", 1920, 1080}
+    };
+
+    for (size_t i = 0; i < sizeof (resolutions) / sizeof (resolutions[0]); i++)
+    {
+        if (strcmp (resolution, resolutions[i].name) == 0)
+        {
+            width = resolutions[i].width;
+            height = resolutions[i].height;
+            return true;
+        }
+    }
+    return sscanf (resolution, "%dx%d", &width, &height) == 2 && width > 0 && height > 0;
+}
+
+int
+LayoutTable::findClickedRegion (const LayoutGeometry * layout, const char *resolution, int posX, int posY)
+{
+    int width;
+    int height;
+    if (!resolutionSize (resolution, width, height))
+    {
+        LOGERROR ("Unsupported resolution - " << resolution);
+        return 0;
+    }
+    return layout->hitTest (posX * 100.0f / width, posY * 100.0f / height);
+}
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+#ifndef _LAYOUTGEOMETRY_H
+#define _LAYOUTGEOMETRY_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <string>
+#include <vector>
+
+/*----------------------------------------------------------------------------*/
+
+/*!
+ * \struct LayoutRegion
+ * One region of a layout, in percent of the conference picture.  Regions
+ * are square in picture terms: size is both their width and their height.
+ */
+struct LayoutRegion
+{
+    int region;
+    float left;
+    float top;
+    float size;
+};
+
+/*!
+ * \class LayoutGeometry
+ * Where each region of one conference layout sits, parsed from an XMS
+ * layout_regions string ("1=0,0,50;2=0,50,50;...": region=left,top,size).
+ *
+ * A coarse hit-test grid is built once from the geometry: each cell holds
+ * the region covering all of it, so a click resolves with one lookup.
+ * Only cells a region edge runs through fall back to testing the regions,
+ * in order, as the hand written tests did.
+ */
+class LayoutGeometry
+{
+  public:
+    static const int GRID_SIZE = 32;
+
+    LayoutGeometry ();
+
+    /*!
+     * Parse a layout_regions string.
+     * \param name - name the layout is known by.
+     * \param layoutRegions - region=left,top,size;...
+     * \param standard - true for an XMS built in layout, set by its size;
+     * false for a custom one, which is set by sending layoutRegions.
+     * Returns false, and logs why, for a malformed entry, a region number
+     * above RegionAllocator::MAX_REGIONS, or more regions than that.
+     */
+    bool parse (const std::string & name, const std::string & layoutRegions, bool standard);
+
+    /*!
+     * Region at a point given in percent of the picture, or 0 for none.
+     */
+    int hitTest (float xPercent, float yPercent) const;
+
+    const std::string & getName () const
+    {
+        return name_;
+    }
+
+    const std::string & getLayoutRegions () const
+    {
+        return layoutRegions_;
+    }
+
+    bool isStandard () const
+    {
+        return standard_;
+    }
+
+    int getNumRegions () const
+    {
+        return (int) regions_.size ();
+    }
+
+  private:
+    static const unsigned char MIXED_CELL = 0xff;
+
+    int scan (float xPercent, float yPercent) const;
+    void buildGrid ();
+
+    std::string name_;
+    std::string layoutRegions_;
+    bool standard_;
+    std::vector < LayoutRegion > regions_;
+    unsigned char grid_[GRID_SIZE][GRID_SIZE];
+};
+
+/*!
+ * \class LayoutTable
+ * Every layout the conference can switch between, in the order the '#' key
+ * rotates through them. The XMS standard layouts are built in; more can be
+ * added from the [layouts] section of an ini file:
+ *
+ *   [layouts]
+ *   pip = 1=0,0,100;2=70,70,25
+ *
+ * Filled in at startup, read only after that.  The class is a singleton.
+ */
+class LayoutTable
+{
+  public:
+    static LayoutTable *Instance ()
+    {
+        if (!pInstance_)
+            pInstance_ = new LayoutTable;
+
+        return pInstance_;
+    }
+
+    /*!
+     * Add the custom layouts from an ini file.
+     */
+    bool load (const std::string & filename);
+
+    /*!
+     * Layout by name, or NULL.
+     */
+    const LayoutGeometry *find (const std::string & name) const;
+
+    /*!
+     * Layout the '#' key moves to from current.
+     */
+    const LayoutGeometry *next (const LayoutGeometry * current) const;
+
+    /*!
+     * Picture size for an XMS resolution name (cif, vga, 720p...) or WxH.
+     */
+    static bool resolutionSize (const char *resolution, int &width, int &height);
+
+    /*!
+     * Region clicked at pixel posX, posY of a picture at resolution, or 0.
+     */
+    static int findClickedRegion (const LayoutGeometry * layout, const char *resolution, int posX, int posY);
+
+  private:
+    /*!
+     * ctor. Hide here as class is a singleton
+     */
+    LayoutTable ();
+    ~LayoutTable ();
+
+    bool add (const std::string & name, const std::string & layoutRegions, bool standard, bool inCycle);
+
+    static LayoutTable *pInstance_;
+
+    std::vector < LayoutGeometry * >layouts_;
+    // Those the '#' key rotates through
+    std::vector < const LayoutGeometry * >cycle_;
+};
+
+#endif // _LAYOUTGEOMETRY_H
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
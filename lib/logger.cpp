@@ -33,7 +33,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <syslog.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdint.h>
 #include <sys/time.h>
+#include <sys/uio.h>
+#include <sys/eventfd.h>
 #include <sstream>
 #include <iostream>
 #include <iomanip>
@@ -42,21 +48,79 @@
 
 /*--------------------------------------------------------------------------*/
 
+/*
+ * Length of the record header: "YYYY-MM-DD HH:MM:SS.uuuuuu LEVEL  "
+ */
+static const size_t HEADER_LENGTH = 26 + 1 + 6 + 1;
+
+static const char* loglevels[] = { "EMERG ", "ALERT ", "CRIT  ", "ERROR ", "WARN  ", "NOTICE", "INFO  ", "DEBUG " };
+
+/*
+ * Per-thread copy of the formatted date and time for the current second,
+ * so localtime_r() and strftime() run once a second rather than per record.
+ */
+static __thread time_t cached_second = -1;
+static __thread char cached_prefix[19 + 1];   /* YYYY-MM-DD HH:MM:SS<NUL> */
+
+/*
+ * Write the record header for 'level' into 'out', which must hold
+ * HEADER_LENGTH bytes. Not NUL terminated.
+ */
+static void format_header( char* out, Logger::LogLevel level )
+{
+	struct timeval tvbuf;
+	gettimeofday(&tvbuf, 0);
+
+	if ( tvbuf.tv_sec != cached_second )
+	{
+		struct tm tmbuf;
+		localtime_r(&tvbuf.tv_sec, &tmbuf);
+		strftime(cached_prefix, sizeof(cached_prefix), "%Y-%m-%d %H:%M:%S", &tmbuf);
+		cached_second = tvbuf.tv_sec;
+	}
+
+	memcpy(out, cached_prefix, 19);
+	out[19] = '.';
+	long usec = tvbuf.tv_usec;
+	for ( int i = 25; i > 19; --i )
+	{
+		out[i] = '0' + usec % 10;
+		usec /= 10;
+	}
+	out[26] = ' ';
+	memcpy(&out[27], loglevels[level], 6);
+	out[33] = ' ';
+}
+
+
 /*
  * Set the default logging level.
  */
 Logger::Logger()
-	: level_ (LOGLEVEL_NOTICE)
+	: level_ (LOGLEVEL_NOTICE),
+	  async_ (false),
+	  policy_ (OVERFLOW_BLOCK),
+	  slots_ (NULL),
+	  capacity_ (0),
+	  eventFd_ (-1),
+	  sleeping_ (0),
+	  stopping_ (0),
+	  dropped_ (0),
+	  reported_ (0),
+	  head_ (0),
+	  tail_ (0)
 {
 	pthread_mutex_init(&write_mutex_, NULL);
 }
 
 
 /*
- * Delete all appenders.
+ * Flush the queue and delete all appenders.
  */
 Logger::~Logger()
 {
+	stopAsync();
+
 	std::vector<Appender*>::iterator i;
 	for ( i = appenders_.begin(); i != appenders_.end(); ++i )
 	{
@@ -94,7 +158,99 @@ void Logger::setLevel( LogLevel level )
 
 
 /*
- * Build a logging record and write it to the backend appenders.
+ * Allocate the queue and start the writer thread. On failure the logger
+ * stays synchronous.
+ */
+void Logger::startAsync( size_t capacity, OverflowPolicy policy )
+{
+	if ( async_ )
+	{
+		return;
+	}
+
+	capacity_ = BATCH;
+	while ( capacity_ < capacity )
+	{
+		capacity_ <<= 1;
+	}
+
+	slots_ = new Slot[capacity_];
+	for ( size_t i = 0; i < capacity_; ++i )
+	{
+		slots_[i].sequence = i;
+		slots_[i].level = LOGLEVEL_DEBUG;
+		slots_[i].data = NULL;
+		slots_[i].length = 0;
+		slots_[i].capacity = 0;
+	}
+
+	policy_ = policy;
+	head_ = 0;
+	tail_ = 0;
+	sleeping_ = 0;
+	stopping_ = 0;
+
+	eventFd_ = eventfd(0, 0);
+	if ( (eventFd_ < 0) || pthread_create(&writer_, NULL, writerThread, this) )
+	{
+		if ( eventFd_ >= 0 )
+		{
+			close(eventFd_);
+			eventFd_ = -1;
+		}
+		delete [] slots_;
+		slots_ = NULL;
+		return;
+	}
+
+	async_ = true;
+}
+
+
+/*
+ * Let the writer thread drain the queue, then free it.
+ */
+void Logger::stopAsync()
+{
+	if ( !async_ )
+	{
+		return;
+	}
+
+	__atomic_store_n(&stopping_, 1, __ATOMIC_SEQ_CST);
+	uint64_t one = 1;
+	if ( ::write(eventFd_, &one, sizeof(one)) < 0 )
+	{
+		; /* counter saturated, the writer is awake anyway */
+	}
+	pthread_join(writer_, NULL);
+
+	async_ = false;
+
+	close(eventFd_);
+	eventFd_ = -1;
+
+	for ( size_t i = 0; i < capacity_; ++i )
+	{
+		free(slots_[i].data);
+	}
+	delete [] slots_;
+	slots_ = NULL;
+}
+
+
+/*
+ * Records discarded because the queue was full.
+ */
+unsigned long Logger::dropped() const
+{
+	return __atomic_load_n(&dropped_, __ATOMIC_RELAXED);
+}
+
+
+/*
+ * Build a logging record and write it to the backend appenders, directly or
+ * through the writer thread.
  * Format: <TIMESTAMP><SPACE><LOGLEVEL><SPACE><MESSAGE><NEWLINE>
  */
 void Logger::write( LogLevel level, const std::string& s )
@@ -104,39 +260,252 @@ void Logger::write( LogLevel level, const std::string& s )
 		return;
 	}
 
-	struct timeval tvbuf;
-	gettimeofday(&tvbuf, 0);
+	if ( async_ )
+	{
+		writeAsync(level, s);
+	}
+	else
+	{
+		writeSync(level, s);
+	}
+}
 
-	struct tm tmbuf;
-	localtime_r(&tvbuf.tv_sec, &tmbuf);
 
-	char timestamp[26 + 1];   /* YYYY-MM-DD HH:MM:SS.uuuuuu<NUL> */
+/*
+ * Format the record and write it out to all appenders in this thread.
+ */
+void Logger::writeSync( LogLevel level, const std::string& s )
+{
+	std::string record;
+	record.resize(HEADER_LENGTH);
+	format_header(&record[0], level);
+	record.reserve(HEADER_LENGTH + s.length() + 1);
+	record += s;
+	record += '\n';
+
+	pthread_mutex_lock(&write_mutex_);
+
+	std::vector<Appender*>::const_iterator i;
+	for ( i = appenders_.begin(); i != appenders_.end(); ++i )
+	{
+		(*i)->write(level, record);
+	}
+
+	pthread_mutex_unlock(&write_mutex_);
+}
 
-	const char* fmt = "%Y-%m-%d %H:%M:%S";
-	size_t len = strftime(timestamp, sizeof(timestamp)-7, fmt, &tmbuf);
-	sprintf(&timestamp[len], ".%06ld", tvbuf.tv_usec);
 
-	const char* loglevels[] = { "EMERG ", "ALERT ", "CRIT  ", "ERROR ", "WARN  ", "NOTICE", "INFO  ", "DEBUG " };
+/*
+ * Claim the next queue position, format the record straight into its slot
+ * and publish it to the writer thread.
+ */
+void Logger::writeAsync( LogLevel level, const std::string& s )
+{
+	size_t pos = __atomic_load_n(&tail_, __ATOMIC_RELAXED);
+	Slot* slot;
 
-	std::stringstream ss;
-	ss << timestamp << " "
-	   << loglevels[level] << " "
-	   << s << "\n";
+	for ( ;; )
+	{
+		slot = &slots_[pos & (capacity_ - 1)];
+		size_t seq = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+		ssize_t diff = (ssize_t) (seq - pos);
 
-	/* write the formatted message out to all appenders.
+		if ( diff == 0 )
+		{
+			if ( __atomic_compare_exchange_n(&tail_, &pos, pos + 1, true,
+			                                 __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+			{
+				break;
+			}
+			/* pos now holds the current tail */
+		}
+		else if ( diff < 0 )
+		{
+			/* full: the slot still holds a record from the previous lap */
+			if ( (policy_ == OVERFLOW_DROP) && (level > LOGLEVEL_NOTICE) )
+			{
+				__atomic_add_fetch(&dropped_, 1, __ATOMIC_RELAXED);
+				return;
+			}
+			sched_yield();
+			pos = __atomic_load_n(&tail_, __ATOMIC_RELAXED);
+		}
+		else
+		{
+			/* another producer took this position */
+			pos = __atomic_load_n(&tail_, __ATOMIC_RELAXED);
+		}
+	}
+
+	/* The position is ours, so it has to be published even if the text
+	 * cannot be stored.
 	 */
+	size_t length = HEADER_LENGTH + s.length() + 1;
+	if ( slot->capacity < length )
+	{
+		char* grown = (char*) realloc(slot->data, length);
+		if ( grown )
+		{
+			slot->data = grown;
+			slot->capacity = length;
+		}
+		else
+		{
+			length = 0;
+		}
+	}
+
+	if ( length )
+	{
+		format_header(slot->data, level);
+		memcpy(&slot->data[HEADER_LENGTH], s.data(), s.length());
+		slot->data[length - 1] = '\n';
+	}
+	slot->level = level;
+	slot->length = length;
+
+	/* Sequentially consistent, paired with the writer setting sleeping_
+	 * before it looks at the slot: either it sees this record or we see
+	 * that it is asleep.
+	 */
+	__atomic_store_n(&slot->sequence, pos + 1, __ATOMIC_SEQ_CST);
+	wakeWriter();
+}
+
+
+/*
+ * Wake the writer thread if it is waiting for records. Costs a syscall
+ * only for the first record after it has gone idle.
+ */
+void Logger::wakeWriter()
+{
+	if ( __atomic_load_n(&sleeping_, __ATOMIC_SEQ_CST) &&
+	     __atomic_exchange_n(&sleeping_, 0, __ATOMIC_SEQ_CST) )
+	{
+		uint64_t one = 1;
+		if ( ::write(eventFd_, &one, sizeof(one)) < 0 )
+		{
+			; /* counter saturated, the writer is awake anyway */
+		}
+	}
+}
+
+
+/*
+ * Pass a batch of records to all appenders.
+ */
+void Logger::writeRecords( const Record* records, size_t count )
+{
 	pthread_mutex_lock(&write_mutex_);
 
 	std::vector<Appender*>::const_iterator i;
 	for ( i = appenders_.begin(); i != appenders_.end(); ++i )
 	{
-		(*i)->write(level, ss.str());
+		(*i)->writeBatch(records, count);
 	}
 
 	pthread_mutex_unlock(&write_mutex_);
 }
 
 
+/*
+ * Writer thread. Collect up to BATCH published records from the head of
+ * the queue, write them out and hand the slots back to the producers.
+ * Sleep on the eventfd when the queue is empty; exit once stopping and
+ * every claimed position has been written.
+ */
+void Logger::writer()
+{
+	Record records[BATCH];
+
+	for ( ;; )
+	{
+		size_t count = 0;
+		while ( count < BATCH )
+		{
+			size_t pos = head_ + count;
+			Slot& slot = slots_[pos & (capacity_ - 1)];
+			if ( __atomic_load_n(&slot.sequence, __ATOMIC_SEQ_CST) != pos + 1 )
+			{
+				break;
+			}
+			records[count].level = slot.level;
+			records[count].text = slot.length ? slot.data : "";
+			records[count].length = slot.length;
+			++count;
+		}
+
+		if ( count )
+		{
+			writeRecords(records, count);
+
+			for ( size_t i = 0; i < count; ++i )
+			{
+				size_t pos = head_ + i;
+				__atomic_store_n(&slots_[pos & (capacity_ - 1)].sequence,
+				                 pos + capacity_, __ATOMIC_RELEASE);
+			}
+			head_ += count;
+
+			unsigned long dropped = __atomic_load_n(&dropped_, __ATOMIC_RELAXED);
+			if ( dropped != reported_ )
+			{
+				std::stringstream ss;
+				ss << "Logger queue full, dropped " << dropped - reported_ << " records";
+				std::string text;
+				text.resize(HEADER_LENGTH);
+				format_header(&text[0], LOGLEVEL_WARN);
+				text += ss.str();
+				text += '\n';
+
+				Record record = { LOGLEVEL_WARN, text.data(), text.length() };
+				writeRecords(&record, 1);
+				reported_ = dropped;
+			}
+			continue;
+		}
+
+		if ( __atomic_load_n(&stopping_, __ATOMIC_SEQ_CST) )
+		{
+			if ( head_ == __atomic_load_n(&tail_, __ATOMIC_SEQ_CST) )
+			{
+				break;
+			}
+			sched_yield();   /* a claimed record is still being filled in */
+			continue;
+		}
+
+		/* Announce that we are about to sleep, then look once more so a
+		 * record published in between is not missed. stopAsync() always
+		 * posts a wakeup.
+		 */
+		__atomic_store_n(&sleeping_, 1, __ATOMIC_SEQ_CST);
+		Slot& slot = slots_[head_ & (capacity_ - 1)];
+		if ( __atomic_load_n(&slot.sequence, __ATOMIC_SEQ_CST) == head_ + 1 )
+		{
+			__atomic_store_n(&sleeping_, 0, __ATOMIC_SEQ_CST);
+			continue;
+		}
+
+		uint64_t wakeups;
+		if ( read(eventFd_, &wakeups, sizeof(wakeups)) < 0 )
+		{
+			; /* EINTR, look at the queue again */
+		}
+	}
+}
+
+
+/*
+ * pthread entry point for the writer thread.
+ */
+void* Logger::writerThread( void* arg )
+{
+	static_cast<Logger*>(arg)->writer();
+	return NULL;
+}
+
+
 /*
  * Tell each appender to restart.
  */
@@ -154,6 +523,18 @@ void Logger::restart()
 }
 
 
+/*
+ * Default batch output: one write() per record.
+ */
+void Logger::Appender::writeBatch( const Logger::Record* records, size_t count )
+{
+	for ( size_t i = 0; i < count; ++i )
+	{
+		write(records[i].level, std::string(records[i].text, records[i].length));
+	}
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 
 /*!
@@ -252,7 +633,9 @@ FileAppender::FileAppender( const std::string& path,
                             ssize_t max_size )
 	: path_ (path),
 	  basename_ (basename),
-	  max_size_ (max_size)
+	  max_size_ (max_size),
+	  fd_ (-1),
+	  size_ (0)
 {
 	;
 }
@@ -263,7 +646,10 @@ FileAppender::FileAppender( const std::string& path,
  */
 FileAppender::~FileAppender()
 {
-	fout_.close();
+	if ( fd_ >= 0 )
+	{
+		close(fd_);
+	}
 }
 
 
@@ -291,7 +677,8 @@ void FileAppender::open()
 	filename << std::setw(2) << std::setfill('0') << tmbuf.tm_sec;
 	filename << ".log";
 
-	fout_.open(filename.str().c_str(), std::ios::app);
+	fd_ = ::open(filename.str().c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+	size_ = 0;
 }
 
 
@@ -300,31 +687,74 @@ void FileAppender::open()
  */
 void FileAppender::rollover()
 {
-	fout_.close();
-	fout_.clear();
+	if ( fd_ >= 0 )
+	{
+		close(fd_);
+		fd_ = -1;
+	}
 
 	open();
 }
 
 
 /*
- * Copy the message to a file.
+ * Copy the message to a file. The file is unbuffered, so the message has
+ * reached the kernel when this returns.
  */
 void FileAppender::write( Logger::LogLevel level, const std::string& msg )
 {
-	if ( !fout_.is_open() )
+	if ( fd_ < 0 )
 	{
 		open();
 	}
 
-	if ( fout_.good() )
+	if ( fd_ >= 0 )
 	{
-		fout_ << msg;
-		if ( level <= Logger::LOGLEVEL_NOTICE )
+		ssize_t n = ::write(fd_, msg.data(), msg.length());
+		if ( n > 0 )
 		{
-			fout_.flush();
+			size_ += n;
 		}
-		if ( (max_size_) && (fout_.tellp() > max_size_) )
+		if ( (max_size_) && (size_ > max_size_) )
+		{
+			rollover();
+		}
+	}
+}
+
+
+/*
+ * Copy a batch of messages to the file with a single writev(). The size
+ * limit is checked per batch, so a file may overrun it by one batch.
+ */
+void FileAppender::writeBatch( const Logger::Record* records, size_t count )
+{
+	if ( fd_ < 0 )
+	{
+		open();
+	}
+
+	if ( fd_ >= 0 )
+	{
+		struct iovec iov[64];
+		while ( count )
+		{
+			int n = count < 64 ? count : 64;
+			for ( int i = 0; i < n; ++i )
+			{
+				iov[i].iov_base = const_cast<char*>(records[i].text);
+				iov[i].iov_len = records[i].length;
+			}
+
+			ssize_t written = writev(fd_, iov, n);
+			if ( written > 0 )
+			{
+				size_ += written;
+			}
+			records += n;
+			count -= n;
+		}
+		if ( (max_size_) && (size_ > max_size_) )
 		{
 			rollover();
 		}
@@ -365,6 +795,21 @@ void SyslogAppender::write( Logger::LogLevel level, const std::string& msg )
 }
 
 
+/*
+ * As write(), without building strings for the messages it ignores.
+ */
+void SyslogAppender::writeBatch( const Logger::Record* records, size_t count )
+{
+	for ( size_t i = 0; i < count; ++i )
+	{
+		if ( records[i].level <= Logger::LOGLEVEL_NOTICE )
+		{
+			syslog(records[i].level, "%.*s", (int) records[i].length, records[i].text);
+		}
+	}
+}
+
+
 /*
  * vim:ts=4:set nu:
  */
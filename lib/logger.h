@@ -38,6 +38,7 @@
 #include <string>
 #include <vector>
 
+#include <sys/types.h>
 #include <pthread.h>
 
 /*--------------------------------------------------------------------------*/
@@ -68,6 +69,27 @@ public:
 		LOGLEVEL_DEBUG  = 7   /*!< fine-grained info for debugging */
 	};
 
+	/*!
+	 * What write() does in asynchronous mode when the queue is full.
+	 * Records at LOGLEVEL_NOTICE or more severe always wait for room.
+	 */
+	enum OverflowPolicy
+	{
+		OVERFLOW_BLOCK = 0,  /*!< wait for the writer thread to catch up */
+		OVERFLOW_DROP  = 1   /*!< discard INFO and DEBUG records and count them */
+	};
+
+	/*!
+	 * A formatted message, newline included, as passed to
+	 * Appender::writeBatch().
+	 */
+	struct Record
+	{
+		LogLevel    level;
+		const char* text;
+		size_t      length;
+	};
+
 	/*!
 	 * \class Appender
 	 * Appenders are used to write logging output to specific destinations such
@@ -96,6 +118,12 @@ public:
 		 * Output the message
 		 */
 		virtual void write( Logger::LogLevel level, const std::string& s ) = 0;
+
+		/*!
+		 * Output several messages at once. Called by the writer thread in
+		 * asynchronous mode; the default writes them one at a time.
+		 */
+		virtual void writeBatch( const Logger::Record* records, size_t count );
 	};
 
 	/*!
@@ -123,6 +151,38 @@ public:
 	 */
 	void setLevel( Logger::LogLevel level );
 
+	/*!
+	 * True if messages at 'level' are written. Lets the LOGxxx macros skip
+	 * formatting messages that would be discarded.
+	 */
+	bool isEnabled( Logger::LogLevel level ) const { return level <= level_; }
+
+	/*!
+	 * Hand messages to a background writer thread instead of writing them
+	 * to the appenders in the caller. write() then only formats the record
+	 * into a lock-free queue; the writer thread passes ready records to the
+	 * appenders in batches.
+	 * This is not thread-safe, designed to be called from a single threaded
+	 * environment at startup, after attaching the appenders and after any
+	 * fork().
+	 * \param capacity - queue length in records, rounded up to a power of two.
+	 * \param policy - what to do when the queue is full.
+	 */
+	void startAsync( size_t capacity = 4096,
+	                 Logger::OverflowPolicy policy = OVERFLOW_BLOCK );
+
+	/*!
+	 * Write out every queued record, stop the writer thread and return to
+	 * synchronous writes. Called by the dtor; call it earlier only once no
+	 * other thread is logging.
+	 */
+	void stopAsync();
+
+	/*!
+	 * Number of records discarded because the queue was full.
+	 */
+	unsigned long dropped() const;
+
 	/*!
 	 * Write a log message.
 	 * \param level - one of the LogLevel constants.
@@ -145,12 +205,63 @@ private:
 
 	~Logger();
 
+	/*!
+	 * One entry of the asynchronous queue. 'sequence' says who owns it:
+	 * position p is free for a producer when sequence == p, and ready for
+	 * the writer thread when sequence == p + 1. The text buffer belongs to
+	 * the slot and is reused; it only grows.
+	 */
+	struct Slot
+	{
+		size_t   sequence;
+		LogLevel level;
+		char*    data;
+		size_t   length;
+		size_t   capacity;
+	};
+
+	/* Records handed to the appenders per batch. Keep within IOV_MAX.
+	 */
+	static const size_t BATCH = 64;
+
+	void writeSync( LogLevel level, const std::string& s );
+	void writeAsync( LogLevel level, const std::string& s );
+	void wakeWriter();
+	void writeRecords( const Record* records, size_t count );
+	void writer();
+
+	static void* writerThread( void* arg );
+
 private:
 
 	LogLevel level_;
 	std::vector<Appender*> appenders_;
 
 	pthread_mutex_t write_mutex_;   /*!< ensures writes to appenders are atomic */
+
+	/* Asynchronous mode. A bounded multi-producer / single-consumer queue:
+	 * producers claim a position by advancing tail_ with a CAS, fill the
+	 * slot and publish it through its sequence number; the writer thread
+	 * is the only consumer and owns head_.
+	 */
+	bool            async_;
+	OverflowPolicy  policy_;
+	Slot*           slots_;
+	size_t          capacity_;      /*!< power of two */
+	int             eventFd_;       /*!< wakes the writer thread */
+	pthread_t       writer_;
+	int             sleeping_;      /*!< writer is waiting on eventFd_ */
+	int             stopping_;
+	unsigned long   dropped_;
+	unsigned long   reported_;      /*!< drops already logged by the writer */
+
+	/* Kept on separate cache lines so producers and the writer don't share one.
+	 */
+	char            pad1_[64];
+	size_t          head_;          /*!< written by the writer thread */
+	char            pad2_[64 - sizeof(size_t)];
+	size_t          tail_;          /*!< advanced by producers */
+	char            pad3_[64 - sizeof(size_t)];
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -244,6 +355,8 @@ public:
 
 	virtual void write( Logger::LogLevel level, const std::string& msg );
 
+	virtual void writeBatch( const Logger::Record* records, size_t count );
+
 	virtual void restart() { rollover(); }
 
 private:
@@ -259,7 +372,8 @@ private:
 	std::string   path_;
 	std::string   basename_;
 	ssize_t       max_size_;
-	std::ofstream fout_;
+	int           fd_;
+	ssize_t       size_;     /*!< bytes in the current file */
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -281,6 +395,8 @@ public:
 
 	virtual void write( Logger::LogLevel level, const std::string& msg );
 
+	virtual void writeBatch( const Logger::Record* records, size_t count );
+
 private:
 
 	SyslogAppender( const SyslogAppender& );
@@ -295,57 +411,74 @@ private:
 
 
 /* Log macros providing a stream compatible interface. One macro per log level.
+ * The message is only formatted if the level is enabled.
  *
  * Usage:
  *      	LOGNOTICE("Initialising...");
  *      	LOGDEBUG("Received " << count << " bytes.");
  */
 #define LOGDEBUG(message) do { \
-	std::stringstream _ss; \
-	_ss << message; \
-	Logger::instance().write(Logger::LOGLEVEL_DEBUG, _ss.str()); \
+	if ( Logger::instance().isEnabled(Logger::LOGLEVEL_DEBUG) ) { \
+		std::stringstream _ss; \
+		_ss << message; \
+		Logger::instance().write(Logger::LOGLEVEL_DEBUG, _ss.str()); \
+	} \
 } while(0)
 
 #define LOGINFO(message) do { \
-	std::stringstream _ss; \
-	_ss << message; \
-	Logger::instance().write(Logger::LOGLEVEL_INFO, _ss.str()); \
+	if ( Logger::instance().isEnabled(Logger::LOGLEVEL_INFO) ) { \
+		std::stringstream _ss; \
+		_ss << message; \
+		Logger::instance().write(Logger::LOGLEVEL_INFO, _ss.str()); \
+	} \
 } while(0)
 
 #define LOGNOTICE(message) do { \
-	std::stringstream _ss; \
-	_ss << message; \
-	Logger::instance().write(Logger::LOGLEVEL_NOTICE, _ss.str()); \
+	if ( Logger::instance().isEnabled(Logger::LOGLEVEL_NOTICE) ) { \
+		std::stringstream _ss; \
+		_ss << message; \
+		Logger::instance().write(Logger::LOGLEVEL_NOTICE, _ss.str()); \
+	} \
 } while(0)
 
 #define LOGWARN(message) do { \
-	std::stringstream _ss; \
-	_ss << message; \
-	Logger::instance().write(Logger::LOGLEVEL_WARN, _ss.str()); \
+	if ( Logger::instance().isEnabled(Logger::LOGLEVEL_WARN) ) { \
+		std::stringstream _ss; \
+		_ss << message; \
+		Logger::instance().write(Logger::LOGLEVEL_WARN, _ss.str()); \
+	} \
 } while(0)
 
 #define LOGERROR(message) do { \
-	std::stringstream _ss; \
-	_ss << message; \
-	Logger::instance().write(Logger::LOGLEVEL_ERR, _ss.str()); \
+	if ( Logger::instance().isEnabled(Logger::LOGLEVEL_ERR) ) { \
+		std::stringstream _ss; \
+		_ss << message; \
+		Logger::instance().write(Logger::LOGLEVEL_ERR, _ss.str()); \
+	} \
 } while(0)
 
 #define LOGCRIT(message) do { \
-	std::stringstream _ss; \
-	_ss << message; \
-	Logger::instance().write(Logger::LOGLEVEL_CRIT, _ss.str()); \
+	if ( Logger::instance().isEnabled(Logger::LOGLEVEL_CRIT) ) { \
+		std::stringstream _ss; \
+		_ss << message; \
+		Logger::instance().write(Logger::LOGLEVEL_CRIT, _ss.str()); \
+	} \
 } while(0)
 
 #define LOGALERT(message) do { \
-	std::stringstream _ss; \
-	_ss << message; \
-	Logger::instance().write(Logger::LOGLEVEL_ALERT, _ss.str()); \
+	if ( Logger::instance().isEnabled(Logger::LOGLEVEL_ALERT) ) { \
+		std::stringstream _ss; \
+		_ss << message; \
+		Logger::instance().write(Logger::LOGLEVEL_ALERT, _ss.str()); \
+	} \
 } while(0)
 
 #define LOGEMERG(message) do { \
-	std::stringstream _ss; \
-	_ss << message; \
-	Logger::instance().write(Logger::LOGLEVEL_EMERG, _ss.str()); \
+	if ( Logger::instance().isEnabled(Logger::LOGLEVEL_EMERG) ) { \
+		std::stringstream _ss; \
+		_ss << message; \
+		Logger::instance().write(Logger::LOGLEVEL_EMERG, _ss.str()); \
+	} \
 } while(0)
 
 
@@ -52,24 +52,15 @@ static const char *APP_DESCRIPTION = "PowerMedia XMS - REST Conferencing C++ Dem
 
 static const char *PID_FILE = "/var/run/restconfdemo.pid";
 
-// Event queue and locks
-std::queue<std::string> eventQueue;
-pthread_mutex_t queueLock = PTHREAD_MUTEX_INITIALIZER;
-pthread_cond_t queueNotEmpty = PTHREAD_COND_INITIALIZER;
-pthread_t evHandlerThread;
-
-// REST service address/port
-std::string xmsAddr;
-
-static std::string eventHandlerId;
-
 /*!
  * \var exit_pipe
  * Pipe used by signal handlers to tell the application to exit cleanly.
  */
 static int exit_pipe[2];
 int term = false;
+int term_signal = 0;
 int log_restart = false;
+int stats_dump = false;
 
 /*!
  * Function prototype for signal handlers.
@@ -101,13 +92,13 @@ setSignalHandler (int signum, signal_handler_t * handler)
 void
 sig_terminate (int signo)
 {
-    LOGDEBUG("SIGTERM received.  Shutting down application");
-    // Send a signal to main thread to break it loose from waiting on
-    // the event queue
-    pthread_cond_signal(&queueNotEmpty);
+    // Wake the main thread so it breaks loose from waiting on
+    // the exit pipe. No logging here, the logger is not async-signal-safe;
+    // the main thread logs term_signal once it wakes.
+    term_signal = signo;
+    term = true;
     char sig = (char) signo;
     write (exit_pipe[1], &sig, 1);
-    term = true;
 }
 
 
@@ -117,8 +108,21 @@ sig_terminate (int signo)
 void
 sig_reload (int signo)
 {
-    (void) signo;
 	log_restart = true;
+    char sig = (char) signo;
+    write (exit_pipe[1], &sig, 1);
+}
+
+
+/*!
+ * Signal handler for SIGUSR1. Asks for the REST latency figures.
+ */
+void
+sig_dump_stats (int signo)
+{
+    stats_dump = true;
+    char sig = (char) signo;
+    write (exit_pipe[1], &sig, 1);
 }
 
 
@@ -147,9 +151,17 @@ main (int argc, char *argv[])
     opts.addOptionNoArg ('v', "verbose", "Run with maximum logging.");
     opts.addOptionNoArg ('c', "console", "Run as a console application.");
     opts.addOptionRequiredArg ('\0', "log-dir", "Directory used to store log files.");
+    opts.addOptionRequiredArg ('\0', "log-overflow", "When the log queue is full: block (default) or drop debug and info messages");
     opts.addOptionRequiredArg ('d', "dtmf-mode", "DTMF type - rfc2833 or sipinfo");
-    opts.addOptionRequiredArg ('a', "ip-address", "XMS server IP address");
+    opts.addOptionRequiredArg ('a', "ip-address", "XMS server IP address, or a comma separated list of ip[:port]");
     opts.addOptionRequiredArg ('p', "port", "XMS server REST messaging port");
+    opts.addOptionRequiredArg ('w', "workers", "Event worker threads (default: one per CPU)");
+    opts.addOptionRequiredArg ('l', "layouts", "Ini file with custom conference layouts in a [layouts] section");
+    opts.addOptionRequiredArg ('t', "trace-file", "Trace each event through the application to this file, as Chrome trace-event JSON");
+    opts.addOptionRequiredArg ('\0', "record-events", "Record every event from XMS to this file, for --replay-events");
+    opts.addOptionRequiredArg ('\0', "replay-events", "Replay recorded events instead of connecting to XMS, then exit");
+    opts.addOptionRequiredArg ('\0', "replay-speed", "Replay at this multiple of real time, 0 for as fast as possible (default 1)");
+    opts.addOptionNoArg ('\0', "replay-sink", "Answer REST commands during replay locally, instead of sending them to -a");
     opts.parseOptions (argc, argv);
 
     if (opts.isFound ("help"))
@@ -217,6 +229,17 @@ main (int argc, char *argv[])
         write (fd, pid.str ().c_str (), pid.str ().length ());
     }
 
+    /* Write log files from a background thread. Started after daemon(),
+     * which would not carry the thread over the fork.
+     */
+    std::string opt_log_overflow = opts.getValue ("log-overflow");
+    if (!opt_log_overflow.empty () && opt_log_overflow != "block" && opt_log_overflow != "drop")
+    {
+        LOGCRIT ("main() log-overflow must be block or drop, not " << opt_log_overflow);
+        exit (1);
+    }
+    Logger::instance ().startAsync (8192, opt_log_overflow == "drop" ? Logger::OVERFLOW_DROP : Logger::OVERFLOW_BLOCK);
+
     /* Create 'selfpipe' for sig handlers
      */
     pipe (exit_pipe);
@@ -230,6 +253,7 @@ main (int argc, char *argv[])
     setSignalHandler (SIGQUIT, sig_terminate);
     setSignalHandler (SIGTERM, sig_terminate);
     setSignalHandler (SIGHUP, sig_reload);
+    setSignalHandler (SIGUSR1, sig_dump_stats);
     setSignalHandler (SIGCHLD, sig_child_exit);
 
     /* Log version and the command line options.
@@ -0,0 +1,318 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "logger.h"
+#include "callstorm.h"
+
+/*----------------------------------------------------------------------------*/
+
+const char *
+    CallStorm::stageNames_[NUM_STAGES] = { "answer", "add_party", "click", "play" };
+
+/*
+ * ctor
+ */
+CallStorm::CallStorm (const CallStormConfig & config)
+{
+    config_ = config;
+    if (config_.roomSize < 1)
+        config_.roomSize = 1;
+    rate_ = config_.startRate;
+    stepStartUs_ = 0;
+    lastTickUs_ = 0;
+    owed_ = 0;
+    rooms_ = 0;
+    roomFill_ = config_.roomSize;
+    finished_ = false;
+    placed_ = 0;
+    completed_ = 0;
+    lost_ = 0;
+}
+
+void
+CallStorm::onStart (XmsMockServer & server, uint64_t nowUs)
+{
+    LOGNOTICE ("Call storm starting at " << rate_ << " calls/s, +" << config_.rateStep << " every " <<
+               config_.stepSecs << " s");
+    printf ("%8s %8s %8s %6s", "offered", "placed", "done/s", "lost");
+    for (int stage = 0; stage < NUM_STAGES; stage++)
+        printf (" | %-9s %7s %7s %7s", stageNames_[stage], "p50ms", "p99ms", "maxms");
+    printf ("\n");
+    fflush (stdout);
+    beginStep (nowUs);
+}
+
+void
+CallStorm::beginStep (uint64_t nowUs)
+{
+    stepStartUs_ = nowUs;
+    lastTickUs_ = nowUs;
+    placed_ = 0;
+    completed_ = 0;
+    lost_ = 0;
+    for (int stage = 0; stage < NUM_STAGES; stage++)
+        latency_[stage] = LatencyHistogram ();
+}
+
+void
+CallStorm::onTick (XmsMockServer & server, uint64_t nowUs)
+{
+    if (finished_)
+        return;
+
+    // Calls at an even rate; a late tick places the ones it owes at once
+    owed_ += rate_ * (nowUs - lastTickUs_) / 1000000.0;
+    lastTickUs_ = nowUs;
+    while (owed_ >= 1)
+    {
+        placeCall (server, nowUs);
+        owed_ -= 1;
+    }
+
+    while (!actions_.empty () && actions_.begin ()->first <= nowUs)
+    {
+        Action action = actions_.begin ()->second;
+        actions_.erase (actions_.begin ());
+        runAction (server, action, nowUs);
+    }
+
+    if (nowUs - stepStartUs_ >= (uint64_t) config_.stepSecs * 1000000)
+    {
+        endStep (nowUs);
+        if (!finished_)
+        {
+            rate_ += config_.rateStep;
+            beginStep (nowUs);
+        }
+    }
+}
+
+void
+CallStorm::placeCall (XmsMockServer & server, uint64_t nowUs)
+{
+    // Rooms are filled in turn, and never past what the app accepts
+    if (roomFill_ == config_.roomSize)
+    {
+        rooms_++;
+        roomFill_ = 0;
+    }
+    roomFill_++;
+    char room[32];
+    snprintf (room, sizeof (room), "storm%u", rooms_);
+
+    std::string callId = server.placeCall (room, std::string ());
+    placed_++;
+    pendingByCall_[STAGE_ANSWER][callId] = nowUs;
+
+    uint64_t holdUs = (uint64_t) config_.holdSecs * 1000000;
+    Action action;
+    action.callId = callId;
+    if (rand () < config_.clickRatio * RAND_MAX)
+    {
+        action.kind = ACTION_CLICK;
+        actions_.insert (std::make_pair (nowUs + holdUs / 2, action));
+    }
+    if (rand () < config_.playRatio * RAND_MAX)
+    {
+        action.kind = ACTION_PLAY;
+        actions_.insert (std::make_pair (nowUs + holdUs / 3, action));
+    }
+    action.kind = ACTION_HANGUP;
+    actions_.insert (std::make_pair (nowUs + holdUs, action));
+}
+
+void
+CallStorm::runAction (XmsMockServer & server, const Action & action, uint64_t nowUs)
+{
+    std::map < std::string, std::string >::iterator conf_iterator = callConf_.find (action.callId);
+    switch (action.kind)
+    {
+    case ACTION_CLICK:
+        // The controller mutes whoever is in region 1, top left in every
+        // layout; the app answers with update_party on that call
+        if (conf_iterator != callConf_.end () && server.sendInfo (action.callId, "CLICK 100 100 mute controller"))
+            pendingByConf_[STAGE_CLICK][conf_iterator->second].push_back (nowUs);
+        break;
+
+    case ACTION_PLAY:
+        if (conf_iterator != callConf_.end () && server.sendDtmf (action.callId, "4"))
+            pendingByConf_[STAGE_PLAY][conf_iterator->second].push_back (nowUs);
+        break;
+
+    case ACTION_HANGUP:
+        server.hangupCall (action.callId);
+        if (conf_iterator != callConf_.end ())
+            callConf_.erase (conf_iterator);
+        break;
+    }
+}
+
+void
+CallStorm::onCallEvent (const char *type, const std::string & callId, uint64_t nowUs)
+{
+    if (strcmp (type, "answered") == 0)
+        pendingByCall_[STAGE_ADD_PARTY][callId] = nowUs;
+}
+
+void
+CallStorm::onRequest (const std::string & method, const std::string & path, const std::string & body, uint64_t nowUs)
+{
+    static const std::string calls = "/default/calls/";
+    static const std::string conferences = "/default/conferences/";
+    if (method != "PUT")
+        return;
+
+    if (path.compare (0, calls.size (), calls) == 0)
+    {
+        std::string callId = path.substr (calls.size ());
+        if (body.find ("answer=\"yes\"") != std::string::npos)
+        {
+            matchByCall (STAGE_ANSWER, callId, nowUs);
+        }
+        else if (body.find ("<add_party") != std::string::npos)
+        {
+            std::string::size_type start = body.find ("conf_id=\"");
+            if (start != std::string::npos)
+            {
+                start += 9;
+                callConf_[callId] = body.substr (start, body.find ('"', start) - start);
+            }
+            if (pendingByCall_[STAGE_ADD_PARTY].count (callId))
+                completed_++;
+            matchByCall (STAGE_ADD_PARTY, callId, nowUs);
+        }
+        else if (body.find ("<update_party") != std::string::npos)
+        {
+            std::map < std::string, std::string >::iterator conf_iterator = callConf_.find (callId);
+            if (conf_iterator != callConf_.end ())
+                matchByConf (STAGE_CLICK, conf_iterator->second, nowUs);
+        }
+    }
+    else if (path.compare (0, conferences.size (), conferences) == 0 && body.find ("<play") != std::string::npos)
+    {
+        matchByConf (STAGE_PLAY, path.substr (conferences.size ()), nowUs);
+    }
+}
+
+void
+CallStorm::matchByCall (Stage stage, const std::string & callId, uint64_t nowUs)
+{
+    PendingByCall::iterator pending_iterator = pendingByCall_[stage].find (callId);
+    if (pending_iterator == pendingByCall_[stage].end ())
+        return;
+    latency_[stage].record (nowUs - pending_iterator->second);
+    pendingByCall_[stage].erase (pending_iterator);
+}
+
+void
+CallStorm::matchByConf (Stage stage, const std::string & confId, uint64_t nowUs)
+{
+    PendingByConf::iterator pending_iterator = pendingByConf_[stage].find (confId);
+    if (pending_iterator == pendingByConf_[stage].end ())
+        return;
+    latency_[stage].record (nowUs - pending_iterator->second.front ());
+    pending_iterator->second.pop_front ();
+    if (pending_iterator->second.empty ())
+        pendingByConf_[stage].erase (pending_iterator);
+}
+
+void
+CallStorm::expire (uint64_t nowUs)
+{
+    for (int stage = 0; stage < NUM_STAGES; stage++)
+    {
+        PendingByCall::iterator call_iterator = pendingByCall_[stage].begin ();
+        while (call_iterator != pendingByCall_[stage].end ())
+        {
+            if (nowUs - call_iterator->second > TIMEOUT_US)
+            {
+                lost_++;
+                pendingByCall_[stage].erase (call_iterator++);
+            }
+            else
+                call_iterator++;
+        }
+
+        PendingByConf::iterator conf_iterator = pendingByConf_[stage].begin ();
+        while (conf_iterator != pendingByConf_[stage].end ())
+        {
+            std::deque < uint64_t > &queue = conf_iterator->second;
+            while (!queue.empty () && nowUs - queue.front () > TIMEOUT_US)
+            {
+                lost_++;
+                queue.pop_front ();
+            }
+            if (queue.empty ())
+                pendingByConf_[stage].erase (conf_iterator++);
+            else
+                conf_iterator++;
+        }
+    }
+}
+
+void
+CallStorm::endStep (uint64_t nowUs)
+{
+    expire (nowUs);
+    double seconds = (nowUs - stepStartUs_) / 1000000.0;
+    double done = completed_ / seconds;
+
+    printf ("%8.1f %8lu %8.1f %6lu", rate_, placed_, done, lost_);
+    bool slow = false;
+    for (int stage = 0; stage < NUM_STAGES; stage++)
+    {
+        const LatencyHistogram & latency = latency_[stage];
+        printf (" | %-9lu %7.1f %7.1f %7.1f", (unsigned long) latency.count (), latency.percentile (0.5) / 1000.0,
+                latency.percentile (0.99) / 1000.0, latency.max () / 1000.0);
+        if (latency.percentile (0.99) > (uint64_t) config_.maxP99Ms * 1000)
+            slow = true;
+    }
+    printf ("\n");
+    fflush (stdout);
+
+    // Completions trail placements by one round trip, which only shows in
+    // the first step; after that a shortfall means the app is behind
+    bool behind = rate_ > config_.startRate && done < 0.9 * rate_;
+    if (slow || behind || lost_ * 100 > placed_)
+    {
+        printf ("Saturated at %.1f calls/s (%s)\n", rate_,
+                slow ? "p99 latency" : (behind ? "throughput" : "lost commands"));
+        finished_ = true;
+    }
+    else if (rate_ + config_.rateStep > config_.maxRate || config_.rateStep <= 0)
+    {
+        printf ("Reached %.1f calls/s without saturating\n", rate_);
+        finished_ = true;
+    }
+    fflush (stdout);
+}
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
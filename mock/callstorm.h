@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+#ifndef _CALLSTORM_H
+#define _CALLSTORM_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <stdint.h>
+#include <string>
+#include <map>
+#include <deque>
+#include "xmsmockserver.h"
+#include "latencystats.h"
+
+/*----------------------------------------------------------------------------*/
+
+/*!
+ * \struct CallStormConfig
+ * Offered load and when to stop.
+ */
+struct CallStormConfig
+{
+    double startRate;           // new calls per second in the first step
+    double rateStep;            // added each step
+    double maxRate;             // stop after this step even if not saturated
+    int stepSecs;
+    int holdSecs;               // each call hangs up after this long
+    int roomSize;               // calls per room; the app takes one per region at most
+    double clickRatio;          // share of calls that send an INFO CLICK
+    double playRatio;           // share that press 4 for a video play
+    int maxP99Ms;               // a stage slower than this is saturation
+};
+
+/*!
+ * \class CallStorm
+ * Load generator run inside xmsmock. Places calls into the app at a
+ * steady rate, raising the rate every step, and times each step of every
+ * call from the event the mock sends to the REST command it causes
+ * arriving back:
+ *   answer     incoming  -> PUT answer
+ *   add_party  answered  -> PUT add_party
+ *   click      INFO CLICK (mute region 1) -> PUT update_party
+ *   play       DTMF 4    -> PUT play into the conference
+ * A play only happens if the app host has the demo media files.
+ *
+ * After each step one line is printed with the offered and completed
+ * rates and each stage's latency percentiles. The run stops at the first
+ * step where the app falls behind: calls completed lag the offered rate
+ * by more than 10%, a stage's p99 goes over maxP99Ms, or more than 1% of
+ * the expected commands never come.
+ */
+class CallStorm:public XmsMockObserver
+{
+  public:
+    CallStorm (const CallStormConfig & config);
+
+    virtual void onStart (XmsMockServer & server, uint64_t nowUs);
+    virtual void onTick (XmsMockServer & server, uint64_t nowUs);
+    virtual void onRequest (const std::string & method, const std::string & path, const std::string & body,
+                            uint64_t nowUs);
+    virtual void onCallEvent (const char *type, const std::string & callId, uint64_t nowUs);
+
+    virtual bool finished ()
+    {
+        return finished_;
+    }
+
+  private:
+    CallStorm (const CallStorm &);
+    CallStorm & operator = (const CallStorm &);
+
+    // An expected command not back in this long is lost
+    static const uint64_t TIMEOUT_US = 5000000;
+
+    enum Stage
+    { STAGE_ANSWER, STAGE_ADD_PARTY, STAGE_CLICK, STAGE_PLAY, NUM_STAGES };
+
+    enum ActionKind
+    { ACTION_CLICK, ACTION_PLAY, ACTION_HANGUP };
+
+    struct Action
+    {
+        ActionKind kind;
+        std::string callId;
+    };
+
+    typedef std::map < std::string, uint64_t > PendingByCall;
+    typedef std::map < std::string, std::deque < uint64_t > >PendingByConf;
+
+    void placeCall (XmsMockServer & server, uint64_t nowUs);
+    void runAction (XmsMockServer & server, const Action & action, uint64_t nowUs);
+    void matchByCall (Stage stage, const std::string & callId, uint64_t nowUs);
+    void matchByConf (Stage stage, const std::string & confId, uint64_t nowUs);
+    void expire (uint64_t nowUs);
+    void endStep (uint64_t nowUs);
+    void beginStep (uint64_t nowUs);
+
+    static const char *stageNames_[NUM_STAGES];
+
+    CallStormConfig config_;
+    double rate_;
+    uint64_t stepStartUs_;
+    uint64_t lastTickUs_;
+    double owed_;               // calls due but not yet placed
+    unsigned rooms_;
+    int roomFill_;
+    bool finished_;
+
+    std::multimap < uint64_t, Action > actions_;
+    std::map < std::string, std::string > callConf_;    // call ID -> conference ID
+
+    // Answer and add_party are per call; click and play replies come back
+    // for another call or the conference, so they are matched per conference
+    PendingByCall pendingByCall_[NUM_STAGES];
+    PendingByConf pendingByConf_[NUM_STAGES];
+
+    // This step
+    unsigned long placed_;
+    unsigned long completed_;
+    unsigned long lost_;
+    LatencyHistogram latency_[NUM_STAGES];
+};
+
+#endif // _CALLSTORM_H
+/* vim:ts=4:set nu:
+ * EOF
+ */
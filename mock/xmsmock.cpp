@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <stdlib.h>
+#include <signal.h>
+#include <iostream>
+
+#include "getoption.h"
+#include "logger.h"
+#include "xmsmockserver.h"
+#include "callstorm.h"
+#include "regionallocator.h"
+
+/*----------------------------------------------------------------------------*/
+
+static const char *APP_NAME = "xmsmock";
+
+static volatile int stopServer = false;
+
+static void
+sig_terminate (int signo)
+{
+    (void) signo;
+    stopServer = true;
+}
+
+/*!
+ * Entry point. A stand-in XMS for running restconfdemo without a media
+ * server; see XmsMockServer.
+ */
+int
+main (int argc, char *argv[])
+{
+    GetOptions opts;
+    opts.addOptionNoArg ('h', "help", "Display this information.");
+    opts.addOptionNoArg ('v', "verbose", "Log every request and event.");
+    opts.addOptionRequiredArg ('p', "port", "Port to serve the XMS REST API on (default 81)");
+    opts.addOptionRequiredArg ('L', "latency-ms", "Delay every REST reply by this much");
+    opts.addOptionRequiredArg ('j', "jitter-ms", "Plus a random delay of up to this much");
+    opts.addOptionRequiredArg ('e', "error-rate", "Fraction of REST requests to fail, 0 to 1");
+    opts.addOptionRequiredArg ('E', "error-code", "HTTP status for failed requests (default 500)");
+    opts.addOptionRequiredArg ('k', "keepalive", "Seconds between keepalive events (default 30, 0 for none)");
+    opts.addOptionRequiredArg ('s', "script", "File of timed events to send once the app connects");
+    opts.addOptionNoArg ('S', "storm", "Place calls into the app at a rising rate until it saturates.");
+    opts.addOptionRequiredArg ('r', "rate", "Storm: calls per second to start at (default 1)");
+    opts.addOptionRequiredArg ('R', "rate-step", "Storm: calls per second added each step (default 1)");
+    opts.addOptionRequiredArg ('T', "step-secs", "Storm: seconds per step (default 10)");
+    opts.addOptionRequiredArg ('M', "max-rate", "Storm: stop after this rate (default 1000)");
+    opts.addOptionRequiredArg ('H', "hold-secs", "Storm: seconds each call lasts (default 20)");
+    opts.addOptionRequiredArg ('n', "room-size", "Storm: calls per room, at most 25 (default 4)");
+    opts.addOptionRequiredArg ('c', "click-ratio", "Storm: share of calls that click the layout (default 1)");
+    opts.addOptionRequiredArg ('P', "play-ratio", "Storm: share of calls that start a play (default 0)");
+    opts.addOptionRequiredArg ('m', "max-p99-ms", "Storm: p99 latency that counts as saturated (default 500)");
+    opts.parseOptions (argc, argv);
+
+    if (opts.isFound ("help"))
+    {
+        std::cout << "Command line options:" << std::endl << opts << std::endl;
+        exit (0);
+    }
+
+    Logger::instance ().setLevel (opts.isFound ("verbose") ? Logger::LOGLEVEL_DEBUG : Logger::LOGLEVEL_NOTICE);
+    Logger::instance ().attachAppender (new ConsoleAppender);
+
+    XmsMockConfig config;
+    config.port = opts.isFound ("port") ? atoi (opts.getValue ("port").c_str ()) : 81;
+    config.latencyMs = atoi (opts.getValue ("latency-ms").c_str ());
+    config.jitterMs = atoi (opts.getValue ("jitter-ms").c_str ());
+    config.errorRate = atof (opts.getValue ("error-rate").c_str ());
+    config.errorCode = opts.isFound ("error-code") ? atoi (opts.getValue ("error-code").c_str ()) : 500;
+    config.keepaliveSecs = opts.isFound ("keepalive") ? atoi (opts.getValue ("keepalive").c_str ()) : 30;
+    config.scriptFile = opts.getValue ("script");
+
+    signal (SIGPIPE, SIG_IGN);
+    signal (SIGINT, sig_terminate);
+    signal (SIGTERM, sig_terminate);
+
+    XmsMockServer server (config);
+    CallStorm *storm = NULL;
+    if (opts.isFound ("storm"))
+    {
+        CallStormConfig stormConfig;
+        stormConfig.startRate = opts.isFound ("rate") ? atof (opts.getValue ("rate").c_str ()) : 1;
+        stormConfig.rateStep = opts.isFound ("rate-step") ? atof (opts.getValue ("rate-step").c_str ()) : 1;
+        stormConfig.stepSecs = opts.isFound ("step-secs") ? atoi (opts.getValue ("step-secs").c_str ()) : 10;
+        stormConfig.maxRate = opts.isFound ("max-rate") ? atof (opts.getValue ("max-rate").c_str ()) : 1000;
+        stormConfig.holdSecs = opts.isFound ("hold-secs") ? atoi (opts.getValue ("hold-secs").c_str ()) : 20;
+        stormConfig.roomSize = opts.isFound ("room-size") ? atoi (opts.getValue ("room-size").c_str ()) : 4;
+        stormConfig.clickRatio = opts.isFound ("click-ratio") ? atof (opts.getValue ("click-ratio").c_str ()) : 1;
+        stormConfig.playRatio = atof (opts.getValue ("play-ratio").c_str ());
+        stormConfig.maxP99Ms = opts.isFound ("max-p99-ms") ? atoi (opts.getValue ("max-p99-ms").c_str ()) : 500;
+        if (stormConfig.roomSize > RegionAllocator::MAX_REGIONS)
+        {
+            std::cerr << "The app accepts at most " << RegionAllocator::MAX_REGIONS << " callers per room" << std::endl;
+            return 1;
+        }
+        storm = new CallStorm (stormConfig);
+        server.setObserver (storm);
+    }
+    if (!server.start ())
+        return 1;
+    LOGNOTICE (APP_NAME << " running. Latency " << config.latencyMs << "+" << config.jitterMs << " ms, error rate "
+               << config.errorRate);
+    server.run (&stopServer);
+    LOGNOTICE (APP_NAME << " stopping");
+    delete storm;
+    return 0;
+}
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,751 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <fstream>
+#include <sstream>
+
+#include "logger.h"
+#include "xmsmockserver.h"
+
+/*----------------------------------------------------------------------------*/
+
+// Largest request we accept; the app's biggest command is a few KB
+static const size_t MAX_REQUEST = 1024 * 1024;
+
+/*
+ * ctor
+ */
+XmsMockServer::XmsMockServer (const XmsMockConfig & config)
+{
+    config_ = config;
+    observer_ = NULL;
+    started_ = false;
+    listenFd_ = -1;
+    nextSerial_ = 0;
+    nextId_ = 0;
+    nextHandler_ = 0;
+    scriptStartMs_ = 0;
+}
+
+/*
+ * dtor
+ */
+XmsMockServer::~XmsMockServer ()
+{
+    while (!connections_.empty ())
+        closeConnection (connections_.begin ()->first);
+    if (listenFd_ >= 0)
+        close (listenFd_);
+}
+
+uint64_t
+XmsMockServer::nowMs ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+uint64_t
+XmsMockServer::nowUs ()
+{
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+bool
+XmsMockServer::start ()
+{
+    if (!config_.scriptFile.empty () && !loadScript ())
+        return false;
+
+    listenFd_ = socket (AF_INET, SOCK_STREAM, 0);
+    if (listenFd_ < 0)
+    {
+        LOGCRIT ("Cannot create listening socket: " << strerror (errno));
+        return false;
+    }
+    int one = 1;
+    setsockopt (listenFd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof (one));
+
+    struct sockaddr_in addr;
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl (INADDR_ANY);
+    addr.sin_port = htons (config_.port);
+    if (bind (listenFd_, (struct sockaddr *) &addr, sizeof (addr)) != 0 || listen (listenFd_, 128) != 0)
+    {
+        LOGCRIT ("Cannot listen on port " << config_.port << ": " << strerror (errno));
+        return false;
+    }
+    fcntl (listenFd_, F_SETFL, O_NONBLOCK | fcntl (listenFd_, F_GETFL));
+
+    if (config_.keepaliveSecs > 0)
+    {
+        Timer keepalive;
+        keepalive.kind = TIMER_KEEPALIVE;
+        schedule (nowMs () + config_.keepaliveSecs * 1000, keepalive);
+    }
+    LOGNOTICE ("Mock XMS listening on port " << config_.port);
+    return true;
+}
+
+bool
+XmsMockServer::loadScript ()
+{
+    std::ifstream in (config_.scriptFile.c_str ());
+    if (!in)
+    {
+        LOGCRIT ("Cannot open event script " << config_.scriptFile);
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline (in, line))
+    {
+        lineNumber++;
+        std::string::size_type hash = line.find ('#');
+        // raw XML may hold a '#', so comments only count at the start
+        if (hash != std::string::npos && line.find_first_not_of (" \t") == hash)
+            continue;
+
+        std::istringstream words (line);
+        ScriptStep step;
+        if (!(words >> step.atMs))
+        {
+            if (line.find_first_not_of (" \t\r") != std::string::npos)
+                LOGWARN ("Script line " << lineNumber << " has no time. Ignored");
+            continue;
+        }
+        words >> step.command;
+        std::getline (words, step.rest);
+        std::string::size_type first = step.rest.find_first_not_of (" \t");
+        step.rest = first == std::string::npos ? std::string () : step.rest.substr (first);
+        std::istringstream args (step.rest);
+        std::string arg;
+        while (args >> arg)
+            step.args.push_back (arg);
+        script_.push_back (step);
+    }
+    LOGNOTICE ("Loaded " << script_.size () << " script steps from " << config_.scriptFile);
+    return true;
+}
+
+void
+XmsMockServer::run (volatile int *stop)
+{
+    std::vector < struct pollfd > fds;
+    while (!*stop)
+    {
+        fds.clear ();
+        struct pollfd listenPoll;
+        listenPoll.fd = listenFd_;
+        listenPoll.events = POLLIN;
+        listenPoll.revents = 0;
+        fds.push_back (listenPoll);
+        std::map < int, Connection >::iterator conn_iterator;
+        for (conn_iterator = connections_.begin (); conn_iterator != connections_.end (); conn_iterator++)
+        {
+            struct pollfd connPoll;
+            connPoll.fd = conn_iterator->first;
+            connPoll.events = POLLIN | (conn_iterator->second.out.empty ()? 0 : POLLOUT);
+            connPoll.revents = 0;
+            fds.push_back (connPoll);
+        }
+
+        // An observer may have calls to place at any moment
+        int timeout = observer_ ? 1 : 1000;
+        if (!timers_.empty ())
+        {
+            uint64_t now = nowMs ();
+            uint64_t due = timers_.begin ()->first;
+            if (due <= now)
+                timeout = 0;
+            else if (due - now < (uint64_t) timeout)
+                timeout = (int) (due - now);
+        }
+        if (poll (&fds[0], fds.size (), timeout) < 0 && errno != EINTR)
+        {
+            LOGERROR ("poll failed: " << strerror (errno));
+            break;
+        }
+
+        for (size_t i = 1; i < fds.size (); i++)
+        {
+            if (!fds[i].revents)
+                continue;
+            conn_iterator = connections_.find (fds[i].fd);
+            if (conn_iterator == connections_.end ())
+                continue;
+            if (fds[i].revents & (POLLERR | POLLHUP | POLLNVAL))
+            {
+                closeConnection (fds[i].fd);
+                continue;
+            }
+            if (fds[i].revents & POLLOUT)
+                writeConnection (conn_iterator->second);
+            if ((fds[i].revents & POLLIN) && connections_.count (fds[i].fd))
+                readConnection (connections_[fds[i].fd]);
+        }
+        if (fds[0].revents & POLLIN)
+            acceptConnection ();
+
+        // Timers due now; firing one may schedule more
+        uint64_t now = nowMs ();
+        while (!timers_.empty () && timers_.begin ()->first <= now)
+        {
+            Timer timer = timers_.begin ()->second;
+            timers_.erase (timers_.begin ());
+            fireTimer (timer);
+        }
+
+        if (observer_ && started_)
+        {
+            observer_->onTick (*this, nowUs ());
+            if (observer_->finished ())
+                break;
+        }
+    }
+}
+
+void
+XmsMockServer::acceptConnection ()
+{
+    int fd;
+    while ((fd = accept (listenFd_, NULL, NULL)) >= 0)
+    {
+        fcntl (fd, F_SETFL, O_NONBLOCK | fcntl (fd, F_GETFL));
+        int one = 1;
+        setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof (one));
+        Connection & conn = connections_[fd];
+        conn.fd = fd;
+        conn.serial = ++nextSerial_;
+        conn.waiting = false;
+        LOGDEBUG ("Connection " << conn.serial << " accepted");
+    }
+}
+
+void
+XmsMockServer::closeConnection (int fd)
+{
+    std::map < int, Connection >::iterator conn_iterator = connections_.find (fd);
+    if (conn_iterator == connections_.end ())
+        return;
+    if (!conn_iterator->second.longPoll.empty ())
+    {
+        LOGNOTICE ("Long poll for event handler " << conn_iterator->second.longPoll << " closed");
+        std::vector < std::string >::iterator handler_iterator;
+        for (handler_iterator = handlers_.begin (); handler_iterator != handlers_.end (); handler_iterator++)
+        {
+            if (*handler_iterator == conn_iterator->second.longPoll)
+            {
+                handlers_.erase (handler_iterator);
+                break;
+            }
+        }
+    }
+    close (fd);
+    connections_.erase (conn_iterator);
+}
+
+void
+XmsMockServer::readConnection (Connection & conn)
+{
+    char buf[16 * 1024];
+    ssize_t n;
+    while ((n = read (conn.fd, buf, sizeof (buf))) > 0)
+        conn.in.append (buf, n);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) || conn.in.size () > MAX_REQUEST)
+    {
+        closeConnection (conn.fd);
+        return;
+    }
+
+    // cURL does not pipeline, but be safe: one request at a time
+    Request request;
+    while (!conn.waiting && conn.longPoll.empty () && parseRequest (conn, request))
+        handleRequest (conn, request);
+}
+
+void
+XmsMockServer::writeConnection (Connection & conn)
+{
+    while (!conn.out.empty ())
+    {
+        ssize_t n = write (conn.fd, conn.out.data (), conn.out.size ());
+        if (n < 0)
+        {
+            // Callers still hold conn, so it is closed from the poll loop
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                shutdown (conn.fd, SHUT_RDWR);
+                conn.out.clear ();
+            }
+            return;
+        }
+        conn.out.erase (0, n);
+    }
+}
+
+bool
+XmsMockServer::parseRequest (Connection & conn, Request & request)
+{
+    std::string::size_type headerEnd = conn.in.find ("\r\n\r\n");
+    if (headerEnd == std::string::npos)
+        return false;
+
+    size_t contentLength = 0;
+    std::istringstream headers (conn.in.substr (0, headerEnd));
+    std::string line;
+    std::getline (headers, line);
+    std::istringstream requestLine (line);
+    requestLine >> request.method >> request.path;
+    while (std::getline (headers, line))
+    {
+        if (strncasecmp (line.c_str (), "Content-Length:", 15) == 0)
+            contentLength = strtoul (line.c_str () + 15, NULL, 10);
+    }
+    if (conn.in.size () < headerEnd + 4 + contentLength)
+        return false;
+
+    request.body = conn.in.substr (headerEnd + 4, contentLength);
+    conn.in.erase (0, headerEnd + 4 + contentLength);
+    std::string::size_type query = request.path.find ('?');
+    if (query != std::string::npos)
+        request.path.erase (query);
+    return true;
+}
+
+void
+XmsMockServer::reply (Connection & conn, int code, const std::string & body)
+{
+    const char *reason = "OK";
+    if (code == 201)
+        reason = "Created";
+    else if (code == 204)
+        reason = "No Content";
+    else if (code == 404)
+        reason = "Not Found";
+    else if (code >= 400)
+        reason = "Error";
+
+    // Sent when the reply timer fires, after the configured latency
+    std::ostringstream response;
+    response << "HTTP/1.1 " << code << " " << reason << "\r\n"
+        << "Content-Type: application/xml\r\n" << "Content-Length: " << body.size () << "\r\n\r\n" << body;
+
+    int delay = config_.latencyMs;
+    if (config_.jitterMs > 0)
+        delay += rand () % (config_.jitterMs + 1);
+    Timer timer;
+    timer.kind = TIMER_REPLY;
+    timer.fd = conn.fd;
+    timer.serial = conn.serial;
+    timer.data = response.str ();
+    conn.waiting = true;
+    schedule (nowMs () + delay, timer);
+}
+
+std::string
+XmsMockServer::newId (const char *prefix)
+{
+    std::ostringstream id;
+    id << prefix << ++nextId_;
+    return id.str ();
+}
+
+std::string
+XmsMockServer::pickHandler ()
+{
+    // New calls are spread over the open long polls
+    if (handlers_.empty ())
+        return std::string ();
+    return handlers_[nextHandler_++ % handlers_.size ()];
+}
+
+std::string
+XmsMockServer::event (const char *type, const char *resourceType, const std::string & resourceId)
+{
+    std::string xml = "<web_service version=\"1.0\"><event type=\"";
+    xml += type;
+    xml += "\"";
+    if (resourceType)
+    {
+        xml += " resource_type=\"";
+        xml += resourceType;
+        xml += "\" resource_id=\"";
+        xml += resourceId;
+        xml += "\"";
+    }
+    xml += ">";
+    return xml;
+}
+
+std::string
+XmsMockServer::eventData (const char *name, const std::string & value)
+{
+    return std::string ("<event_data name=\"") + name + "\" value=\"" + value + "\"/>";
+}
+
+std::string
+XmsMockServer::endEvent ()
+{
+    return "</event></web_service>";
+}
+
+void
+XmsMockServer::handleRequest (Connection & conn, const Request & request)
+{
+    LOGDEBUG (request.method << " " << request.path);
+    if (observer_)
+        observer_->onRequest (request.method, request.path, request.body, nowUs ());
+    static const std::string eventhandlers = "/default/eventhandlers";
+    static const std::string conferences = "/default/conferences";
+    static const std::string calls = "/default/calls/";
+
+    // The long poll never fails, or the app would only see it as a lost
+    // server; every other request may
+    bool longPoll = request.method == "GET" && request.path.compare (0, eventhandlers.size () + 1, eventhandlers + "/") == 0;
+    if (!longPoll && config_.errorRate > 0 && rand () < config_.errorRate * RAND_MAX)
+    {
+        LOGDEBUG ("Failing " << request.method << " " << request.path << " with " << config_.errorCode);
+        reply (conn, config_.errorCode, std::string ());
+        return;
+    }
+
+    uint64_t now = nowMs ();
+    if (request.method == "POST" && request.path == eventhandlers)
+    {
+        std::string id = newId ("mockeh-");
+        reply (conn, 201, "<web_service version=\"1.0\"><eventhandler_response href=\"" + eventhandlers + "/" + id +
+               "\" identifier=\"" + id + "\" appid=\"app\"/></web_service>");
+    }
+    else if (longPoll)
+    {
+        std::string id = request.path.substr (eventhandlers.size () + 1);
+        conn.longPoll = id;
+        handlers_.push_back (id);
+        conn.out += "HTTP/1.1 200 OK\r\nContent-Type: application/xml\r\nTransfer-Encoding: chunked\r\n\r\n";
+        writeConnection (conn);
+        LOGNOTICE ("Long poll for event handler " << id << " open");
+        if (!started_)
+        {
+            started_ = true;
+            scriptStartMs_ = now;
+            for (size_t step = 0; step < script_.size (); step++)
+            {
+                Timer timer;
+                timer.kind = TIMER_SCRIPT;
+                timer.step = step;
+                schedule (scriptStartMs_ + script_[step].atMs, timer);
+            }
+            if (observer_)
+                observer_->onStart (*this, nowUs ());
+        }
+    }
+    else if (request.method == "DELETE" && request.path.compare (0, eventhandlers.size (), eventhandlers) == 0)
+    {
+        // Its long poll, if still open, ends with the reply to this
+        std::string id = request.path.substr (eventhandlers.size () + 1);
+        std::map < int, Connection >::iterator conn_iterator;
+        for (conn_iterator = connections_.begin (); conn_iterator != connections_.end (); conn_iterator++)
+        {
+            if (conn_iterator->second.longPoll == id)
+            {
+                conn_iterator->second.out += "0\r\n\r\n";
+                writeConnection (conn_iterator->second);
+                break;
+            }
+        }
+        reply (conn, 204, std::string ());
+    }
+    else if (request.method == "POST" && request.path == conferences)
+    {
+        std::string id = newId ("mockconf-");
+        reply (conn, 201, "<web_service version=\"1.0\"><conference_response identifier=\"" + id + "\" href=\"" +
+               conferences + "/" + id + "\"/></web_service>");
+    }
+    else if (request.path.compare (0, conferences.size () + 1, conferences + "/") == 0)
+    {
+        std::string id = request.path.substr (conferences.size () + 1);
+        if (request.method == "DELETE")
+        {
+            reply (conn, 204, std::string ());
+        }
+        else if (request.body.find ("<play") != std::string::npos || request.body.find ("<record") != std::string::npos)
+        {
+            const char *child = request.body.find ("<play") != std::string::npos ? "play" : "record";
+            std::string transaction = newId (child[0] == 'p' ? "mockplay-" : "mockrec-");
+            reply (conn, 200, "<web_service version=\"1.0\"><conference_response identifier=\"" + id + "\"><" + child +
+                   " transaction_id=\"" + transaction + "\"/></conference_response></web_service>");
+        }
+        else if (request.body.find ("<stop") != std::string::npos)
+        {
+            // The transaction ends, as if played or recorded out
+            std::string transaction;
+            std::string::size_type start = request.body.find ("transaction_id=\"");
+            if (start != std::string::npos)
+            {
+                start += 16;
+                transaction = request.body.substr (start, request.body.find ('"', start) - start);
+            }
+            reply (conn, 200, "<web_service version=\"1.0\"><conference_response identifier=\"" + id + "\"/></web_service>");
+            const char *type = transaction.compare (0, 8, "mockrec-") == 0 ? "end_record" : "end_play";
+            scheduleEvent (now + config_.latencyMs, pickHandler (),
+                           event (type, "conference", id) + eventData ("transaction_id", transaction) + endEvent ());
+        }
+        else
+        {
+            reply (conn, 200, "<web_service version=\"1.0\"><conference_response identifier=\"" + id + "\"/></web_service>");
+        }
+    }
+    else if (request.path.compare (0, calls.size (), calls) == 0)
+    {
+        std::string id = request.path.substr (calls.size ());
+        std::map < std::string, Call >::iterator call_iterator = calls_.find (id);
+        if (call_iterator == calls_.end ())
+        {
+            reply (conn, 404, std::string ());
+            return;
+        }
+        Call & call = call_iterator->second;
+        std::string callEnd = eventData ("call_id", id) + endEvent ();
+        if (request.body.find ("answer=\"yes\"") != std::string::npos)
+        {
+            reply (conn, 200, "<web_service version=\"1.0\"><call_response identifier=\"" + id + "\"/></web_service>");
+            scheduleEvent (now + config_.latencyMs, call.handlerId, event ("answered", "call", id) + callEnd, "answered", id);
+        }
+        else if (request.method == "DELETE" || (request.body.find ("<call_action>") != std::string::npos
+                                                && request.body.find ("_party") == std::string::npos))
+        {
+            // DELETE, or the app's hangup call_action
+            reply (conn, request.method == "DELETE" ? 204 : 200, std::string ());
+            scheduleEvent (now + config_.latencyMs, call.handlerId, event ("hangup", "call", id) + callEnd, "hangup", id);
+            calls_.erase (call_iterator);
+        }
+        else
+        {
+            // add_party, update_party
+            reply (conn, 200, "<web_service version=\"1.0\"><call_response identifier=\"" + id + "\"/></web_service>");
+        }
+    }
+    else
+    {
+        LOGWARN ("No such resource: " << request.method << " " << request.path);
+        reply (conn, 404, std::string ());
+    }
+}
+
+void
+XmsMockServer::schedule (uint64_t atMs, const Timer & timer)
+{
+    timers_.insert (std::make_pair (atMs, timer));
+}
+
+void
+XmsMockServer::scheduleEvent (uint64_t atMs, const std::string & handlerId, const std::string & xml,
+                              const char *callEvent, const std::string & callId)
+{
+    // Never ahead of the reply that causes it; equal times fire in order
+    Timer timer;
+    timer.kind = TIMER_EVENT;
+    timer.target = handlerId;
+    timer.data = xml;
+    timer.callEvent = callEvent;
+    timer.callId = callId;
+    schedule (atMs, timer);
+}
+
+void
+XmsMockServer::sendEvent (const std::string & handlerId, const std::string & xml)
+{
+    std::map < int, Connection >::iterator conn_iterator;
+    for (conn_iterator = connections_.begin (); conn_iterator != connections_.end (); conn_iterator++)
+    {
+        Connection & conn = conn_iterator->second;
+        if (conn.longPoll != handlerId)
+            continue;
+        char size[32];
+        snprintf (size, sizeof (size), "%zx\r\n", xml.size ());
+        conn.out += size;
+        conn.out += xml;
+        conn.out += "\r\n";
+        writeConnection (conn);
+        return;
+    }
+    LOGWARN ("No long poll open for event handler " << handlerId << ". Event dropped");
+}
+
+void
+XmsMockServer::fireTimer (const Timer & timer)
+{
+    std::map < int, Connection >::iterator conn_iterator;
+    switch (timer.kind)
+    {
+    case TIMER_REPLY:
+        conn_iterator = connections_.find (timer.fd);
+        if (conn_iterator == connections_.end () || conn_iterator->second.serial != timer.serial)
+            return;             // client went away meanwhile
+        conn_iterator->second.out += timer.data;
+        conn_iterator->second.waiting = false;
+        writeConnection (conn_iterator->second);
+        // The next request may already be buffered
+        if (connections_.count (timer.fd))
+            readConnection (connections_[timer.fd]);
+        break;
+
+    case TIMER_EVENT:
+        sendEvent (timer.target, timer.data);
+        if (observer_ && timer.callEvent)
+            observer_->onCallEvent (timer.callEvent, timer.callId, nowUs ());
+        break;
+
+    case TIMER_SCRIPT:
+        runScriptStep (script_[timer.step]);
+        break;
+
+    case TIMER_KEEPALIVE:
+        for (size_t i = 0; i < handlers_.size (); i++)
+            sendEvent (handlers_[i], event ("keepalive", NULL, std::string ()) + endEvent ());
+        schedule (nowMs () + config_.keepaliveSecs * 1000, timer);
+        break;
+    }
+}
+
+std::string
+XmsMockServer::placeCall (const std::string & room, const std::string & caller)
+{
+    std::string id = newId ("mockcall-");
+    Call call;
+    call.handlerId = pickHandler ();
+    calls_[id] = call;
+    sendEvent (call.handlerId, event ("incoming", "call", id) + eventData ("call_id", id) +
+               eventData ("called_uri", "sip:" + room + "@mock") + eventData ("uri", "sip:" + room + "@mock") +
+               eventData ("caller_uri", "sip:" + (caller.empty ()? "caller" + id.substr (9) : caller) + "@mock") +
+               endEvent ());
+    return id;
+}
+
+bool
+XmsMockServer::sendDtmf (const std::string & callId, const std::string & digits)
+{
+    std::map < std::string, Call >::iterator call_iterator = calls_.find (callId);
+    if (call_iterator == calls_.end ())
+        return false;
+    sendEvent (call_iterator->second.handlerId, event ("dtmf", "call", callId) + eventData ("call_id", callId) +
+               eventData ("digits", digits) + endEvent ());
+    return true;
+}
+
+bool
+XmsMockServer::sendInfo (const std::string & callId, const std::string & text)
+{
+    std::map < std::string, Call >::iterator call_iterator = calls_.find (callId);
+    if (call_iterator == calls_.end ())
+        return false;
+    sendEvent (call_iterator->second.handlerId, event ("info", "call", callId) + eventData ("call_id", callId) +
+               eventData ("content_type", "text/plain") + eventData ("content", text) + endEvent ());
+    return true;
+}
+
+bool
+XmsMockServer::hangupCall (const std::string & callId)
+{
+    std::map < std::string, Call >::iterator call_iterator = calls_.find (callId);
+    if (call_iterator == calls_.end ())
+        return false;
+    sendEvent (call_iterator->second.handlerId, event ("hangup", "call", callId) + eventData ("call_id", callId) +
+               endEvent ());
+    calls_.erase (call_iterator);
+    return true;
+}
+
+void
+XmsMockServer::sendRaw (const std::string & xml)
+{
+    sendEvent (pickHandler (), xml);
+}
+
+void
+XmsMockServer::runScriptStep (const ScriptStep & step)
+{
+    LOGDEBUG ("Script: " << step.command << " " << step.rest);
+    if (step.command == "raw")
+    {
+        sendRaw (step.rest);
+        return;
+    }
+
+    if (step.command == "call")
+    {
+        scriptCalls_.push_back (placeCall (step.args.empty ()? std::string ("default") : step.args[0],
+                                           step.args.size () > 1 ? step.args[1] : std::string ()));
+        return;
+    }
+
+    // The rest are about a scripted call, by number
+    size_t number = step.args.empty ()? 0 : strtoul (step.args[0].c_str (), NULL, 10);
+    if (number < 1 || number > scriptCalls_.size ())
+    {
+        LOGWARN ("Script " << step.command << " for unknown call " << (step.args.empty ()? "" : step.args[0]));
+        return;
+    }
+    const std::string & id = scriptCalls_[number - 1];
+    std::string text = step.rest.substr (step.args[0].size ());
+    std::string::size_type first = text.find_first_not_of (" \t");
+    text = first == std::string::npos ? std::string () : text.substr (first);
+
+    bool sent;
+    if (step.command == "dtmf")
+        sent = sendDtmf (id, text);
+    else if (step.command == "info")
+        sent = sendInfo (id, text);
+    else if (step.command == "hangup")
+        sent = hangupCall (id);
+    else
+    {
+        LOGWARN ("Unknown script command " << step.command);
+        return;
+    }
+    if (!sent)
+        LOGDEBUG ("Script " << step.command << " for call " << number << ", which is gone");
+}
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
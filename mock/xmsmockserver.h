@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+#ifndef _XMSMOCKSERVER_H
+#define _XMSMOCKSERVER_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+
+/*----------------------------------------------------------------------------*/
+
+/*!
+ * \struct XmsMockConfig
+ * How the mock server behaves.
+ */
+struct XmsMockConfig
+{
+    int port;
+    int latencyMs;              // added to every REST reply
+    int jitterMs;               // plus up to this much, uniformly
+    double errorRate;           // fraction of REST requests failed
+    int errorCode;              // HTTP status they fail with
+    int keepaliveSecs;          // 0 for none
+    std::string scriptFile;     // scripted event stream; empty for none
+};
+
+class XmsMockServer;
+
+/*!
+ * \class XmsMockObserver
+ * Drives the mock from code instead of a script, and sees what the app
+ * sends. All calls are on the server thread; times are microseconds on the
+ * monotonic clock.
+ */
+class XmsMockObserver
+{
+  public:
+    virtual ~XmsMockObserver ()
+    {
+    }
+
+    /*!
+     * The first long poll is open; events can be sent.
+     */
+    virtual void onStart (XmsMockServer & server, uint64_t nowUs) = 0;
+
+    /*!
+     * Every pass of the server loop, at least once a millisecond.
+     */
+    virtual void onTick (XmsMockServer & server, uint64_t nowUs) = 0;
+
+    /*!
+     * A REST request from the app, as it arrives.
+     */
+    virtual void onRequest (const std::string & method, const std::string & path, const std::string & body,
+                            uint64_t nowUs) = 0;
+
+    /*!
+     * The mock sent a call event of its own (answered, hangup).
+     */
+    virtual void onCallEvent (const char *type, const std::string & callId, uint64_t nowUs) = 0;
+
+    /*!
+     * Stop the server once this is true.
+     */
+    virtual bool finished () = 0;
+};
+
+/*!
+ * \class XmsMockServer
+ * Stand-in for the part of the PowerMedia XMS REST API restconfdemo uses,
+ * so the application can be driven with no media server.
+ *
+ * One thread, one poll () loop. Event handlers are long poll GETs kept
+ * open with a chunked reply; each event is one chunk. Calls, conferences
+ * and play/record transactions exist only as IDs, and the events XMS would
+ * send for them (answered, hangup, end_play, ...) are sent when the
+ * command that causes them is answered.  Every reply waits latencyMs plus
+ * jitter on a timer, and a share of them can be failed on purpose.
+ *
+ * A script file starts when the first long poll opens. Each line is
+ * "<ms> <command> <args>", ms counted from the start:
+ *   call <room> [caller]   incoming call, to sip:<room>@mock; calls are
+ *                          numbered from 1 in script order
+ *   dtmf <call> <digits>
+ *   info <call> <text>
+ *   hangup <call>          far end hangs up
+ *   raw <xml>              sent as is
+ * '#' starts a comment.
+ *
+ * An XmsMockObserver can drive the same calls from code; see CallStorm.
+ */
+class XmsMockServer
+{
+  public:
+    XmsMockServer (const XmsMockConfig & config);
+    ~XmsMockServer ();
+
+    /*!
+     * Open the listening socket and read the script.
+     */
+    bool start ();
+
+    /*!
+     * Serve until *stop is set.
+     */
+    void run (volatile int *stop);
+
+    void setObserver (XmsMockObserver * observer)
+    {
+        observer_ = observer;
+    }
+
+    static uint64_t nowUs ();
+
+    /*!
+     * Send an incoming call to sip:room@mock. Returns its call ID.
+     */
+    std::string placeCall (const std::string & room, const std::string & caller);
+
+    /*!
+     * Send an event for a call the mock placed. False if it has gone.
+     */
+    bool sendDtmf (const std::string & callId, const std::string & digits);
+    bool sendInfo (const std::string & callId, const std::string & text);
+    bool hangupCall (const std::string & callId);
+
+    /*!
+     * Send any event as is, on the next long poll in turn.
+     */
+    void sendRaw (const std::string & xml);
+
+  private:
+    XmsMockServer (const XmsMockServer &);
+    XmsMockServer & operator = (const XmsMockServer &);
+
+    struct Connection
+    {
+        int fd;
+        unsigned serial;        // tells a reused fd from the one a timer was for
+        std::string in;
+        std::string out;
+        bool waiting;           // a reply is on its timer
+        std::string longPoll;   // event handler ID, once this is a long poll
+    };
+
+    struct Call
+    {
+        std::string handlerId;  // long poll its events go to
+    };
+
+    enum TimerKind
+    { TIMER_REPLY, TIMER_EVENT, TIMER_SCRIPT, TIMER_KEEPALIVE };
+
+    struct Timer
+    {
+        Timer ()
+        {
+            kind = TIMER_REPLY;
+            fd = -1;
+            serial = 0;
+            step = 0;
+            callEvent = NULL;
+        }
+
+        TimerKind kind;
+        int fd;
+        unsigned serial;
+        std::string target;     // event handler ID for events
+        std::string data;
+        size_t step;            // script step
+        const char *callEvent;  // for the observer; NULL if not a call event
+        std::string callId;
+    };
+
+    struct ScriptStep
+    {
+        uint64_t atMs;
+        std::string command;
+        std::vector < std::string > args;
+        std::string rest;       // everything after the command
+    };
+
+    struct Request
+    {
+        std::string method;
+        std::string path;
+        std::string body;
+    };
+
+    static uint64_t nowMs ();
+
+    bool loadScript ();
+    void acceptConnection ();
+    void readConnection (Connection & conn);
+    void writeConnection (Connection & conn);
+    void closeConnection (int fd);
+    bool parseRequest (Connection & conn, Request & request);
+    void handleRequest (Connection & conn, const Request & request);
+    void reply (Connection & conn, int code, const std::string & body);
+    void fireTimer (const Timer & timer);
+    void runScriptStep (const ScriptStep & step);
+
+    void schedule (uint64_t atMs, const Timer & timer);
+    void scheduleEvent (uint64_t atMs, const std::string & handlerId, const std::string & xml,
+                        const char *callEvent = NULL, const std::string & callId = std::string ());
+    void sendEvent (const std::string & handlerId, const std::string & xml);
+    std::string pickHandler ();
+    std::string newId (const char *prefix);
+
+    static std::string event (const char *type, const char *resourceType, const std::string & resourceId);
+    static std::string eventData (const char *name, const std::string & value);
+    static std::string endEvent ();
+
+    XmsMockConfig config_;
+    XmsMockObserver *observer_;
+    bool started_;
+    int listenFd_;
+    unsigned nextSerial_;
+    unsigned nextId_;
+    unsigned nextHandler_;
+    uint64_t scriptStartMs_;
+
+    std::map < int, Connection > connections_;
+    std::multimap < uint64_t, Timer > timers_;
+
+    std::vector < std::string > handlers_;      // open long polls
+    std::map < std::string, Call > calls_;
+    std::vector < std::string > scriptCalls_;   // call IDs by script number
+    std::vector < ScriptStep > script_;
+};
+
+#endif // _XMSMOCKSERVER_H
+/* vim:ts=4:set nu:
+ * EOF
+ */
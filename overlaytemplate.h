@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+#ifndef _OVERLAYTEMPLATE_H
+#define _OVERLAYTEMPLATE_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <string.h>
+#include <string>
+#include <vector>
+#include "regionallocator.h"
+
+/*----------------------------------------------------------------------------*/
+
+// class OverlayTemplate - one region_overlays payload, compiled once.
+//
+// The pattern is the payload text with {region}, {text} and {slide} where
+// the values go. It is split once into constant segments and fields, so
+// building a payload is a few appends into the caller's buffer. Payloads
+// that depend on the region alone are rendered for every region up front
+// and just copied out. All of it is built before any thread uses it, and
+// read only after, so templates can be shared by every conference.
+
+class OverlayTemplate
+{
+  public:
+    explicit OverlayTemplate (const char *pattern)
+    {
+        bool regionOnly = true;
+        const char *pos = pattern;
+        while (*pos)
+        {
+            const char *open = strchr (pos, '{');
+            int field = open ? fieldFor (open) : -1;
+            if (field < 0)
+            {
+                // No more fields; a '{' that starts no field is text
+                const char *end = open ? open + 1 : pos + strlen (pos);
+                appendLiteral (pos, end - pos);
+                pos = end;
+                continue;
+            }
+            appendLiteral (pos, open - pos);
+            Segment segment;
+            segment.field = field;
+            segments_.push_back (segment);
+            if (field != REGION)
+                regionOnly = false;
+            pos = strchr (open, '}') + 1;
+        }
+
+        if (regionOnly)
+        {
+            byRegion_.resize (RegionAllocator::MAX_REGIONS + 1);
+            for (int region = 0; region <= RegionAllocator::MAX_REGIONS; region++)
+                render (byRegion_[region], region, NULL, 0);
+        }
+    }
+
+    /*!
+     * Append the payload for region (0 for the whole picture) to out.
+     */
+    void appendTo (std::string & out, int region, const char *text = NULL, int slide = 0) const
+    {
+        if (!byRegion_.empty () && region >= 0 && region <= RegionAllocator::MAX_REGIONS)
+            out += byRegion_[region];
+        else
+            render (out, region, text, slide);
+    }
+
+  private:
+    enum
+    { LITERAL = -1, REGION, TEXT, SLIDE };
+
+    struct Segment
+    {
+        int field;
+        std::string literal;
+    };
+
+    static int fieldFor (const char *open)
+    {
+        if (strncmp (open, "{region}", 8) == 0)
+            return REGION;
+        if (strncmp (open, "{text}", 6) == 0)
+            return TEXT;
+        if (strncmp (open, "{slide}", 7) == 0)
+            return SLIDE;
+        return -1;
+    }
+
+    void appendLiteral (const char *text, size_t length)
+    {
+        if (length == 0)
+            return;
+        if (segments_.empty () || segments_.back ().field != LITERAL)
+        {
+            Segment segment;
+            segment.field = LITERAL;
+            segments_.push_back (segment);
+        }
+        segments_.back ().literal.append (text, length);
+    }
+
+    static void appendInt (std::string & out, int value)
+    {
+        char digits[12];
+        char *end = digits + sizeof (digits);
+        char *pos = end;
+        unsigned int magnitude = value < 0 ? -(unsigned int) value : value;
+        do
+        {
+            *--pos = '0' + magnitude % 10;
+            magnitude /= 10;
+        }
+        while (magnitude);
+        if (value < 0)
+            *--pos = '-';
+        out.append (pos, end - pos);
+    }
+
+    void render (std::string & out, int region, const char *text, int slide) const
+    {
+        std::vector < Segment >::const_iterator segment_iterator;
+        for (segment_iterator = segments_.begin (); segment_iterator != segments_.end (); segment_iterator++)
+        {
+            switch (segment_iterator->field)
+            {
+            case LITERAL:
+                out += segment_iterator->literal;
+                break;
+            case REGION:
+                appendInt (out, region);
+                break;
+            case TEXT:
+                if (text)
+                    out += text;
+                break;
+            case SLIDE:
+                appendInt (out, slide);
+                break;
+            }
+        }
+    }
+
+    std::vector < Segment > segments_;
+    // Whole payload per region, when the region is the only field
+    std::vector < std::string > byRegion_;
+};
+
+#endif // _OVERLAYTEMPLATE_H
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+#ifndef _REGIONALLOCATOR_H
+#define _REGIONALLOCATOR_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------*/
+
+// class RegionAllocator - which regions (tiles) of a conference layout are
+// taken by a conferee, and which have been handled in the current pass over
+// the layout.
+//
+// Region n is bit n - 1 of a word, so finding the first free region,
+// releasing one and marking it processed are single bit operations.  The
+// layout size only decides where rotation wraps; regions past it can still
+// be handed out, as XMS keeps them for when the layout grows again.
+
+class RegionAllocator
+{
+  public:
+    // Largest XMS layout is 25 regions; one bit each
+    static const int MAX_REGIONS = 25;
+
+    RegionAllocator ()
+    {
+        setLayout (MAX_REGIONS);
+        reset ();
+    }
+
+    void reset ()
+    {
+        used_ = 0;
+        processed_ = 0;
+    }
+
+    // Number of regions in the current layout
+    void setLayout (int numRegions)
+    {
+        layoutRegions_ = numRegions;
+    }
+
+    int getLayout () const
+    {
+        return layoutRegions_;
+    }
+
+    // Take the lowest free region. Returns 0 if all are taken.
+    int acquire ()
+    {
+        uint32_t available = ~used_ & ALL_REGIONS;
+        if (!available)
+            return 0;
+        int bit = __builtin_ctz (available);
+        used_ |= 1u << bit;
+        return bit + 1;
+    }
+
+    void set (int region)
+    {
+        used_ |= bit (region);
+    }
+
+    void release (int region)
+    {
+        used_ &= ~bit (region);
+    }
+
+    bool isUsed (int region) const
+    {
+        return (used_ & bit (region)) != 0;
+    }
+
+    int numUsed () const
+    {
+        return __builtin_popcount (used_);
+    }
+
+    // Highest region taken, or 0 if none
+    int highestUsed () const
+    {
+        return used_ ? 32 - __builtin_clz (used_) : 0;
+    }
+
+    void setProcessed (int region)
+    {
+        processed_ |= bit (region);
+    }
+
+    bool isProcessed (int region) const
+    {
+        return (processed_ & bit (region)) != 0;
+    }
+
+    void setAllProcessed ()
+    {
+        processed_ = ALL_REGIONS;
+    }
+
+    void clearAllProcessed ()
+    {
+        processed_ = 0;
+    }
+
+    bool isMaxForLayout (int region) const
+    {
+        return region == layoutRegions_;
+    }
+
+    // Region after this one when rotating conferees, wrapping at the
+    // layout size
+    int nextInLayout (int region) const
+    {
+        if (layoutRegions_ <= 1)
+            return 0;
+        return (region == layoutRegions_ || region >= MAX_REGIONS) ? 1 : region + 1;
+    }
+
+  private:
+    static const uint32_t ALL_REGIONS = (1u << MAX_REGIONS) - 1;
+
+    static uint32_t bit (int region)
+    {
+        return (region >= 1 && region <= MAX_REGIONS) ? 1u << (region - 1) : 0;
+    }
+
+    uint32_t used_;
+    uint32_t processed_;
+    int layoutRegions_;
+};
+
+#endif // _REGIONALLOCATOR_H
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,549 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sstream>
+
+#include "logger.h"
+#include "restdispatcher.h"
+#include "curlhandlepool.h"
+#include "xmsnodepool.h"
+#include "latencystats.h"
+#include "eventtrace.h"
+
+/*----------------------------------------------------------------------------*/
+
+RestDispatcher *
+    RestDispatcher::pInstance_ = NULL;
+
+/*
+ * ctor
+ */
+RestDispatcher::RestDispatcher ()
+{
+    multi_ = NULL;
+    running_ = false;
+    stopping_ = false;
+    abortAt_ = 0;
+    lastStallCheck_ = 0;
+    sink_ = false;
+    sinkIds_ = 0;
+    wakeupPipe_[0] = wakeupPipe_[1] = -1;
+    pthread_mutex_init (&submitLock_, NULL);
+}
+
+/*
+ * dtor
+ */
+RestDispatcher::~RestDispatcher ()
+{
+    stop ();
+    pthread_mutex_destroy (&submitLock_);
+}
+
+bool
+RestDispatcher::start ()
+{
+    if (running_)
+        return true;
+
+    multi_ = curl_multi_init ();
+    if (!multi_)
+    {
+        LOGCRIT ("curl_multi_init failed. REST dispatcher not started");
+        return false;
+    }
+
+    // Self-pipe, so submit() can break the dispatcher out of curl_multi_wait()
+    if (pipe (wakeupPipe_) != 0)
+    {
+        LOGCRIT ("Cannot create REST dispatcher wakeup pipe");
+        curl_multi_cleanup (multi_);
+        multi_ = NULL;
+        return false;
+    }
+    fcntl (wakeupPipe_[0], F_SETFL, O_NONBLOCK | fcntl (wakeupPipe_[0], F_GETFL));
+    fcntl (wakeupPipe_[1], F_SETFL, O_NONBLOCK | fcntl (wakeupPipe_[1], F_GETFL));
+
+    stopping_ = false;
+    running_ = true;
+    if (pthread_create (&thread_, NULL, dispatcherThread, (void *) this))
+    {
+        LOGCRIT ("Cannot create REST dispatcher thread");
+        running_ = false;
+        return false;
+    }
+    LOGDEBUG ("REST dispatcher thread created");
+    return true;
+}
+
+static time_t
+monotonicSeconds ()
+{
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    return now.tv_sec;
+}
+
+void
+RestDispatcher::abortAfter (int seconds)
+{
+    pthread_mutex_lock (&submitLock_);
+    time_t at = monotonicSeconds () + seconds;
+    if (!abortAt_ || at < abortAt_)
+        abortAt_ = at;
+    pthread_mutex_unlock (&submitLock_);
+    wakeup ();
+}
+
+void
+RestDispatcher::stop ()
+{
+    if (!running_)
+        return;
+
+    abortAfter (STOP_GRACE_SECS);
+    pthread_mutex_lock (&submitLock_);
+    stopping_ = true;
+    pthread_mutex_unlock (&submitLock_);
+    wakeup ();
+    pthread_join (thread_, NULL);
+    running_ = false;
+
+    curl_multi_cleanup (multi_);
+    multi_ = NULL;
+    close (wakeupPipe_[0]);
+    close (wakeupPipe_[1]);
+    wakeupPipe_[0] = wakeupPipe_[1] = -1;
+    LOGDEBUG ("REST dispatcher stopped");
+}
+
+void
+RestDispatcher::submit (const char *method, const std::string & resourceKey, const std::string & url,
+                        const std::string & body, RestCompletionCallback callback, void *userp, int node,
+                        const char *operation)
+{
+    if (!running_)
+    {
+        LOGERROR ("REST dispatcher not running. " << method << " to " << url << " not sent");
+        if (callback)
+        {
+            RestResult result;
+            result.curlCode = CURLE_FAILED_INIT;
+            result.respCode = 0;
+            result.success = false;
+            callback (result, userp);
+        }
+        return;
+    }
+
+    RestRequest *request = new RestRequest;
+    request->method = method;
+    request->resourceKey = resourceKey;
+    request->url = url;
+    request->body = body;
+    request->callback = callback;
+    request->userp = userp;
+    request->node = node;
+    request->operation = operation;
+    request->traceId = EventTrace::currentTrace ();
+    request->submittedUs = EventTrace::now ();
+    request->curl = NULL;
+
+    pthread_mutex_lock (&submitLock_);
+    submitted_.push_back (request);
+    pthread_mutex_unlock (&submitLock_);
+    wakeup ();
+}
+
+void *
+RestDispatcher::dispatcherThread (void *voidPtr)
+{
+    ((RestDispatcher *) voidPtr)->run ();
+    return NULL;
+}
+
+size_t
+RestDispatcher::replyCallback (void *contents, size_t size, size_t nmemb, void *userp)
+{
+    std::string *reply = (std::string *) userp;
+    reply->append ((const char *) contents, size * nmemb);
+    return size * nmemb;
+}
+
+void
+RestDispatcher::wakeup ()
+{
+    char c = 0;
+    if (write (wakeupPipe_[1], &c, 1) < 0)
+    {
+        // Pipe full - the dispatcher already has a wakeup pending
+    }
+}
+
+void
+RestDispatcher::drainWakeupPipe ()
+{
+    char buf[64];
+    while (read (wakeupPipe_[0], buf, sizeof (buf)) > 0)
+        ;
+}
+
+bool
+RestDispatcher::isIdle ()
+{
+    // pending_ belongs to the dispatcher thread; only submitted_ is shared
+    bool idle;
+    pthread_mutex_lock (&submitLock_);
+    idle = submitted_.empty ();
+    pthread_mutex_unlock (&submitLock_);
+    return idle && pending_.empty ();
+}
+
+RestResult
+RestDispatcher::sinkResult (const RestRequest * request)
+{
+    RestResult result;
+    result.curlCode = CURLE_OK;
+    result.success = true;
+    result.respCode = 200;
+    if (request->method == "POST")
+        result.respCode = 201;
+    else if (request->method == "DELETE")
+        result.respCode = 204;
+
+    // The app only reads IDs from replies: a new conference, or a play or
+    // record transaction
+    std::ostringstream content;
+    const char *child = NULL;
+    if (request->body.find ("<play") != std::string::npos)
+        child = "play";
+    else if (request->body.find ("<record") != std::string::npos)
+        child = "record";
+    if (request->method == "POST")
+        content << "<web_service version=\"1.0\"><conference_response identifier=\"sink-" << ++sinkIds_ <<
+            "\"/></web_service>";
+    else if (child)
+        content << "<web_service version=\"1.0\"><conference_response><" << child << " transaction_id=\"sink-" <<
+            ++sinkIds_ << "\"/></conference_response></web_service>";
+    result.content = content.str ();
+    return result;
+}
+
+bool
+RestDispatcher::startRequest (RestRequest * request)
+{
+    if (sink_)
+    {
+        LOGDEBUG ("Sink " << request->method << " to " << request->url);
+        completeRequest (request, sinkResult (request));
+        return false;
+    }
+
+    CURL *curl = CurlHandlePool::Instance ()->checkout ();
+    if (!curl)
+    {
+        LOGERROR ("No cURL handle available for " << request->method << " to " << request->url);
+        // Completes at once with a failure; keeps the resource queue moving
+        RestResult result;
+        result.curlCode = CURLE_FAILED_INIT;
+        result.respCode = 0;
+        result.success = false;
+        completeRequest (request, result);
+        return false;
+    }
+
+    curl_easy_setopt (curl, CURLOPT_URL, request->url.c_str ());
+    curl_easy_setopt (curl, CURLOPT_CONNECTTIMEOUT, CONNECT_TIMEOUT_SECS);
+    curl_easy_setopt (curl, CURLOPT_TIMEOUT, REQUEST_TIMEOUT_SECS);
+    curl_easy_setopt (curl, CURLOPT_WRITEFUNCTION, replyCallback);
+    curl_easy_setopt (curl, CURLOPT_WRITEDATA, (void *) &request->reply);
+
+    if (request->method != "POST")
+    {
+        curl_easy_setopt (curl, CURLOPT_HTTPHEADER, CurlHandlePool::Instance ()->xmlHeaders ());
+        curl_easy_setopt (curl, CURLOPT_CUSTOMREQUEST, request->method.c_str ());
+    }
+    if (request->method != "DELETE")
+    {
+        // Content-Length is set by cURL from POSTFIELDSIZE
+        curl_easy_setopt (curl, CURLOPT_POSTFIELDS, request->body.c_str ());
+        curl_easy_setopt (curl, CURLOPT_POSTFIELDSIZE, (long) request->body.size ());
+    }
+
+    LOGDEBUG ("Sending HTTP " << request->method << " via Curl using URL " << request->url);
+    if (!request->body.empty ())
+        LOGDEBUG ("Content of " << request->method << " is " << request->body);
+
+    request->curl = curl;
+    clock_gettime (CLOCK_MONOTONIC, &request->started);
+    inFlight_[curl] = request;
+    curl_multi_add_handle (multi_, curl);
+    return true;
+}
+
+void
+RestDispatcher::finishRequest (CURL * curl, CURLcode curlCode)
+{
+    RestResult result;
+
+    curl_multi_remove_handle (multi_, curl);
+    std::map < CURL *, RestRequest * >::iterator flight_iterator = inFlight_.find (curl);
+    if (flight_iterator == inFlight_.end ())
+    {
+        LOGERROR ("Completed cURL handle is not an in flight REST request");
+        CurlHandlePool::Instance ()->checkin (curl);
+        return;
+    }
+    RestRequest *request = flight_iterator->second;
+    inFlight_.erase (flight_iterator);
+
+    result.curlCode = curlCode;
+    result.respCode = 0;
+    result.success = false;
+
+    if (curlCode != CURLE_OK)
+    {
+        LOGERROR ("curl_easy_perform() for " << request->method << " failed: " << curl_easy_strerror (curlCode));
+    }
+    else
+    {
+        curl_easy_getinfo (curl, CURLINFO_RESPONSE_CODE, &result.respCode);
+        LOGDEBUG ("Response code to " << request->method << " is " << result.respCode);
+
+        long expected = 200;
+        if (request->method == "POST")
+            expected = 201;
+        else if (request->method == "DELETE")
+            expected = 204;           // 204 is success for DELETE. No content is returned with it
+
+        if (result.respCode == expected)
+        {
+            result.success = true;
+            result.content = request->reply;
+            if (!request->reply.empty ())
+                LOGDEBUG (request->method << " reply is " << request->reply);
+        }
+        else if (result.respCode >= 400 && result.respCode <= 499)
+        {
+            LOGWARN ("400 series response to " << request->method << " - " << result.respCode);
+        }
+        else
+        {
+            LOGERROR (request->method << " for " << request->url << " was not successful");
+        }
+    }
+    CurlHandlePool::Instance ()->checkin (curl);
+
+    // The caller waited from submit, queueing behind earlier requests on
+    // the resource included; the node only answers for the round trip
+    struct timespec now;
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    uint64_t nowUs = EventTrace::toMicroseconds (now);
+    uint64_t startedUs = EventTrace::toMicroseconds (request->started);
+    long latencyUs = (long) (nowUs - startedUs);
+    const char *operation = request->operation ? request->operation : request->method.c_str ();
+    LatencyStats::Instance ()->record (operation, result.respCode, nowUs - request->submittedUs, !result.success);
+    if (request->traceId)
+    {
+        // Time behind earlier requests on the resource, then the round trip
+        std::ostringstream status;
+        status << request->resourceKey << " status " << result.respCode;
+        EventTrace::Instance ()->span ("queued", "rest", request->traceId, request->submittedUs, startedUs,
+                                       request->resourceKey);
+        EventTrace::Instance ()->span (operation, "rest", request->traceId, startedUs,
+                                       nowUs, status.str ());
+    }
+    if (request->node >= 0)
+    {
+        // A timeout or a refused connection is the server's fault, as is a
+        // 5xx; a 4xx is the request's
+        XmsNodePool::Instance ()->recordResult (request->node, latencyUs, curlCode != CURLE_OK || result.respCode >= 500);
+    }
+
+    completeRequest (request, result);
+}
+
+void
+RestDispatcher::completeRequest (RestRequest * request, const RestResult & result)
+{
+    if (request->callback)
+        request->callback (result, request->userp);
+
+    // Head of its resource queue is done; the next one may go
+    std::deque < RestRequest * >&queue = pending_[request->resourceKey];
+    queue.pop_front ();
+    if (queue.empty ())
+        pending_.erase (request->resourceKey);
+    delete request;
+}
+
+void
+RestDispatcher::takeSubmitted ()
+{
+    // Move newly submitted requests onto their resource queues
+    std::vector < RestRequest * >submitted;
+    pthread_mutex_lock (&submitLock_);
+    submitted.swap (submitted_);
+    pthread_mutex_unlock (&submitLock_);
+    std::vector < RestRequest * >::iterator submit_iterator;
+    for (submit_iterator = submitted.begin (); submit_iterator != submitted.end (); submit_iterator++)
+    {
+        pending_[(*submit_iterator)->resourceKey].push_back (*submit_iterator);
+    }
+}
+
+bool
+RestDispatcher::scheduleReady ()
+{
+    takeSubmitted ();
+
+    // Any resource with nothing in flight starts its oldest request
+    std::vector < RestRequest * >ready;
+    std::map < std::string, std::deque < RestRequest * > >::iterator pending_iterator;
+    for (pending_iterator = pending_.begin (); pending_iterator != pending_.end (); pending_iterator++)
+    {
+        RestRequest *head = pending_iterator->second.front ();
+        if (head->curl == NULL)
+            ready.push_back (head);
+    }
+    // Requests that complete without going on the wire say so, as the
+    // next one on their resource is now ready too
+    bool completedAny = false;
+    std::vector < RestRequest * >::iterator ready_iterator;
+    for (ready_iterator = ready.begin (); ready_iterator != ready.end (); ready_iterator++)
+    {
+        if (!startRequest (*ready_iterator))
+            completedAny = true;
+    }
+    return completedAny;
+}
+
+void
+RestDispatcher::abortAll ()
+{
+    // Fail every request, in flight or queued, head first so each
+    // completes in its resource's order. Callbacks may submit more, which
+    // are failed too.
+    RestResult result;
+    result.curlCode = CURLE_ABORTED_BY_CALLBACK;
+    result.respCode = 0;
+    result.success = false;
+    unsigned long aborted = 0;
+    takeSubmitted ();
+    while (!pending_.empty ())
+    {
+        RestRequest *head = pending_.begin ()->second.front ();
+        if (head->curl)
+        {
+            curl_multi_remove_handle (multi_, head->curl);
+            inFlight_.erase (head->curl);
+            CurlHandlePool::Instance ()->checkin (head->curl);
+            head->curl = NULL;
+        }
+        completeRequest (head, result);
+        aborted++;
+        takeSubmitted ();
+    }
+    if (aborted)
+        LOGWARN ("Shutting down. Failed " << aborted << " REST requests not sent or not answered in time");
+}
+
+void
+RestDispatcher::checkStalled ()
+{
+    // Once a second: tell the pool how many requests each node is sitting on
+    time_t now = monotonicSeconds ();
+    if (now == lastStallCheck_)
+        return;
+    lastStallCheck_ = now;
+
+    std::vector < int >stalled (XmsNodePool::Instance ()->size (), 0);
+    std::map < CURL *, RestRequest * >::const_iterator flight_iterator;
+    for (flight_iterator = inFlight_.begin (); flight_iterator != inFlight_.end (); flight_iterator++)
+    {
+        const RestRequest *request = flight_iterator->second;
+        if (request->node >= 0 && request->node < (int) stalled.size () &&
+            now - request->started.tv_sec >= XmsNodePool::STALLED_SECS)
+            stalled[request->node]++;
+    }
+    for (size_t node = 0; node < stalled.size (); node++)
+        XmsNodePool::Instance ()->setStalledRequests (node, stalled[node]);
+}
+
+void
+RestDispatcher::run ()
+{
+    LOGDEBUG ("REST dispatcher running");
+    while (true)
+    {
+        if (scheduleReady ())
+            continue;
+
+        int stillRunning = 0;
+        curl_multi_perform (multi_, &stillRunning);
+
+        bool finishedAny = false;
+        int msgsLeft;
+        CURLMsg *msg;
+        while ((msg = curl_multi_info_read (multi_, &msgsLeft)) != NULL)
+        {
+            if (msg->msg == CURLMSG_DONE)
+            {
+                finishRequest (msg->easy_handle, msg->data.result);
+                finishedAny = true;
+            }
+        }
+        // A completed request may have unblocked the next one on its resource
+        if (finishedAny)
+            continue;
+
+        pthread_mutex_lock (&submitLock_);
+        bool stopping = stopping_;
+        time_t abortAt = abortAt_;
+        pthread_mutex_unlock (&submitLock_);
+        if (abortAt && monotonicSeconds () >= abortAt)
+            abortAll ();
+        checkStalled ();
+        if (stopping && isIdle ())
+            break;
+
+        struct curl_waitfd wakeupFd;
+        wakeupFd.fd = wakeupPipe_[0];
+        wakeupFd.events = CURL_WAIT_POLLIN;
+        wakeupFd.revents = 0;
+        int numFds;
+        // At most a second, so abortAt_ is noticed without a wakeup
+        curl_multi_wait (multi_, &wakeupFd, 1, 1000, &numFds);
+        if (wakeupFd.revents)
+            drainWakeupPipe ();
+    }
+    LOGDEBUG ("REST dispatcher thread exiting");
+}
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+#ifndef _RESTDISPATCHER_H
+#define _RESTDISPATCHER_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <string>
+#include <deque>
+#include <map>
+#include <vector>
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+#include <curl/curl.h>
+
+/*----------------------------------------------------------------------------*/
+
+/*!
+ * Outcome of one REST request, handed to the completion callback.
+ */
+struct RestResult
+{
+    CURLcode curlCode;
+    long respCode;
+    bool success;               // cURL OK and the expected 2xx for the method
+    std::string content;
+};
+
+/*!
+ * Completion callback. Runs on the dispatcher thread, so it must be short
+ * and must never wait on another REST request.
+ */
+typedef void (*RestCompletionCallback) (const RestResult & result, void *userp);
+
+/*!
+ * \class RestWaiter
+ * Lets a caller block until an asynchronous request completes. Pass
+ * RestWaiter::complete as the callback and the waiter as userp.
+ */
+class RestWaiter
+{
+  public:
+    RestWaiter ()
+    {
+        done_ = false;
+        pthread_mutex_init (&lock_, NULL);
+        pthread_cond_init (&cond_, NULL);
+    }
+
+    ~RestWaiter ()
+    {
+        pthread_cond_destroy (&cond_);
+        pthread_mutex_destroy (&lock_);
+    }
+
+    static void complete (const RestResult & result, void *userp)
+    {
+        RestWaiter *waiter = (RestWaiter *) userp;
+        pthread_mutex_lock (&waiter->lock_);
+        waiter->result_ = result;
+        waiter->done_ = true;
+        pthread_cond_signal (&waiter->cond_);
+        pthread_mutex_unlock (&waiter->lock_);
+    }
+
+    const RestResult & wait ()
+    {
+        pthread_mutex_lock (&lock_);
+        while (!done_)
+            pthread_cond_wait (&cond_, &lock_);
+        pthread_mutex_unlock (&lock_);
+        return result_;
+    }
+
+  private:
+    RestWaiter (const RestWaiter &);
+    RestWaiter & operator = (const RestWaiter &);
+
+    bool done_;
+    RestResult result_;
+    pthread_mutex_t lock_;
+    pthread_cond_t cond_;
+};
+
+/*!
+ * \class RestDispatcher
+ * Sends REST requests to XMS from a dedicated thread using curl_multi, so
+ * many requests can be in flight at once and the caller never waits on a
+ * round trip.  Requests on the same resource (call or conference) are sent
+ * strictly in submission order: a resource only has one request in flight
+ * at a time.  Every transfer has a connect and a total timeout, so a
+ * server that stops answering fails the request rather than holding up its
+ * resource for ever.  The class is a singleton.
+ */
+class RestDispatcher
+{
+  public:
+    static const long CONNECT_TIMEOUT_SECS = 5;
+    static const long REQUEST_TIMEOUT_SECS = 15;
+
+    // How long stop() lets queued requests go out before failing them
+    static const int STOP_GRACE_SECS = 5;
+
+    /*!
+     * dtor.
+     */
+    ~RestDispatcher ();
+
+    static RestDispatcher *Instance ()
+    {
+        if (!pInstance_)
+            pInstance_ = new RestDispatcher;
+
+        return pInstance_;
+    }
+
+    /*!
+     * Start the dispatcher thread. Call once, after curl_global_init().
+     */
+    bool start ();
+
+    /*!
+     * From seconds from now, fail every request still queued or in flight,
+     * and any submitted later, with CURLE_ABORTED_BY_CALLBACK. For
+     * shutdown, so a server that stops answering cannot hold it up.
+     */
+    void abortAfter (int seconds);
+
+    /*!
+     * Send what is still queued, then stop the dispatcher thread. Unless
+     * abortAfter() set an earlier time, requests not done within
+     * STOP_GRACE_SECS are failed.
+     */
+    void stop ();
+
+    /*!
+     * Answer every request at once with success instead of sending it,
+     * for replaying recorded events with no XMS. Call before start().
+     */
+    void setSink (bool sink)
+    {
+        sink_ = sink;
+    }
+
+    /*!
+     * Queue a request.
+     * \param method - "POST", "PUT" or "DELETE".
+     * \param resourceKey - requests with the same key are kept in order.
+     * \param url - full request URL.
+     * \param body - XML content; empty for DELETE.
+     * \param callback - optional completion callback.
+     * \param userp - passed through to the callback.
+     * \param node - XMS node the url points at, for its latency and error
+     * figures; -1 for none.
+     * \param operation - name the latency is recorded under; a string
+     * literal, as it is kept until the request completes. NULL for the
+     * method.
+     */
+    void submit (const char *method, const std::string & resourceKey, const std::string & url,
+                 const std::string & body, RestCompletionCallback callback, void *userp, int node = -1,
+                 const char *operation = NULL);
+
+  private:
+    /*!
+     * ctor. Hide here as class is a singleton
+     */
+    RestDispatcher ();
+
+    struct RestRequest
+    {
+        std::string method;
+        std::string resourceKey;
+        std::string url;
+        std::string body;
+        RestCompletionCallback callback;
+        void *userp;
+        int node;
+        const char *operation;
+        uint64_t traceId;           // EventTrace of the event that sent it
+        uint64_t submittedUs;
+        CURL *curl;
+        struct timespec started;
+        std::string reply;
+    };
+
+    static void *dispatcherThread (void *voidPtr);
+    static size_t replyCallback (void *contents, size_t size, size_t nmemb, void *userp);
+    void run ();
+    void wakeup ();
+    void drainWakeupPipe ();
+    bool startRequest (RestRequest * request);
+    RestResult sinkResult (const RestRequest * request);
+    void finishRequest (CURL * curl, CURLcode curlCode);
+    void completeRequest (RestRequest * request, const RestResult & result);
+    void takeSubmitted ();
+    bool scheduleReady ();
+    void abortAll ();
+    void checkStalled ();
+    bool isIdle ();
+
+    static RestDispatcher *pInstance_;
+
+    CURLM *multi_;
+    pthread_t thread_;
+    bool running_;
+    bool stopping_;
+    time_t abortAt_;            // CLOCK_MONOTONIC seconds, 0 for never
+    bool sink_;
+    unsigned long sinkIds_;
+    int wakeupPipe_[2];
+
+    // Submitted but not yet sorted into per-resource queues. Also guards
+    // stopping_ and abortAt_
+    pthread_mutex_t submitLock_;
+    std::vector < RestRequest * >submitted_;
+
+    // Dispatcher thread only
+    std::map < std::string, std::deque < RestRequest * > >pending_;
+    std::map < CURL *, RestRequest * >inFlight_;
+    time_t lastStallCheck_;
+};
+
+
+#endif // _RESTDISPATCHER_H
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <map>
+
+#include "getoption.h"
+#include "logger.h"
+#include "conferencemanager.h"
+#include "conference720p.h"
+#include "xmssim.h"
+
+/*----------------------------------------------------------------------------*/
+
+// restconfdemo_sim - run the conference logic against a simulated XMS
+// under a virtual clock, and count the REST commands it issues.
+//
+// Each scenario is a seeded stream of callers dialling into a set of
+// rooms. Each caller stays a while, presses DTMF keys or clicks on the
+// layout, then hangs up. Events go straight into a ConferenceManager with
+// no threads or sockets, so the handler cost per event is measured on its
+// own. The REST commands issued are counted per operation.
+//
+// With --check, a scenario that issues more commands of any kind than its
+// budget fails, and the exit status is 1. make check runs it this way.
+// Budgets are for the default seed and scale; a change that makes the app
+// chattier has to raise them on purpose.
+
+/*------------------------------ Scenarios -----------------------------------*/
+
+struct Scenario
+{
+    const char *name;
+    unsigned calls;
+    unsigned rooms;
+    unsigned arrivalMs;         // mean gap between callers
+    unsigned holdSecs;          // mean time each stays
+    unsigned actions;           // mean DTMF keys and clicks per caller
+    const char *digits;         // keys are drawn from these, equally likely
+    unsigned clickPercent;      // share of actions that are clicks
+    const char *budget;         // "operation=max ..." at the default seed and scale
+};
+
+static const Scenario scenarios[] = {
+    {"join_leave", 400, 40, 250, 60, 0, "", 0,
+     "answer=400 add_party=400 create_conference=40 destroy_conference=40"},
+    {"clicks", 300, 30, 250, 90, 6, "", 100,
+     "answer=300 add_party=300 create_conference=30 destroy_conference=30 "
+     "update_conference=840 update_party=363"},
+    {"layouts", 300, 30, 250, 90, 4, "#*90", 0,
+     "answer=300 add_party=300 create_conference=30 destroy_conference=30 "
+     "update_conference=1363 update_party=2610"},
+    {"overlays", 300, 30, 250, 90, 4, "BEFG", 0,
+     "answer=300 add_party=300 create_conference=30 destroy_conference=30 "
+     "update_conference=1020"},
+    {"media", 300, 30, 250, 90, 3, "12345678C", 0,
+     "answer=300 add_party=300 create_conference=30 destroy_conference=30 "
+     "update_conference=98 play_into_conf=317 record_conference=53 stop=166"},
+    {"mixed", 2000, 100, 100, 120, 5, "##**90BEFG12345678CD", 30,
+     "answer=2000 add_party=2000 hangup=1490 create_conference=236 destroy_conference=236 "
+     "update_conference=4594 update_party=3415 play_into_conf=688 record_conference=138 stop=272"},
+};
+
+static const uint64_t DEFAULT_SEED = 1;
+
+// Media files are all there, so every play can happen
+static int
+allFilesExist (const char *filename)
+{
+    return 1;
+}
+
+// One caller: arrival, what they do while in the room, and leaving
+static void
+postCall (const Scenario & scenario, unsigned index, uint64_t atUs)
+{
+    XmsSim *sim = XmsSim::Instance ();
+    SimRandom & random = sim->random ();
+
+    char callId[32], room[32];
+    snprintf (callId, sizeof (callId), "simcall-%u", index);
+    snprintf (room, sizeof (room), "room%u", (unsigned) random.below (scenario.rooms));
+
+    sim->post (atUs, XmsSim::event ("incoming", "call", callId) + XmsSim::eventData ("call_id", callId) +
+               XmsSim::eventData ("called_uri", std::string ("sip:") + room + "@sim") +
+               XmsSim::eventData ("caller_uri", std::string ("sip:") + callId + "@sim") + XmsSim::endEvent ());
+
+    uint64_t holdUs = (scenario.holdSecs * 500 + random.below (scenario.holdSecs * 1000 + 1)) * 1000ULL;
+    unsigned actions = random.below (2 * scenario.actions + 1);
+    for (unsigned action = 0; action < actions; action++)
+    {
+        // After the answer has had time to come back
+        uint64_t actionUs = atUs + 1000000 + random.below (holdUs > 1000000 ? holdUs - 1000000 : 1);
+        if (random.below (100) < scenario.clickPercent)
+        {
+            std::ostringstream click;
+            click << "CLICK " << random.below (1280) << " " << random.below (720) << " " <<
+                (random.below (2) ? "mute" : "hide") << " " << (random.below (2) ? "controller" : "sim");
+            sim->post (actionUs, XmsSim::event ("info", "call", callId) + XmsSim::eventData ("call_id", callId) +
+                       XmsSim::eventData ("content_type", "text/plain") + XmsSim::eventData ("content", click.str ()) +
+                       XmsSim::endEvent (), callId);
+        }
+        else if (scenario.digits[0])
+        {
+            std::string digit (1, scenario.digits[random.below (strlen (scenario.digits))]);
+            sim->post (actionUs, XmsSim::event ("dtmf", "call", callId) + XmsSim::eventData ("call_id", callId) +
+                       XmsSim::eventData ("digits", digit) + XmsSim::endEvent (), callId);
+        }
+    }
+
+    sim->post (atUs + holdUs, XmsSim::event ("hangup", "call", callId) + XmsSim::eventData ("call_id", callId) +
+               XmsSim::endEvent (), callId);
+}
+
+// Prints the scenario's figures; returns the number of operations over budget
+static int
+runScenario (const Scenario & scenario, unsigned scale, uint64_t seed, bool check)
+{
+    XmsSim *sim = XmsSim::Instance ();
+    sim->reset (seed);
+
+    unsigned long events = 0;
+    {
+        ConferenceManager conferences ("sipinfo");
+        uint64_t atUs = 0;
+        unsigned calls = scenario.calls * scale;
+        for (unsigned index = 0; index < calls; index++)
+        {
+            // Only what is due before the next caller is queued, so the
+            // queue stays the size of the calls in progress
+            atUs += sim->random ().below (2 * scenario.arrivalMs * 1000 + 1);
+            events += sim->run (conferences, atUs);
+            postCall (scenario, index, atUs);
+        }
+        events += sim->run (conferences, (uint64_t) -1);
+    }                           // rooms still open are torn down here
+
+    unsigned long commands = 0;
+    XmsSim::Counters::const_iterator counter_iterator;
+    for (counter_iterator = sim->counters ().begin (); counter_iterator != sim->counters ().end (); counter_iterator++)
+        commands += counter_iterator->second.count;
+
+    printf ("%-12s %8u %10lu %10lu %10.2f %10.0f %12.1f\n", scenario.name, scenario.calls * scale, events, commands,
+            events ? (double) commands / events : 0.0, events ? (double) sim->handlerNs () / events : 0.0,
+            sim->now () / 1000000.0);
+
+    std::map < std::string, unsigned long >budget;
+    std::istringstream budgetList (scenario.budget);
+    std::string entry;
+    while (budgetList >> entry)
+    {
+        std::string::size_type equals = entry.find ('=');
+        if (equals != std::string::npos)
+            budget[entry.substr (0, equals)] = strtoul (entry.c_str () + equals + 1, NULL, 10);
+    }
+    bool checking = check && scale == 1 && seed == DEFAULT_SEED;
+    int over = 0;
+    for (counter_iterator = sim->counters ().begin (); counter_iterator != sim->counters ().end (); counter_iterator++)
+    {
+        const std::string & operation = counter_iterator->first;
+        unsigned long count = counter_iterator->second.count;
+        printf ("    %-20s %8lu %12lu bytes", operation.c_str (), count, counter_iterator->second.bytes);
+        if (checking)
+        {
+            unsigned long allowed = budget.count (operation) ? budget[operation] : 0;
+            if (count > allowed)
+            {
+                printf ("   OVER BUDGET of %lu", allowed);
+                over++;
+            }
+            else if (count < allowed)
+                printf ("   under budget of %lu; lower it", allowed);
+        }
+        printf ("\n");
+    }
+    return over;
+}
+
+/*!
+ * Entry point. See the comment at the top.
+ */
+int
+main (int argc, char *argv[])
+{
+    GetOptions opts;
+    opts.addOptionNoArg ('h', "help", "Display this information.");
+    opts.addOptionNoArg ('v', "verbose", "Log everything the application does.");
+    opts.addOptionNoArg ('c', "check", "Fail if a scenario issues more REST commands than its budget");
+    opts.addOptionRequiredArg ('s', "scenario", "Run the scenarios whose name contains this");
+    opts.addOptionRequiredArg ('x', "scale", "Multiply each scenario's callers by this (default 1)");
+    opts.addOptionRequiredArg ('S', "seed", "Random seed (default 1)");
+    opts.parseOptions (argc, argv);
+
+    if (opts.isFound ("help"))
+    {
+        std::cout << "Command line options:" << std::endl << opts << std::endl;
+        exit (0);
+    }
+
+    Logger::instance ().setLevel (opts.isFound ("verbose") ? Logger::LOGLEVEL_DEBUG : Logger::LOGLEVEL_ERR);
+    Logger::instance ().attachAppender (new ConsoleAppender);
+    Conference720p::setFileCheck (allFilesExist);
+
+    std::string filter = opts.getValue ("scenario");
+    unsigned scale = opts.isFound ("scale") ? strtoul (opts.getValue ("scale").c_str (), NULL, 10) : 1;
+    uint64_t seed = opts.isFound ("seed") ? strtoull (opts.getValue ("seed").c_str (), NULL, 10) : DEFAULT_SEED;
+    bool check = opts.isFound ("check");
+    if (scale < 1)
+        scale = 1;
+    if (check && (scale != 1 || seed != DEFAULT_SEED))
+        printf ("Budgets are for the default seed and scale; not checking\n");
+
+    printf ("%-12s %8s %10s %10s %10s %10s %12s\n", "scenario", "calls", "events", "commands", "cmd/event",
+            "ns/event", "virtual s");
+    int over = 0;
+    for (size_t i = 0; i < sizeof (scenarios) / sizeof (scenarios[0]); i++)
+    {
+        if (strstr (scenarios[i].name, filter.c_str ()))
+            over += runScenario (scenarios[i], scale, seed, check);
+    }
+    if (over)
+    {
+        printf ("%d operation counts over budget\n", over);
+        return 1;
+    }
+    return 0;
+}
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include "dispatchxmscmd.h"
+#include "xmscmds.h"
+#include "xmssim.h"
+
+/*----------------------------------------------------------------------------*/
+
+// The functions of dispatchxmscmd.cpp, for the simulator. Each builds its
+// command body as the real one does, so that cost is still in the handler,
+// then counts it under the operation name LatencyStats uses and tells
+// XmsSim what XMS would do next. Functions that send nothing in the real
+// application send nothing here either.
+
+static void
+complete (RestCompletionCallback callback, void *userp)
+{
+    if (!callback)
+        return;
+    RestResult result;
+    result.curlCode = CURLE_OK;
+    result.respCode = 200;
+    result.success = true;
+    callback (result, userp);
+}
+
+int
+answer (const std::string & callId, const char *dtmf_mode, RestCompletionCallback callback, void *userp)
+{
+    const std::string & answerXml = answer_call_xml (dtmf_mode);
+    XmsSim::Instance ()->command ("answer", answerXml.size ());
+    XmsSim::Instance ()->callAnswered (callId);
+    complete (callback, userp);
+    return 0;
+}
+
+int
+hangup (const std::string & callId, RestCompletionCallback callback, void *userp)
+{
+    const std::string & hangupXml = hangup_xml ();
+    XmsSim::Instance ()->command ("hangup", hangupXml.size ());
+    XmsSim::Instance ()->callHungUp (callId);
+    complete (callback, userp);
+    return 0;
+}
+
+std::string
+play_into_conf (const std::string & conf_id, const char *audio_uri, const char *audio_type,
+                const char *base_audio_uri, const char *video_uri, const char *video_type,
+                const char *base_video_uri, const char *region, const char *repeat)
+{
+    const std::string & playXml = play_into_conf_xml (conf_id, audio_uri, audio_type, base_audio_uri, video_uri,
+                                                      video_type, base_video_uri, region, repeat);
+    XmsSim::Instance ()->command ("play_into_conf", playXml.size ());
+    return XmsSim::Instance ()->mediaStarted (conf_id, false);
+}
+
+std::string
+record_conference (const std::string & conf_id,
+                   const char *audio_uri,
+                   const char *audio_type,
+                   const char *audio_codec,
+                   const char *audio_rate,
+                   const char *video_uri,
+                   const char *video_type,
+                   const char *video_codec,
+                   const char *video_level,
+                   const char *video_height, const char *video_width, const char *video_maxbitrate, const char * video_framerate, const char *record_time)
+{
+    const std::string & recordXml = record_conf_xml (conf_id, audio_uri, audio_type, audio_codec, audio_rate,
+                                                     video_uri, video_type, video_codec, video_level,
+                                                     video_height, video_width, video_maxbitrate, video_framerate,
+                                                     record_time);
+    XmsSim::Instance ()->command ("record_conference", recordXml.size ());
+    return XmsSim::Instance ()->mediaStarted (conf_id, true);
+}
+
+int
+stop (const std::string & confId, const std::string & transactionId, RestCompletionCallback callback, void *userp)
+{
+    const std::string & stopXml = stop_xml (transactionId);
+    XmsSim::Instance ()->command ("stop", stopXml.size ());
+    XmsSim::Instance ()->mediaStopped (confId, transactionId);
+    complete (callback, userp);
+    return 0;
+}
+
+std::string
+create_conference (const char *reserve, const char *max_parties, const char *layout,
+                   const char *layout_size)
+{
+    const std::string & createConfXml = create_conference_xml (reserve, max_parties, layout, layout_size);
+    XmsSim::Instance ()->command ("create_conference", createConfXml.size ());
+    return XmsSim::Instance ()->newConference ();
+}
+
+int
+destroy_conference (const std::string & conf_id, RestCompletionCallback callback, void *userp)
+{
+    XmsSim::Instance ()->command ("destroy_conference", 0);
+    XmsSim::Instance ()->conferenceDestroyed (conf_id);
+    complete (callback, userp);
+    return 0;
+}
+
+int
+add_party (const std::string & call_id, const std::string & conf_id, const char *region, RestCompletionCallback callback, void *userp)
+{
+    const std::string & addPartyXml = add_party_xml (conf_id, region);
+    XmsSim::Instance ()->command ("add_party", addPartyXml.size ());
+    complete (callback, userp);
+    return 0;
+}
+
+int
+update_party (const std::string & call_id, const char *audio, const char *video, const char *region,
+              RestCompletionCallback callback, void *userp)
+{
+    const std::string & updatePartyXml = update_party_xml (audio, video, region);
+    XmsSim::Instance ()->command ("update_party", updatePartyXml.size ());
+    complete (callback, userp);
+    return 0;
+}
+
+int
+update_conference (const std::string & conf_id, const char *layout_size, const char *layout_regions, const char *region_overlays,
+                   RestCompletionCallback callback, void *userp)
+{
+    const std::string & updateConfXml = update_conference_xml (layout_regions, layout_size, region_overlays);
+    XmsSim::Instance ()->command ("update_conference", updateConfXml.size ());
+    if (region_overlays)
+        XmsSim::Instance ()->overlaysSent (conf_id, region_overlays);
+    complete (callback, userp);
+    return 0;
+}
+
+int
+update_play (const char *media_id, const char *action, const char *region)
+{
+    return 0;
+}
+
+int
+send_info (const std::string & call_id, const char *content_type, const char *content)
+{
+    return 0;
+}
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
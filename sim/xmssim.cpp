@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <stdio.h>
+#include <time.h>
+
+#include "xmssim.h"
+#include "xmseventparser.h"
+#include "conferencemanager.h"
+
+/*----------------------------------------------------------------------------*/
+
+XmsSim *
+    XmsSim::pInstance_ = NULL;
+
+/*
+ * ctor
+ */
+XmsSim::XmsSim ()
+{
+    reset (1);
+}
+
+void
+XmsSim::reset (uint64_t seed)
+{
+    random_.setSeed (seed);
+    nowUs_ = 0;
+    sequence_ = 0;
+    nextId_ = 0;
+    handlerNs_ = 0;
+    while (!queue_.empty ())
+        queue_.pop ();
+    live_.clear ();
+    media_.clear ();
+    slides_.clear ();
+    counters_.clear ();
+}
+
+std::string
+XmsSim::event (const char *type, const char *resourceType, const std::string & resourceId)
+{
+    return std::string ("<web_service version=\"1.0\"><event type=\"") + type + "\" resource_type=\"" + resourceType +
+        "\" resource_id=\"" + resourceId + "\">";
+}
+
+std::string
+XmsSim::eventData (const char *name, const std::string & value)
+{
+    return std::string ("<event_data name=\"") + name + "\" value=\"" + value + "\"/>";
+}
+
+std::string
+XmsSim::endEvent ()
+{
+    return "</event></web_service>";
+}
+
+std::string
+XmsSim::newId (const char *prefix)
+{
+    char id[32];
+    snprintf (id, sizeof (id), "%s%lu", prefix, ++nextId_);
+    return id;
+}
+
+void
+XmsSim::post (uint64_t atUs, const std::string & xml, const std::string & requires)
+{
+    Pending pending;
+    pending.atUs = atUs;
+    pending.sequence = sequence_++;
+    pending.xml = xml;
+    pending.requires = requires;
+    queue_.push (pending);
+}
+
+unsigned long
+XmsSim::run (ConferenceManager & conferences, uint64_t untilUs)
+{
+    unsigned long delivered = 0;
+    while (!queue_.empty () && queue_.top ().atUs <= untilUs)
+    {
+        Pending pending = queue_.top ();
+        queue_.pop ();
+        nowUs_ = pending.atUs;
+        if (!pending.requires.empty () && !live_.count (pending.requires))
+            continue;
+
+        xmsEventParser event (pending.xml.data (), pending.xml.size ());
+        const std::string & type = event.getEventType ();
+        // Whatever ends here is gone before the app hears of it, so
+        // anything still queued against it is dropped
+        if (type == "incoming")
+            live_.insert (event.findValByKey ("call_id"));
+        else if (type == "hangup")
+            live_.erase (event.findValByKey ("call_id"));
+        else if (type == "end_play" || type == "end_record")
+        {
+            std::string transactionId = event.findValByKey ("transaction_id");
+            live_.erase (transactionId);
+            std::pair < std::multimap < std::string, std::string >::iterator,
+                std::multimap < std::string, std::string >::iterator > range =
+                media_.equal_range (event.getResourceId ());
+            for (std::multimap < std::string, std::string >::iterator media_iterator = range.first;
+                 media_iterator != range.second; media_iterator++)
+            {
+                if (media_iterator->second == transactionId)
+                {
+                    media_.erase (media_iterator);
+                    break;
+                }
+            }
+        }
+
+        struct timespec start, end;
+        clock_gettime (CLOCK_MONOTONIC, &start);
+        conferences.onEvent (&event);
+        clock_gettime (CLOCK_MONOTONIC, &end);
+        handlerNs_ += (end.tv_sec - start.tv_sec) * 1000000000ULL + end.tv_nsec - start.tv_nsec;
+        delivered++;
+    }
+    return delivered;
+}
+
+void
+XmsSim::command (const char *operation, size_t bytes)
+{
+    Counter & counter = counters_[operation];
+    counter.count++;
+    counter.bytes += bytes;
+}
+
+std::string
+XmsSim::newConference ()
+{
+    std::string confId = newId ("simconf-");
+    live_.insert (confId);
+    return confId;
+}
+
+void
+XmsSim::conferenceDestroyed (const std::string & confId)
+{
+    // Its plays, records and slide show go with it
+    live_.erase (confId);
+    std::pair < std::multimap < std::string, std::string >::iterator,
+        std::multimap < std::string, std::string >::iterator > range = media_.equal_range (confId);
+    for (std::multimap < std::string, std::string >::iterator media_iterator = range.first;
+         media_iterator != range.second; media_iterator++)
+        live_.erase (media_iterator->second);
+    media_.erase (range.first, range.second);
+    std::map < std::string, std::string >::iterator slide_iterator = slides_.find (confId);
+    if (slide_iterator != slides_.end ())
+    {
+        live_.erase (slide_iterator->second);
+        slides_.erase (slide_iterator);
+    }
+}
+
+void
+XmsSim::callAnswered (const std::string & callId)
+{
+    post (nowUs_ + ROUND_TRIP_US, event ("answered", "call", callId) + eventData ("call_id", callId) + endEvent (),
+          callId);
+}
+
+void
+XmsSim::callHungUp (const std::string & callId)
+{
+    post (nowUs_ + ROUND_TRIP_US, event ("hangup", "call", callId) + eventData ("call_id", callId) + endEvent (),
+          callId);
+}
+
+void
+XmsSim::endMedia (const std::string & confId, const std::string & transactionId, uint64_t atUs)
+{
+    const char *type = transactionId.compare (0, 7, "simrec-") == 0 ? "end_record" : "end_play";
+    post (atUs, event (type, "conference", confId) + eventData ("transaction_id", transactionId) + endEvent (),
+          transactionId);
+}
+
+std::string
+XmsSim::mediaStarted (const std::string & confId, bool record)
+{
+    std::string transactionId = newId (record ? "simrec-" : "simplay-");
+    live_.insert (transactionId);
+    media_.insert (std::make_pair (confId, transactionId));
+    endMedia (confId, transactionId, nowUs_ + (record ? RECORD_US : PLAY_US));
+    return transactionId;
+}
+
+void
+XmsSim::mediaStopped (const std::string & confId, const std::string & transactionId)
+{
+    // The end event comes early; the one queued for the natural end is
+    // dropped, as the first to arrive ends the transaction
+    if (live_.count (transactionId))
+        endMedia (confId, transactionId, nowUs_ + ROUND_TRIP_US);
+}
+
+void
+XmsSim::overlaysSent (const std::string & confId, const std::string & overlays)
+{
+    // Only the slide show has overlays that expire and want a reply
+    std::string::size_type start = 0;
+    while (start < overlays.size ())
+    {
+        std::string::size_type end = overlays.find (';', start);
+        if (end == std::string::npos)
+            end = overlays.size ();
+        std::string overlay = overlays.substr (start, end - start);
+        start = end + 1;
+        if (overlay.find ("overlay_id=slideshow_overlay") == std::string::npos)
+            continue;
+
+        std::map < std::string, std::string >::iterator slide_iterator = slides_.find (confId);
+        if (slide_iterator != slides_.end ())
+        {
+            live_.erase (slide_iterator->second);
+            slides_.erase (slide_iterator);
+        }
+        std::string::size_type content = overlay.find ("content_id=slide");
+        if (content == std::string::npos)
+            continue;           // taken down
+
+        std::string slide = overlay.substr (content + 11, overlay.find (',', content) - content - 11);
+        std::string showId = newId ("simslide-");
+        live_.insert (showId);
+        slides_[confId] = showId;
+        post (nowUs_ + SLIDE_US, event ("conf_overlay_expired", "conference", confId) + eventData ("content_id", slide) +
+              endEvent (), showId);
+    }
+}
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
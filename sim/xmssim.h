@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+#ifndef _XMSSIM_H
+#define _XMSSIM_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <queue>
+
+/*----------------------------------------------------------------------------*/
+
+class ConferenceManager;
+
+/*!
+ * \class SimRandom
+ * xorshift64*. The same seed gives the same scenario on every platform,
+ * which rand () does not.
+ */
+class SimRandom
+{
+  public:
+    explicit SimRandom (uint64_t seed = 1)
+    {
+        setSeed (seed);
+    }
+
+    void setSeed (uint64_t seed)
+    {
+        state_ = seed ? seed : 0x9E3779B97F4A7C15ULL;
+    }
+
+    uint64_t next ()
+    {
+        state_ ^= state_ >> 12;
+        state_ ^= state_ << 25;
+        state_ ^= state_ >> 27;
+        return state_ * 2685821657736338717ULL;
+    }
+
+    // Uniform in [0, bound)
+    uint64_t below (uint64_t bound)
+    {
+        return bound ? next () % bound : 0;
+    }
+
+  private:
+    uint64_t state_;
+};
+
+/*!
+ * \class XmsSim
+ * In-process stand-in for XMS, for running the conference logic without
+ * threads, sockets or a real clock.
+ *
+ * Events wait in a queue ordered by virtual time and are handed straight
+ * to a ConferenceManager; time jumps from one event to the next. The REST
+ * commands the conferences issue go to the recording fake in
+ * simdispatch.cpp instead of dispatchxmscmd.cpp. It counts them, and
+ * answers the way XMS would by queueing the events that follow: answered
+ * after answer, hangup after hangup, end_play when a play runs out or is
+ * stopped, conf_overlay_expired for each slide.
+ *
+ * An event can be queued on condition that some resource (a call, a
+ * conference, a play) is still live when its time comes, so a caller's
+ * later DTMF is dropped if the app has hung the call up meanwhile.
+ *
+ * The class is a singleton, as the fake dispatch functions need to find it.
+ */
+class XmsSim
+{
+  public:
+    static XmsSim *Instance ()
+    {
+        if (!pInstance_)
+            pInstance_ = new XmsSim;
+
+        return pInstance_;
+    }
+
+    // What XMS takes to answer a command with an event
+    static const uint64_t ROUND_TRIP_US = 2000;
+    static const uint64_t PLAY_US = 20000000;
+    static const uint64_t RECORD_US = 60000000;
+    // Each slide is shown for img_duration=5s
+    static const uint64_t SLIDE_US = 5000000;
+
+    struct Counter
+    {
+        Counter ():count (0), bytes (0)
+        {
+        }
+        unsigned long count;
+        unsigned long bytes;
+    };
+
+    typedef std::map < std::string, Counter > Counters;
+
+    /*!
+     * Empty queue, clock at 0, no counts.
+     */
+    void reset (uint64_t seed);
+
+    uint64_t now () const
+    {
+        return nowUs_;
+    }
+
+    SimRandom & random ()
+    {
+        return random_;
+    }
+
+    /*!
+     * Queue an event for atUs, to be delivered only if requires is empty
+     * or still live then.
+     */
+    void post (uint64_t atUs, const std::string & xml, const std::string & requires = std::string ());
+
+    /*!
+     * Deliver queued events in time order up to untilUs. Returns the
+     * number delivered.
+     */
+    unsigned long run (ConferenceManager & conferences, uint64_t untilUs);
+
+    /*!
+     * Time spent in ConferenceManager::onEvent, in nanoseconds.
+     */
+    uint64_t handlerNs () const
+    {
+        return handlerNs_;
+    }
+
+    const Counters & counters () const
+    {
+        return counters_;
+    }
+
+    // The fake REST dispatch
+    void command (const char *operation, size_t bytes);
+    std::string newConference ();
+    void conferenceDestroyed (const std::string & confId);
+    void callAnswered (const std::string & callId);
+    void callHungUp (const std::string & callId);
+    std::string mediaStarted (const std::string & confId, bool record);
+    void mediaStopped (const std::string & confId, const std::string & transactionId);
+    void overlaysSent (const std::string & confId, const std::string & overlays);
+
+    // Event XML, as XMS formats it
+    static std::string event (const char *type, const char *resourceType, const std::string & resourceId);
+    static std::string eventData (const char *name, const std::string & value);
+    static std::string endEvent ();
+
+  private:
+    XmsSim ();
+    XmsSim (const XmsSim &);
+    XmsSim & operator = (const XmsSim &);
+
+    struct Pending
+    {
+        uint64_t atUs;
+        uint64_t sequence;      // keeps events due together in posting order
+        std::string xml;
+        std::string requires;
+
+        bool operator > (const Pending & other) const
+        {
+            return atUs != other.atUs ? atUs > other.atUs : sequence > other.sequence;
+        }
+    };
+
+    std::string newId (const char *prefix);
+    void endMedia (const std::string & confId, const std::string & transactionId, uint64_t atUs);
+
+    static XmsSim *pInstance_;
+
+    SimRandom random_;
+    uint64_t nowUs_;
+    uint64_t sequence_;
+    unsigned long nextId_;
+    uint64_t handlerNs_;
+    std::priority_queue < Pending, std::vector < Pending >, std::greater < Pending > >queue_;
+    std::set < std::string > live_;
+    std::multimap < std::string, std::string > media_;      // conference ID -> transaction IDs
+    std::map < std::string, std::string > slides_;          // conference ID -> its slide show
+    Counters counters_;
+};
+
+#endif // _XMSSIM_H
+/* vim:ts=4:set nu:
+ * EOF
+ */
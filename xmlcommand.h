@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+#ifndef _XMLCOMMAND_H
+#define _XMLCOMMAND_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <string.h>
+#include <string>
+
+/*----------------------------------------------------------------------------*/
+
+// class XmlCommand - builds one XMS REST command body.
+//
+// Each thread has one command buffer, reused for every command it builds,
+// so once it has grown to the largest command there is no allocation at
+// all.  Markup is appended as is; attribute values are escaped.  An
+// attribute whose value is NULL is skipped by an inline test, so optional
+// attributes cost nothing when absent.
+//
+// The result is valid until the same thread starts its next command. It is
+// passed by reference all the way to RestDispatcher::submit(), where it is
+// copied once into the queued request that cURL sends from.
+
+class XmlCommand
+{
+  public:
+    /*!
+     * The calling thread's buffer, emptied and started with markup.
+     */
+    static XmlCommand & start (const char *markup)
+    {
+        if (!threadCommand_)
+        {
+            // Lives as long as the thread; a handful of threads ever build
+            threadCommand_ = new XmlCommand;
+            threadCommand_->buffer_.reserve (INITIAL_CAPACITY);
+        }
+        threadCommand_->buffer_.clear ();
+        threadCommand_->buffer_ += markup;
+        return *threadCommand_;
+    }
+
+    XmlCommand & raw (const char *markup)
+    {
+        buffer_ += markup;
+        return *this;
+    }
+
+    // Append ' name="value"'
+    XmlCommand & attr (const char *name, const char *value)
+    {
+        if (value)
+            appendAttr (name, value, strlen (value));
+        return *this;
+    }
+
+    XmlCommand & attr (const char *name, const std::string & value)
+    {
+        appendAttr (name, value.data (), value.size ());
+        return *this;
+    }
+
+    const std::string & str () const
+    {
+        return buffer_;
+    }
+
+  private:
+    static const size_t INITIAL_CAPACITY = 1024;
+
+    XmlCommand ()
+    {
+    }
+
+    XmlCommand (const XmlCommand &);
+    XmlCommand & operator = (const XmlCommand &);
+
+    void appendAttr (const char *name, const char *value, size_t length)
+    {
+        buffer_ += ' ';
+        buffer_ += name;
+        buffer_ += "=\"";
+        appendEscaped (value, length);
+        buffer_ += '"';
+    }
+
+    void appendEscaped (const char *value, size_t length)
+    {
+        const char *end = value + length;
+        while (value < end)
+        {
+            // Copy the run up to the next character that needs escaping
+            const char *run = value;
+            while (value < end && *value != '&' && *value != '<' && *value != '>' && *value != '"' && *value != '\'')
+                value++;
+            buffer_.append (run, value - run);
+            if (value == end)
+                break;
+            switch (*value++)
+            {
+            case '&':
+                buffer_ += "&amp;";
+                break;
+            case '<':
+                buffer_ += "&lt;";
+                break;
+            case '>':
+                buffer_ += "&gt;";
+                break;
+            case '"':
+                buffer_ += "&quot;";
+                break;
+            default:
+                buffer_ += "&apos;";
+                break;
+            }
+        }
+    }
+
+    static __thread XmlCommand *threadCommand_;
+
+    std::string buffer_;
+};
+
+#endif // _XMLCOMMAND_H
+/* vim:ts=4:set nu:
+ * EOF
+ */
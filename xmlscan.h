@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+#ifndef _XMLSCAN_H
+#define _XMLSCAN_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <string.h>
+#include <string>
+
+/*----------------------------------------------------------------------------*/
+
+// A minimal forward scanner for the small, flat XML documents XMS sends:
+// start tags with attributes, nothing else of interest.  Everything points
+// into the caller's buffer; nothing is copied until XmlSlice::str().
+// Anything the scanner does not understand is reported as malformed so the
+// caller can fall back to the Xerces DOM.
+
+/*!
+ * \struct XmlSlice
+ * A pointer/length view of part of an XML buffer.
+ */
+struct XmlSlice
+{
+    const char *ptr;
+    size_t len;
+
+    bool equals (const char *s) const
+    {
+        return strlen (s) == len && memcmp (ptr, s, len) == 0;
+    }
+
+    // Copy out, decoding the predefined XML entities
+    std::string str () const
+    {
+        // An empty slice may have no buffer behind it at all
+        if (len == 0)
+            return std::string ();
+        if (!memchr (ptr, '&', len))
+            return std::string (ptr, len);
+
+        static const struct
+        {
+            const char *entity;
+            size_t length;
+            char c;
+        } entities[] =
+        {
+            {"&amp;", 5, '&'}, {"&lt;", 4, '<'}, {"&gt;", 4, '>'}, {"&quot;", 6, '"'}, {"&apos;", 6, '\''}
+        };
+        std::string out;
+        out.reserve (len);
+        for (size_t i = 0; i < len; i++)
+        {
+            bool decoded = false;
+            if (ptr[i] == '&')
+            {
+                for (size_t e = 0; e < sizeof (entities) / sizeof (entities[0]); e++)
+                {
+                    if (len - i >= entities[e].length && memcmp (ptr + i, entities[e].entity, entities[e].length) == 0)
+                    {
+                        out += entities[e].c;
+                        i += entities[e].length - 1;
+                        decoded = true;
+                        break;
+                    }
+                }
+            }
+            if (!decoded)
+                out += ptr[i];
+        }
+        return out;
+    }
+};
+
+enum XmlScanResult
+{ XML_SCAN_MALFORMED = -1, XML_SCAN_END = 0, XML_SCAN_OK = 1 };
+
+inline bool
+xmlIsSpace (char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/*!
+ * Find the next start tag called name in [pos, end).  Returns a pointer just
+ * past the tag name, ready for xmlNextAttribute(), or NULL if there is none.
+ * A tag whose name only starts with name (event_data for event) is skipped.
+ */
+inline const char *
+xmlFindTag (const char *pos, const char *end, const char *name)
+{
+    size_t nameLen = strlen (name);
+    while (pos < end)
+    {
+        const char *lt = (const char *) memchr (pos, '<', end - pos);
+        if (!lt || (size_t) (end - lt) < nameLen + 2)
+            return NULL;
+        const char *after = lt + 1 + nameLen;
+        if (memcmp (lt + 1, name, nameLen) == 0 && (xmlIsSpace (*after) || *after == '>' || *after == '/'))
+            return after;
+        pos = lt + 1;
+    }
+    return NULL;
+}
+
+/*!
+ * Read the next name="value" pair of the start tag at pos, advancing pos.
+ * Returns XML_SCAN_END at '>' or '/>' (pos is left just past it).
+ */
+inline XmlScanResult
+xmlNextAttribute (const char *&pos, const char *end, XmlSlice & name, XmlSlice & value)
+{
+    while (pos < end && xmlIsSpace (*pos))
+        pos++;
+    if (pos >= end)
+        return XML_SCAN_MALFORMED;
+    if (*pos == '>')
+    {
+        pos++;
+        return XML_SCAN_END;
+    }
+    if (*pos == '/')
+    {
+        if (pos + 1 < end && pos[1] == '>')
+        {
+            pos += 2;
+            return XML_SCAN_END;
+        }
+        return XML_SCAN_MALFORMED;
+    }
+
+    name.ptr = pos;
+    while (pos < end && *pos != '=' && !xmlIsSpace (*pos) && *pos != '>' && *pos != '/')
+        pos++;
+    name.len = pos - name.ptr;
+    while (pos < end && xmlIsSpace (*pos))
+        pos++;
+    if (name.len == 0 || pos >= end || *pos != '=')
+        return XML_SCAN_MALFORMED;
+    pos++;
+    while (pos < end && xmlIsSpace (*pos))
+        pos++;
+    if (pos >= end || (*pos != '"' && *pos != '\''))
+        return XML_SCAN_MALFORMED;
+
+    char quote = *pos++;
+    const char *close = (const char *) memchr (pos, quote, end - pos);
+    if (!close)
+        return XML_SCAN_MALFORMED;
+    value.ptr = pos;
+    value.len = close - pos;
+    pos = close + 1;
+    return XML_SCAN_OK;
+}
+
+/*!
+ * Look up one attribute of the start tag at pos.
+ */
+inline XmlScanResult
+xmlFindAttribute (const char *pos, const char *end, const char *attribute, XmlSlice & value)
+{
+    XmlSlice name;
+    XmlScanResult res;
+    while ((res = xmlNextAttribute (pos, end, name, value)) == XML_SCAN_OK)
+    {
+        if (name.equals (attribute))
+            return XML_SCAN_OK;
+    }
+    return res;
+}
+
+#endif // _XMLSCAN_H
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -32,41 +32,41 @@
 std::string&
 createEvhandlerXml ( );
 
-std::string
+const std::string &
 create_conference_xml (const char *reserve, const char *max_parties, const char *layout,
                        const char *layout_size);
 
-std::string
+const std::string &
 answer_call_xml (const char *dtmf_mode);
 
-std::string
+const std::string &
 update_conference_xml (const char *layout_regions, const char *layout, const char *region_overlays);
 
-std::string
-play_into_conf_xml (std::string conf_id, const char *audio_uri, const char *audio_type, const char *base_audio_uri,
+const std::string &
+play_into_conf_xml (const std::string & conf_id, const char *audio_uri, const char *audio_type, const char *base_audio_uri,
                     const char *video_uri, const char *video_type, const char *base_video_uri, const char *region,
                     const char *repeat);
 
-std::string
-record_conf_xml (std::string conf_id, const char *audio_uri, const char *audio_type,
+const std::string &
+record_conf_xml (const std::string & conf_id, const char *audio_uri, const char *audio_type,
                     const char *audio_codec, const char *audio_rate, const char *video_uri,
                     const char *video_type, const char *video_codec, const char *video_level,
                     const char *video_height, const char *video_width,
                     const char * video_maxbitrate, const char *video_framerate, const char *record_time);
 
-std::string
-stop_xml (std::string transaction_id);
+const std::string &
+stop_xml (const std::string & transaction_id);
 
 //std::string
 //modify_call_xml (const char *tx_volume, const char *rx_volume, const char *async_dtmf, const char *async_tone);
 
-std::string
-add_party_xml (std::string conf_id, const char *region);
+const std::string &
+add_party_xml (const std::string & conf_id, const char *region);
 
-std::string
+const std::string &
 update_party_xml (const char *audio, const char *video, const char *region);
 
-std::string
+const std::string &
 hangup_xml (void);
 #endif // _XMSCMDS_H
 
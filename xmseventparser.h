@@ -28,69 +28,181 @@
 #include <string>
 #include <map>
 
+#include "logger.h"
+#include "xmlscan.h"
 #include "XmlDomDocument.h"
 /*----------------------------------------------------------------------------*/
 
-// class xmsEventParse - parse an XMS REST event, producing an STL map containing 
-// all name/value pairs for a single event received from XMS
+// class xmsEventParse - parse an XMS REST event into its type and the
+// name/value pairs of its event_data elements.
+//
+// XMS events are always the same flat shape:
+//   <web_service><event type="..."><event_data name="..." value="..."/>...
+// so they are tokenized in one pass with xmlscan.h, keeping pointer/length
+// slices into the caller's buffer.  The buffer must outlive the parser.
+// Nothing is copied until a value is looked up.  An event the tokenizer
+// does not understand goes through the Xerces DOM, as before.
 
 class xmsEventParser
 {
   public:
+    // More than this and the event goes to the DOM fallback
+    static const int MAX_EVENT_DATA = 32;
+
     // ctor
-    xmsEventParser (std::string eventXml)
+    xmsEventParser (const char *eventXml, size_t length)
     {
-        std::string evtype;
-        //std::cout << "Before doc creation " << evString << std::endl;
-        doc_ = new XmlDomDocument (eventXml);
-        if (doc_)
-        {
-            eventType_ = doc_->getAttribute ("event", 0, "type");
-            LOGDEBUG ("Event type - " << eventType_);
-            std::string key;
-            std::string value;
-            for (int i = 0; i < doc_->getChildCount ("event", 0, "event_data"); i++)
-            {
-                key = doc_->getChildAttribute ("event", 0, "event_data", i, "name");
-                value = doc_->getChildAttribute ("event", 0, "event_data", i, "value");
-                //LOGDEBUG ("event data " << i + 1 << " name -  " << key.c_str () << " value - " << value.c_str ());
-
-                xmsEvent_[key] = value;
-            }
-
-            //LOGDEBUG ("Map size: " << xmsEvent_.size ());
-            //for (map < std::string, std::string >::iterator ii = xmsEvent_.begin (); ii != xmsEvent_.end (); ++ii)
-            //{
-            //    LOGDEBUG ((*ii).first << ": " << (*ii).second);
-            //}
-        }
-        else
-        {
-            LOGERROR ("Invalid event XML. Cannot parse");
-        }
+        parse (eventXml, length);
+    }
 
+    xmsEventParser (const std::string & eventXml)
+    {
+        parse (eventXml.data (), eventXml.size ());
     }
 
      //dtor.
     ~xmsEventParser ()
     {
-        delete doc_;
     };
 
-    std::string & findValByKey (std::string key)
+    // Value of the event_data named key, or empty if there is none
+    std::string findValByKey (const char *key) const
     {
-        return xmsEvent_[key];
+        if (useDom_)
+        {
+            std::map < std::string, std::string >::const_iterator ii = xmsEvent_.find (key);
+            return ii != xmsEvent_.end ()? ii->second : std::string ();
+        }
+        for (int i = 0; i < dataCount_; i++)
+        {
+            if (names_[i].equals (key))
+                return values_[i].str ();
+        }
+        return std::string ();
     }
 
-    std::string & getEventType (void)
+    const std::string & getEventType (void) const
     {
         return eventType_;
     }
 
+    // The call or conference the event is about
+    const std::string & getResourceId (void) const
+    {
+        return resourceId_;
+    }
+
+    // "call", "conference" or empty
+    const std::string & getResourceType (void) const
+    {
+        return resourceType_;
+    }
+
   private:
+    xmsEventParser (const xmsEventParser &);
+    xmsEventParser & operator = (const xmsEventParser &);
+
+    void parse (const char *eventXml, size_t length)
+    {
+        dataCount_ = 0;
+        useDom_ = false;
+        if (!tokenize (eventXml, eventXml + length))
+        {
+            LOGDEBUG ("Event not tokenized. Parsing with DOM");
+            dataCount_ = 0;
+            useDom_ = true;
+            parseDom (std::string (eventXml, length));
+        }
+        LOGDEBUG ("Event type - " << eventType_);
+    }
+
+    bool tokenize (const char *pos, const char *end)
+    {
+        XmlSlice name;
+        XmlSlice value;
+        XmlScanResult res;
+
+        pos = xmlFindTag (pos, end, "event");
+        if (!pos)
+            return false;
+        bool haveType = false;
+        while ((res = xmlNextAttribute (pos, end, name, value)) == XML_SCAN_OK)
+        {
+            if (name.equals ("type"))
+            {
+                eventType_ = value.str ();
+                haveType = true;
+            }
+            else if (name.equals ("resource_id"))
+                resourceId_ = value.str ();
+            else if (name.equals ("resource_type"))
+                resourceType_ = value.str ();
+        }
+        if (res == XML_SCAN_MALFORMED || !haveType)
+            return false;
+        // <event .../> has no data
+        if (pos[-2] == '/')
+            return true;
+
+        // event_data elements up to </event>. Anything else inside, like
+        // nested content, is more than the tokenizer handles
+        const char *close = (const char *) memmem (pos, end - pos, "</event>", 8);
+        if (!close)
+            return false;
+        while ((pos = xmlFindTag (pos, close, "event_data")) != NULL)
+        {
+            if (dataCount_ == MAX_EVENT_DATA)
+                return false;
+            XmlSlice & dataName = names_[dataCount_];
+            XmlSlice & dataValue = values_[dataCount_];
+            dataName.len = 0;
+            dataValue.ptr = "";
+            dataValue.len = 0;
+            while ((res = xmlNextAttribute (pos, close, name, value)) == XML_SCAN_OK)
+            {
+                if (name.equals ("name"))
+                    dataName = value;
+                else if (name.equals ("value"))
+                    dataValue = value;
+            }
+            if (res == XML_SCAN_MALFORMED || dataName.len == 0)
+                return false;
+            // <event_data> with children is not the flat shape
+            if (pos[-2] != '/')
+                return false;
+            dataCount_++;
+        }
+        return true;
+    }
+
+    void parseDom (std::string eventXml)
+    {
+        XmlDomDocument doc (eventXml);
+        eventType_ = doc.getAttribute ("event", 0, "type");
+        resourceId_ = doc.getAttribute ("event", 0, "resource_id");
+        resourceType_ = doc.getAttribute ("event", 0, "resource_type");
+        std::string key;
+        std::string value;
+        for (int i = 0; i < doc.getChildCount ("event", 0, "event_data"); i++)
+        {
+            key = doc.getChildAttribute ("event", 0, "event_data", i, "name");
+            value = doc.getChildAttribute ("event", 0, "event_data", i, "value");
+            xmsEvent_[key] = value;
+        }
+    }
+
     std::string eventType_;
+    std::string resourceId_;
+    std::string resourceType_;
+    bool useDom_;
+
+    // Tokenized event_data; slices into the event buffer
+    int dataCount_;
+    XmlSlice names_[MAX_EVENT_DATA];
+    XmlSlice values_[MAX_EVENT_DATA];
+
+    // DOM fallback
     std::map < std::string, std::string > xmsEvent_;
-    XmlDomDocument *doc_;
 
 };
 #endif // _XMSEVENTPARSER_H
@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include "logger.h"
+#include "xmsnodepool.h"
+
+/*----------------------------------------------------------------------------*/
+
+XmsNodePool *
+    XmsNodePool::pInstance_ = NULL;
+
+__thread int
+    XmsNodePool::currentNode_ = -1;
+
+/*
+ * ctor
+ */
+XmsNodePool::XmsNodePool ()
+{
+    pthread_mutex_init (&lock_, NULL);
+}
+
+/*
+ * dtor
+ */
+XmsNodePool::~XmsNodePool ()
+{
+    std::vector < XmsNode * >::iterator node_iterator;
+    for (node_iterator = nodes_.begin (); node_iterator != nodes_.end (); node_iterator++)
+        delete *node_iterator;
+    pthread_mutex_destroy (&lock_);
+}
+
+void
+XmsNodePool::addNode (const std::string & addr)
+{
+    XmsNode *node = new XmsNode;
+    node->index = nodes_.size ();
+    node->addr = addr;
+    node->inRotation = false;   // until its long poll is open
+    node->eventsUp = false;
+    node->consecutiveErrors = 0;
+    node->latencyUs = 0;
+    node->requests = 0;
+    node->errors = 0;
+    node->calls = 0;
+    node->conferences = 0;
+    node->stalledRequests = 0;
+    nodes_.push_back (node);
+    LOGDEBUG ("XMS node " << node->index << " REST connection is at " << addr);
+}
+
+long
+XmsNodePool::loadScore (const XmsNode * node) const
+{
+    // Parties are what uses up media capacity; a conference costs a mixer
+    // on top of its parties.  A slow or erratic node scores as if it were
+    // carrying extra parties: one per 10ms of round trip, five per recent
+    // error and five per request it is sitting on. The latter shows a node
+    // that has stopped answering long before its requests time out.
+    return node->calls + 2 * node->conferences + node->latencyUs / 10000 +
+        5 * (node->consecutiveErrors + node->stalledRequests);
+}
+
+int
+XmsNodePool::leastLoaded ()
+{
+    int best = -1;
+    long bestScore = 0;
+    std::vector < XmsNode * >::iterator node_iterator;
+    for (node_iterator = nodes_.begin (); node_iterator != nodes_.end (); node_iterator++)
+    {
+        if (!(*node_iterator)->inRotation)
+            continue;
+        long score = loadScore (*node_iterator);
+        if (best < 0 || score < bestScore)
+        {
+            best = (*node_iterator)->index;
+            bestScore = score;
+        }
+    }
+    return best;
+}
+
+int
+XmsNodePool::placeNew ()
+{
+    int node = currentNode_;
+    pthread_mutex_lock (&lock_);
+    if (node < 0)
+        node = leastLoaded ();
+    else if (!nodes_[node]->inRotation)
+    {
+        // Its calls could not join a conference anywhere else
+        LOGWARN ("XMS node " << node << " is out of rotation. Not creating a resource for its event elsewhere");
+        node = -1;
+    }
+    pthread_mutex_unlock (&lock_);
+    return node;
+}
+
+int
+XmsNodePool::boundNode (const std::string & id)
+{
+    int node = -1;
+    pthread_mutex_lock (&lock_);
+    BindingTable::iterator binding_iterator = bindings_.find (id);
+    if (binding_iterator != bindings_.end ())
+        node = binding_iterator->second.node;
+    pthread_mutex_unlock (&lock_);
+    return node;
+}
+
+int
+XmsNodePool::nodeFor (const std::string & id)
+{
+    int node = boundNode (id);
+    if (node < 0)
+        node = currentNode_;
+    if (node < 0)
+        node = 0;
+    return node;
+}
+
+void
+XmsNodePool::bind (const std::string & id, int node, XmsResourceKind kind)
+{
+    if (id.empty () || node < 0)
+        return;
+
+    pthread_mutex_lock (&lock_);
+    std::pair < BindingTable::iterator, bool > inserted = bindings_.insert (std::make_pair (id, Binding ()));
+    if (inserted.second)
+    {
+        inserted.first->second.node = node;
+        inserted.first->second.kind = kind;
+        if (kind == XMS_CALL)
+            nodes_[node]->calls++;
+        else if (kind == XMS_CONFERENCE)
+            nodes_[node]->conferences++;
+    }
+    pthread_mutex_unlock (&lock_);
+}
+
+void
+XmsNodePool::unbind (const std::string & id)
+{
+    pthread_mutex_lock (&lock_);
+    BindingTable::iterator binding_iterator = bindings_.find (id);
+    if (binding_iterator != bindings_.end ())
+    {
+        XmsNode *node = nodes_[binding_iterator->second.node];
+        if (binding_iterator->second.kind == XMS_CALL)
+            node->calls--;
+        else if (binding_iterator->second.kind == XMS_CONFERENCE)
+            node->conferences--;
+        bindings_.erase (binding_iterator);
+    }
+    pthread_mutex_unlock (&lock_);
+}
+
+void
+XmsNodePool::recordResult (int node, long latencyUs, bool failed)
+{
+    if (node < 0 || node >= (int) nodes_.size ())
+        return;
+
+    XmsNode *xmsNode = nodes_[node];
+    pthread_mutex_lock (&lock_);
+    xmsNode->requests++;
+    // Moving average over roughly the last eight requests
+    if (xmsNode->latencyUs == 0)
+        xmsNode->latencyUs = latencyUs;
+    else
+        xmsNode->latencyUs += (latencyUs - xmsNode->latencyUs) / 8;
+
+    if (failed)
+    {
+        xmsNode->errors++;
+        if (++xmsNode->consecutiveErrors == MAX_CONSECUTIVE_ERRORS && xmsNode->inRotation)
+        {
+            LOGERROR ("XMS node " << xmsNode->addr << " failed " << MAX_CONSECUTIVE_ERRORS <<
+                      " requests in a row. Taking it out of rotation");
+            xmsNode->inRotation = false;
+        }
+    }
+    else
+    {
+        xmsNode->consecutiveErrors = 0;
+        if (!xmsNode->inRotation && xmsNode->eventsUp)
+        {
+            LOGNOTICE ("XMS node " << xmsNode->addr << " is answering again. Back in rotation");
+            xmsNode->inRotation = true;
+        }
+    }
+    pthread_mutex_unlock (&lock_);
+}
+
+void
+XmsNodePool::setStalledRequests (int node, int stalled)
+{
+    if (node < 0 || node >= (int) nodes_.size ())
+        return;
+
+    pthread_mutex_lock (&lock_);
+    if (stalled && !nodes_[node]->stalledRequests)
+        LOGWARN ("XMS node " << nodes_[node]->addr << " has requests unanswered after " << STALLED_SECS << "s");
+    nodes_[node]->stalledRequests = stalled;
+    pthread_mutex_unlock (&lock_);
+}
+
+void
+XmsNodePool::setEventsUp (int node, bool up)
+{
+    XmsNode *xmsNode = nodes_[node];
+    pthread_mutex_lock (&lock_);
+    xmsNode->eventsUp = up;
+    xmsNode->inRotation = up;
+    xmsNode->consecutiveErrors = 0;
+    pthread_mutex_unlock (&lock_);
+    if (up)
+        LOGNOTICE ("XMS node " << xmsNode->addr << " event handler is up. In rotation");
+    else
+        LOGERROR ("XMS node " << xmsNode->addr << " event handler is down. Out of rotation");
+}
+
+bool
+XmsNodePool::isInRotation (int node)
+{
+    if (node < 0 || node >= (int) nodes_.size ())
+        return false;
+
+    pthread_mutex_lock (&lock_);
+    bool inRotation = nodes_[node]->inRotation;
+    pthread_mutex_unlock (&lock_);
+    return inRotation;
+}
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2014 Dialogic Corp.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ * Alternatively see <http://www.gnu.org/licenses/>.
+ * Or see the LICENSE file included within the source tree.
+ *
+ */
+
+
+#ifndef _XMSNODEPOOL_H
+#define _XMSNODEPOOL_H
+
+/*------------------------------ Dependencies --------------------------------*/
+
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <tr1/unordered_map>
+
+/*----------------------------------------------------------------------------*/
+
+/*!
+ * Kinds of XMS resource the pool keeps track of.
+ */
+enum XmsResourceKind
+{ XMS_EVENTHANDLER, XMS_CALL, XMS_CONFERENCE };
+
+/*!
+ * \struct XmsNode
+ * One XMS server, with its event handler and its load as seen from here.
+ */
+struct XmsNode
+{
+    int index;
+    std::string addr;           // ip:port of the REST interface
+    std::string eventHandlerId;
+    pthread_t evHandlerThread;
+
+    // Guarded by the pool lock
+    bool inRotation;
+    bool eventsUp;              // long poll is open
+    int consecutiveErrors;
+    long latencyUs;             // smoothed REST round trip
+    unsigned long requests;
+    unsigned long errors;
+    int calls;
+    int conferences;
+    int stalledRequests;        // in flight longer than STALLED_SECS
+};
+
+/*!
+ * \class XmsNodePool
+ * The XMS servers this application drives. Each node has its own event
+ * handler thread and long poll; REST connections are kept per host in the
+ * shared cURL connection cache.
+ *
+ * Every call and conference is bound to the node it lives on, so commands
+ * for it go to that server. XMS can only join a call to a conference on
+ * the same server, so a conference is created on the node whose event
+ * asked for it, or not at all if that node is out of rotation. The load
+ * score only places a new resource that no event is tied to: it goes on
+ * the least loaded node in rotation.
+ *
+ * A node is taken out of rotation after MAX_CONSECUTIVE_ERRORS failed
+ * requests in a row, or when its long poll drops, and comes back on the
+ * next successful request once its long poll is open. A request that times
+ * out or cannot connect counts as failed, so a server that accepts
+ * connections but no longer answers also leaves rotation.  The class is a
+ * singleton.
+ */
+class XmsNodePool
+{
+  public:
+    static const int MAX_CONSECUTIVE_ERRORS = 3;
+
+    // A request still unanswered after this long counts against its node's
+    // load score until it completes
+    static const int STALLED_SECS = 2;
+
+    /*!
+     * dtor.
+     */
+    ~XmsNodePool ();
+
+    static XmsNodePool *Instance ()
+    {
+        if (!pInstance_)
+            pInstance_ = new XmsNodePool;
+
+        return pInstance_;
+    }
+
+    /*!
+     * Add a node. Call before any thread starts.
+     */
+    void addNode (const std::string & addr);
+
+    int size () const
+    {
+        return (int) nodes_.size ();
+    }
+
+    XmsNode *getNode (int node)
+    {
+        return nodes_[node];
+    }
+
+    /*!
+     * Node whose event the calling thread is handling, or -1.
+     */
+    static int currentNode ()
+    {
+        return currentNode_;
+    }
+
+    static void setCurrentNode (int node)
+    {
+        currentNode_ = node;
+    }
+
+    /*!
+     * Node a new resource should be created on. While handling an event,
+     * the current node, or -1 if it is out of rotation; never another
+     * node. Otherwise the least loaded node in rotation, or -1 if there is
+     * none.
+     */
+    int placeNew ();
+
+    /*!
+     * Node to send a command for resource id to.
+     */
+    int nodeFor (const std::string & id);
+
+    void bind (const std::string & id, int node, XmsResourceKind kind);
+    void unbind (const std::string & id);
+
+    /*!
+     * Node whose resource id is, or -1 if it is not bound.
+     */
+    int boundNode (const std::string & id);
+
+    /*!
+     * "http://ip:port" for the node.
+     */
+    std::string urlBase (int node) const
+    {
+        return "http://" + nodes_[node]->addr;
+    }
+
+    /*!
+     * Outcome of one REST request, from the dispatcher thread.
+     */
+    void recordResult (int node, long latencyUs, bool failed);
+
+    /*!
+     * How many of the node's requests have been in flight longer than
+     * STALLED_SECS, from the dispatcher thread.
+     */
+    void setStalledRequests (int node, int stalled);
+
+    /*!
+     * The node's long poll opened (up) or dropped.
+     */
+    void setEventsUp (int node, bool up);
+
+    bool isInRotation (int node);
+
+  private:
+    /*!
+     * ctor. Hide here as class is a singleton
+     */
+    XmsNodePool ();
+
+    struct Binding
+    {
+        int node;
+        XmsResourceKind kind;
+    };
+
+    typedef std::tr1::unordered_map < std::string, Binding > BindingTable;
+
+    long loadScore (const XmsNode * node) const;
+    int leastLoaded ();
+
+    static XmsNodePool *pInstance_;
+    static __thread int currentNode_;
+
+    std::vector < XmsNode * >nodes_;
+    pthread_mutex_t lock_;
+    BindingTable bindings_;
+};
+
+#endif // _XMSNODEPOOL_H
+
+/* vim:ts=4:set nu:
+ * EOF
+ */
@@ -26,13 +26,17 @@
 /*------------------------------ Dependencies --------------------------------*/
 
 #include <string>
-#include <map>
 
+#include "logger.h"
+#include "xmlscan.h"
 #include "XmlDomDocument.h"
 /*----------------------------------------------------------------------------*/
 
 // class xmsReplyParse - parse an XMS REST reply.
-// Each reply is different and needs unique parsing
+// Each reply is different and needs unique parsing. The fields we want are
+// all attributes of the response root or of its first play/record child,
+// so they are picked out with one scan of the reply (see xmlscan.h). A reply
+// the scanner does not recognise is parsed with the Xerces DOM instead.
 
 enum ReplyType
 { createEventhandler, createConference, playIntoConference, recordConference };
@@ -42,93 +46,111 @@ class xmsReplyParser
 {
   public:
     // ctor
-    xmsReplyParser (std::string replyXml, enum ReplyType replyType)
+    xmsReplyParser (const char *replyXml, size_t length, enum ReplyType replyType)
     {
+        parse (replyXml, length, replyType);
+    }
+
+    xmsReplyParser (const std::string & replyXml, enum ReplyType replyType)
+    {
+        parse (replyXml.data (), replyXml.size (), replyType);
+    }                           // end ctor
+
+    //dtor.
+    ~xmsReplyParser ()
+    {
+    };
+
+    const std::string & getEventhandlerHref (void) const
+    {
+        return eventhandlerHref_;
+    }
+
+    const std::string & getEventhandlerId (void) const
+    {
+        return eventhandlerId_;
+    }
+
+    const std::string & getConfId (void) const
+    {
+        return confId_;
+    }
+
+    const std::string & getMediaId (void) const
+    {
+        return mediaId_;
+    }
+
+  private:
+    xmsReplyParser (const xmsReplyParser &);
+    xmsReplyParser & operator = (const xmsReplyParser &);
+
+    void parse (const char *replyXml, size_t length, enum ReplyType replyType)
+    {
+        const char *end = replyXml + length;
+        XmlSlice first;
+        XmlSlice second;
+        const char *tag;
+
         if (replyType == createEventhandler)
         {
-            doc_ = new XmlDomDocument (replyXml);
-            if (doc_)
+            tag = xmlFindTag (replyXml, end, "eventhandler_response");
+            if (tag && xmlFindAttribute (tag, end, "href", first) == XML_SCAN_OK
+                && xmlFindAttribute (tag, end, "identifier", second) == XML_SCAN_OK)
             {
-                eventhandlerHref_ = doc_->getAttribute ("eventhandler_response", 0, "href");
-                eventhandlerId_ = doc_->getAttribute ("eventhandler_response", 0, "identifier");
+                eventhandlerHref_ = first.str ();
+                eventhandlerId_ = second.str ();
             }
             else
             {
-                LOGERROR ("Invalid XML on reply to create event handler. Cannot parse");
+                LOGDEBUG ("Event handler reply not scanned. Parsing with DOM");
+                std::string xml (replyXml, length);
+                XmlDomDocument doc (xml);
+                eventhandlerHref_ = doc.getAttribute ("eventhandler_response", 0, "href");
+                eventhandlerId_ = doc.getAttribute ("eventhandler_response", 0, "identifier");
             }
         }
         else if (replyType == createConference)
         {
-            doc_ = new XmlDomDocument (replyXml);
-            if (doc_)
+            tag = xmlFindTag (replyXml, end, "conference_response");
+            if (tag && xmlFindAttribute (tag, end, "identifier", first) == XML_SCAN_OK)
             {
-                confId_ = doc_->getAttribute ("conference_response", 0, "identifier");
+                confId_ = first.str ();
             }
             else
             {
-                LOGERROR ("Invalid XML on reply to create conference. Cannot parse");
+                LOGDEBUG ("Create conference reply not scanned. Parsing with DOM");
+                std::string xml (replyXml, length);
+                XmlDomDocument doc (xml);
+                confId_ = doc.getAttribute ("conference_response", 0, "identifier");
             }
         }
-        else if (replyType == playIntoConference)
+        else if (replyType == playIntoConference || replyType == recordConference)
         {
-            doc_ = new XmlDomDocument (replyXml);
-            if (doc_)
+            const char *child = (replyType == playIntoConference) ? "play" : "record";
+            tag = xmlFindTag (replyXml, end, "conference_response");
+            if (tag)
+                tag = xmlFindTag (tag, end, child);
+            if (tag && xmlFindAttribute (tag, end, "transaction_id", first) == XML_SCAN_OK)
             {
-                mediaId_ = doc_->getChildAttribute ("conference_response", 0, "play", 0, "transaction_id");
+                mediaId_ = first.str ();
             }
             else
             {
-                LOGERROR ("Invalid XML on reply to conference play. Cannot parse");
-            }
-        }
-        else if (replyType == recordConference)
-        {
-            doc_ = new XmlDomDocument (replyXml);
-            if (doc_)
-            {
-                mediaId_ = doc_->getChildAttribute ("conference_response", 0, "record", 0, "transaction_id");
-            }
-            else
-            {
-                LOGERROR ("Invalid XML on reply to conference record. Cannot parse");
+                LOGDEBUG ("Conference " << child << " reply not scanned. Parsing with DOM");
+                std::string xml (replyXml, length);
+                XmlDomDocument doc (xml);
+                mediaId_ = doc.getChildAttribute ("conference_response", 0, child, 0, "transaction_id");
             }
         }
         else
         {
             LOGERROR ("Invlaid reply type - " << replyType);
         }
-    }                           // end ctor
-
-    //dtor.
-    ~xmsReplyParser ()
-    {
-        delete doc_;
-    };
-
-    std::string getEventhandlerHref (void)
-    {
-        return eventhandlerHref_;
-    }
-
-    std::string getEventhandlerId (void)
-    {
-        return eventhandlerId_;
-    }
-
-    std::string getConfId (void)
-    {
-        return confId_;
     }
 
-    std::string getMediaId (void)
-    {
-        return mediaId_;
-    }
-
-  private:
     std::string eventhandlerHref_;
     std::string eventhandlerId_;
-    XmlDomDocument *doc_;
     std::string confId_;
     std::string mediaId_;
 